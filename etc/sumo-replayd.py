@@ -0,0 +1,384 @@
+#!/usr/bin/env python
+
+#
+# sumo-replayd.py -- serves recorded SUMO vehicle traces to TraCI clients
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+#
+
+"""
+Replays a vehicle trace recorded by TraCIScenarioManager (parameter
+traceFile) to a TraCIScenarioManager, so that coupled simulations can be
+run, tested and benchmarked without SUMO.
+
+The daemon implements the part of the TraCI protocol (API version 2) that
+TraCIScenarioManager uses: version and network boundary queries, vehicle
+and simulation variable subscriptions, and simulation steps. Commands that
+change the road traffic (setting a vehicle's speed, traffic lights,
+polygons, ...) are acknowledged but have no effect on the replay.
+
+Each client connection replays the trace from the beginning. The trace is
+a text file of the form
+
+bounds <x1> <y1> <x2> <y2>
+<time in ms> <vehicle id> <x> <y> <road id> <speed> <angle>
+...
+"""
+
+import sys
+import socket
+import struct
+import logging
+from optparse import OptionParser
+
+_API_VERSION = 2
+_REPLAYD_VERSION = 'sumo-replayd.py 1.00'
+
+CMD_GETVERSION = 0x00
+CMD_SIMSTEP2 = 0x02
+CMD_CLOSE = 0x7F
+CMD_GET_SIM_VARIABLE = 0xab
+RESPONSE_GET_SIM_VARIABLE = 0xbb
+CMD_SUBSCRIBE_VEHICLE_VARIABLE = 0xd4
+RESPONSE_SUBSCRIBE_VEHICLE_VARIABLE = 0xe4
+CMD_SUBSCRIBE_SIM_VARIABLE = 0xdb
+RESPONSE_SUBSCRIBE_SIM_VARIABLE = 0xeb
+
+POSITION_2D = 0x01
+TYPE_BOUNDINGBOX = 0x05
+TYPE_INTEGER = 0x09
+TYPE_DOUBLE = 0x0B
+TYPE_STRING = 0x0C
+TYPE_STRINGLIST = 0x0E
+
+RTYPE_OK = 0x00
+RTYPE_NOTIMPLEMENTED = 0x01
+RTYPE_ERR = 0xFF
+
+ID_LIST = 0x00
+VAR_SPEED = 0x40
+VAR_POSITION = 0x42
+VAR_ANGLE = 0x43
+VAR_ROAD_ID = 0x50
+VAR_TIME_STEP = 0x70
+VAR_DEPARTED_VEHICLES_IDS = 0x74
+VAR_ARRIVED_VEHICLES_IDS = 0x7a
+VAR_NET_BOUNDING_BOX = 0x7c
+
+
+class Trace:
+    """
+    Vehicle states by time step, as read from a trace file
+    """
+
+    def __init__(self, filename):
+        self.bounds = (0.0, 0.0, 0.0, 0.0)
+        self.steps = {}
+        for line in open(filename):
+            fields = line.split()
+            if not fields or fields[0].startswith('#'):
+                continue
+            if fields[0] == 'bounds':
+                self.bounds = tuple([float(f) for f in fields[1:5]])
+                continue
+            t = int(fields[0])
+            vehicle = (fields[1], float(fields[2]), float(fields[3]), fields[4], float(fields[5]), float(fields[6]))
+            self.steps.setdefault(t, []).append(vehicle)
+        self.times = sorted(self.steps.keys())
+
+        # vehicles recorded at time t are present until t + stepLength
+        self.stepLength = 1000
+        gaps = [b - a for (a, b) in zip(self.times, self.times[1:])]
+        if gaps:
+            self.stepLength = min(gaps)
+
+        logging.info("Read %d time steps of %d ms from %s" % (len(self.times), self.stepLength, filename))
+
+    def vehiclesAt(self, t, index):
+        """
+        Returns the vehicles present at time t and the index of the step they
+        were recorded at; index is where to start searching (times only grow)
+        """
+        while index + 1 < len(self.times) and self.times[index + 1] <= t:
+            index += 1
+        if index < len(self.times) and self.times[index] <= t < self.times[index] + self.stepLength:
+            return (self.steps[self.times[index]], index)
+        return ([], index)
+
+
+class Storage:
+    """
+    Reads and writes values in TraCI byte order
+    """
+
+    def __init__(self, data=b''):
+        self.data = data
+        self.pos = 0
+
+    def eof(self):
+        return self.pos >= len(self.data)
+
+    def read(self, fmt):
+        values = struct.unpack_from('!' + fmt, self.data, self.pos)
+        self.pos += struct.calcsize('!' + fmt)
+        return values
+
+    def readUByte(self):
+        return self.read('B')[0]
+
+    def readInt(self):
+        return self.read('i')[0]
+
+    def readString(self):
+        length = self.readInt()
+        s = self.data[self.pos:self.pos + length]
+        self.pos += length
+        return s.decode('latin-1')
+
+
+def packString(s):
+    s = s.encode('latin-1')
+    return struct.pack('!i', len(s)) + s
+
+
+def packStringList(l):
+    return struct.pack('!Bi', TYPE_STRINGLIST, len(l)) + b''.join([packString(s) for s in l])
+
+
+def packCommand(commandId, content):
+    if len(content) + 2 <= 255:
+        return struct.pack('!BB', len(content) + 2, commandId) + content
+    return struct.pack('!BiB', 0, len(content) + 6, commandId) + content
+
+
+def packStatus(commandId, result=RTYPE_OK, description=''):
+    return packCommand(commandId, struct.pack('!B', result) + packString(description))
+
+
+def packSubscriptionResult(responseId, objectId, variables):
+    """
+    Subscription results always use the extended length field
+    """
+    content = struct.pack('!B', responseId) + packString(objectId) + struct.pack('!B', len(variables)) + b''.join(variables)
+    return struct.pack('!Bi', 0, len(content) + 5) + content
+
+
+class ReplaySession:
+    """
+    Serves one client connection
+    """
+
+    def __init__(self, trace, conn):
+        self.trace = trace
+        self.conn = conn
+        self.time = 0
+        self.index = 0
+        self.vehicles = {}
+        self.departed = []
+        self.arrived = []
+        self.idListSubscribed = False
+        self.simSubscription = None
+        self.vehicleSubscriptions = []
+        self.numMessages = 0
+        self.numCommands = 0
+
+    def recvExactly(self, n):
+        data = b''
+        while len(data) < n:
+            chunk = self.conn.recv(n - len(data))
+            if not chunk:
+                return None
+            data += chunk
+        return data
+
+    def serve(self):
+        while True:
+            header = self.recvExactly(4)
+            if header is None:
+                break
+            length = struct.unpack('!i', header)[0]
+            data = self.recvExactly(length - 4)
+            if data is None:
+                break
+            self.numMessages += 1
+
+            response = []
+            closing = False
+            buf = Storage(data)
+            while not buf.eof():
+                start = buf.pos
+                cmdLength = buf.readUByte()
+                if cmdLength == 0:
+                    cmdLength = buf.readInt()
+                commandId = buf.readUByte()
+                content = Storage(data[buf.pos:start + cmdLength])
+                buf.pos = start + cmdLength
+                self.numCommands += 1
+
+                response.append(self.handleCommand(commandId, content))
+                if commandId == CMD_CLOSE:
+                    closing = True
+
+            reply = b''.join(response)
+            self.conn.sendall(struct.pack('!i', len(reply) + 4) + reply)
+            if closing:
+                break
+
+        logging.info("Client done after %d messages carrying %d commands" % (self.numMessages, self.numCommands))
+
+    def handleCommand(self, commandId, content):
+        if commandId == CMD_GETVERSION:
+            return packStatus(commandId) + packCommand(CMD_GETVERSION, struct.pack('!i', _API_VERSION) + packString(_REPLAYD_VERSION))
+
+        if commandId == CMD_GET_SIM_VARIABLE:
+            variable = content.readUByte()
+            objectId = content.readString()
+            if variable != VAR_NET_BOUNDING_BOX:
+                return packStatus(commandId, RTYPE_NOTIMPLEMENTED, "only the network bounding box can be queried")
+            value = struct.pack('!B', variable) + packString(objectId) + struct.pack('!Bdddd', TYPE_BOUNDINGBOX, *self.trace.bounds)
+            return packStatus(commandId) + packCommand(RESPONSE_GET_SIM_VARIABLE, value)
+
+        if commandId == CMD_SUBSCRIBE_VEHICLE_VARIABLE or commandId == CMD_SUBSCRIBE_SIM_VARIABLE:
+            content.read('ii')
+            objectId = content.readString()
+            variableNumber = content.readUByte()
+            variables = [content.readUByte() for i in range(variableNumber)]
+            return self.subscribe(commandId, objectId, variables)
+
+        if commandId == CMD_SIMSTEP2:
+            targetTime = content.readInt()
+            self.advance(targetTime)
+            results = [self.idListResult()] if self.idListSubscribed else []
+            if self.simSubscription is not None:
+                results.append(self.simResult(self.simSubscription))
+            for (vehicleId, variables) in self.vehicleSubscriptions:
+                if vehicleId in self.vehicles:
+                    results.append(self.vehicleResult(vehicleId, variables))
+            return packStatus(commandId) + struct.pack('!i', len(results)) + b''.join(results)
+
+        if commandId == CMD_CLOSE:
+            return packStatus(commandId)
+
+        if 0xc0 <= commandId <= 0xcf:
+            # set commands: acknowledge, the replay cannot be influenced
+            return packStatus(commandId)
+
+        logging.warning("Command 0x%02x not implemented" % commandId)
+        return packStatus(commandId, RTYPE_NOTIMPLEMENTED, "not implemented by " + _REPLAYD_VERSION)
+
+    def subscribe(self, commandId, objectId, variables):
+        if commandId == CMD_SUBSCRIBE_SIM_VARIABLE:
+            self.simSubscription = variables or None
+            if not variables:
+                return packStatus(commandId)
+            return packStatus(commandId) + self.simResult(variables)
+
+        if objectId == '':
+            self.idListSubscribed = (ID_LIST in variables)
+            if not variables:
+                return packStatus(commandId)
+            return packStatus(commandId) + self.idListResult()
+
+        self.vehicleSubscriptions = [s for s in self.vehicleSubscriptions if s[0] != objectId]
+        if not variables:
+            return packStatus(commandId)
+        if objectId not in self.vehicles:
+            return packStatus(commandId, RTYPE_ERR, "vehicle '%s' is not known" % objectId)
+        self.vehicleSubscriptions.append((objectId, variables))
+        return packStatus(commandId) + self.vehicleResult(objectId, variables)
+
+    def advance(self, targetTime):
+        (current, self.index) = self.trace.vehiclesAt(targetTime, self.index)
+        previous = self.vehicles
+        self.vehicles = dict([(v[0], v) for v in current])
+        self.departed = [v for v in self.vehicles if v not in previous]
+        self.arrived = [v for v in previous if v not in self.vehicles]
+        self.time = targetTime
+
+        # arrived vehicles lose their subscriptions, as in SUMO
+        self.vehicleSubscriptions = [s for s in self.vehicleSubscriptions if s[0] in self.vehicles]
+
+    def idListResult(self):
+        value = struct.pack('!BB', ID_LIST, RTYPE_OK) + packStringList(sorted(self.vehicles.keys()))
+        return packSubscriptionResult(RESPONSE_SUBSCRIBE_VEHICLE_VARIABLE, '', [value])
+
+    def simResult(self, variables):
+        values = []
+        for variable in variables:
+            if variable == VAR_DEPARTED_VEHICLES_IDS:
+                values.append(struct.pack('!BB', variable, RTYPE_OK) + packStringList(self.departed))
+            elif variable == VAR_ARRIVED_VEHICLES_IDS:
+                values.append(struct.pack('!BB', variable, RTYPE_OK) + packStringList(self.arrived))
+            elif variable == VAR_TIME_STEP:
+                values.append(struct.pack('!BBBi', variable, RTYPE_OK, TYPE_INTEGER, self.time))
+            else:
+                values.append(struct.pack('!BBB', variable, RTYPE_NOTIMPLEMENTED, TYPE_STRING) + packString("not implemented"))
+        return packSubscriptionResult(RESPONSE_SUBSCRIBE_SIM_VARIABLE, '', values)
+
+    def vehicleResult(self, vehicleId, variables):
+        (vid, x, y, road, speed, angle) = self.vehicles[vehicleId]
+        values = []
+        for variable in variables:
+            if variable == VAR_POSITION:
+                values.append(struct.pack('!BBBdd', variable, RTYPE_OK, POSITION_2D, x, y))
+            elif variable == VAR_ROAD_ID:
+                values.append(struct.pack('!BBB', variable, RTYPE_OK, TYPE_STRING) + packString(road))
+            elif variable == VAR_SPEED:
+                values.append(struct.pack('!BBBd', variable, RTYPE_OK, TYPE_DOUBLE, speed))
+            elif variable == VAR_ANGLE:
+                values.append(struct.pack('!BBBd', variable, RTYPE_OK, TYPE_DOUBLE, angle))
+            else:
+                values.append(struct.pack('!BBB', variable, RTYPE_NOTIMPLEMENTED, TYPE_STRING) + packString("not implemented"))
+        return packSubscriptionResult(RESPONSE_SUBSCRIBE_VEHICLE_VARIABLE, vehicleId, values)
+
+
+def main():
+    parser = OptionParser()
+    parser.add_option("-t", "--trace", dest="trace", help="trace file to replay (as recorded by TraCIScenarioManager)")
+    parser.add_option("-p", "--port", dest="port", type="int", default=8888, action="store", help="listen for connections on PORT [default: %default]", metavar="PORT")
+    parser.add_option("-b", "--bind", dest="bind", default="127.0.0.1", help="bind to ADDRESS [default: %default]", metavar="ADDRESS")
+    parser.add_option("-1", "--single", dest="single", default=False, action="store_true", help="exit after serving one client")
+    parser.add_option("-v", "--verbose", dest="count_verbose", default=0, action="count", help="increase verbosity [default: don't log infos, debug]")
+    (options, args) = parser.parse_args()
+
+    if not options.trace:
+        parser.error("no trace file given")
+
+    logging.basicConfig(level=logging.WARNING - 10 * options.count_verbose, format="%(asctime)s %(levelname)s %(message)s")
+
+    trace = Trace(options.trace)
+
+    listener = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    listener.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    listener.bind((options.bind, options.port))
+    listener.listen(5)
+    logging.info("Listening on %s:%d" % (options.bind, options.port))
+
+    while True:
+        (conn, addr) = listener.accept()
+        conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        logging.info("Connection from %s:%d" % addr)
+        try:
+            ReplaySession(trace, conn).serve()
+        finally:
+            conn.close()
+        if options.single:
+            break
+
+    listener.close()
+
+
+if __name__ == "__main__":
+    main()
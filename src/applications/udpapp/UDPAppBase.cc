@@ -22,6 +22,11 @@
 #include "UDPControlInfo_m.h"
 
 void UDPAppBase::bindToPort(int port)
+{
+    bindToPort(port, IPvXAddress(), 0);
+}
+
+void UDPAppBase::bindToPort(int port, const IPvXAddress& remoteAddr, int remotePort)
 {
     EV << "Binding to UDP port " << port << endl;
 
@@ -30,6 +35,8 @@ void UDPAppBase::bindToPort(int port)
     cMessage *msg = new cMessage("UDP_C_BIND", UDP_C_BIND);
     UDPControlInfo *ctrl = new UDPControlInfo();
     ctrl->setSrcPort(port);
+    ctrl->setDestAddr(remoteAddr);
+    ctrl->setDestPort(remotePort);
     ctrl->setSockId(UDPSocket::generateSocketId());
     msg->setControlInfo(ctrl);
     send(msg, "udpOut");
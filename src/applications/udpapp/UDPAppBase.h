@@ -35,6 +35,13 @@ class INET_API UDPAppBase : public cSimpleModule
      */
     virtual void bindToPort(int port);
 
+    /**
+     * Tells UDP we want to get the packets arriving on the given port from
+     * the given remote address and port; unspecified address and port 0
+     * mean any.
+     */
+    virtual void bindToPort(int port, const IPvXAddress& remoteAddr, int remotePort);
+
     /**
      * Sends a packet over UDP
      */
@@ -32,7 +32,7 @@ void UDPSink::initialize()
 
     int port = par("localPort");
     if (port!=-1)
-        bindToPort(port);
+        bindToPort(port, IPvXAddress(), par("remotePort"));
 }
 
 void UDPSink::handleMessage(cMessage *msg)
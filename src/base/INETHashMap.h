@@ -0,0 +1,68 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_INETHASHMAP_H
+#define __INET_INETHASHMAP_H
+
+//
+// Portable include for std::tr1::unordered_map. gcc ships it in
+// <tr1/unordered_map>, MSVC (2008 SP1 and later) in <unordered_map>.
+// Use it where a lookup is on the per-packet path and the table may
+// grow large; elsewhere std::map is fine (and can be WATCH_MAP'ed).
+//
+#ifdef _MSC_VER
+#  include <unordered_map>
+#else
+#  include <tr1/unordered_map>
+#endif
+
+#include "INETDefs.h"
+#include "IPAddress.h"
+#include "MACAddress.h"
+
+/**
+ * Mixes the bits of a 32-bit value; useful for building hash functions
+ * of address-like keys whose low bits are poorly distributed.
+ */
+inline size_t inet_hashmix(uint32 x)
+{
+    x ^= x >> 16;
+    x *= 0x85ebca6bU;
+    x ^= x >> 13;
+    x *= 0xc2b2ae35U;
+    x ^= x >> 16;
+    return x;
+}
+
+/**
+ * Hash function for unordered_maps keyed on IPAddress.
+ */
+struct IPAddressHash
+{
+    size_t operator()(const IPAddress& addr) const {return inet_hashmix(addr.getInt());}
+};
+
+/**
+ * Hash function for unordered_maps keyed on MACAddress.
+ */
+struct MACAddressHash
+{
+    size_t operator()(const MACAddress& addr) const {
+        uint64 x = addr.getInt();
+        return inet_hashmix((uint32)x ^ inet_hashmix((uint32)(x>>32)));
+    }
+};
+
+#endif
@@ -40,6 +40,7 @@ const char *notificationCategoryName(int category)
         case NF_MAC_BECAME_IDLE: return "MAC-IDLE";
         case NF_L2_BEACON_LOST: return "BEACON-LOST";
         case NF_L2_ASSOCIATED: return "ASSOCIATED";
+        case NF_MESH_ROUTE_CHANGED: return "MESH-ROUTE";
 
         case NF_INTERFACE_CREATED: return "IF-CREATED";
         case NF_INTERFACE_DELETED: return "IF-DELETED";
@@ -59,6 +59,7 @@ enum
     NF_LINK_PROMISCUOUS, // Used for manet promiscuous mode, the packets that have this node how destination are no promiscuous send
 	NF_LINK_FULL_PROMISCUOUS, // Used for manet promiscuous mode, all packets are promiscuous
     NF_LINK_REFRESH,     // Used for refresh a neigbourd adjacency 
+    NF_MESH_ROUTE_CHANGED, // a routing protocol running in Ieee80211Mesh changed its routes
 
 
     // - layer 3 (network)
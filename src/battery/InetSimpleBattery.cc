@@ -84,9 +84,13 @@ void InetSimpleBattery::initialize(int stage)
         residualVec.setName("residualCapacity");
         residualVec.record(residualCapacity);
 
+        // in analytic mode the current draw is integrated exactly at every
+        // change and timeout only fires when the battery runs out
+        analytic = par("analytic");
         timeout = new cMessage("auto-update", AUTO_UPDATE);
         timeout->setSchedulingPriority(500);
-        scheduleAt(simTime() + resolution, timeout);
+        if (!analytic)
+            scheduleAt(simTime() + resolution, timeout);
         lastUpdateTime = simTime();
         WATCH(lastPublishCapacity);
     }
@@ -175,15 +179,32 @@ void InetSimpleBattery::handleMessage(cMessage *msg)
         switch (msg->getKind())
         {
         case AUTO_UPDATE:
+            if (analytic)
+            {
+                // a predicted event is due; any difference to the integrated
+                // capacity is rounding error of the event time
+                depletionDue = (simTime() == depletionTime);
+                publishDue = !depletionDue;
+                deductAndCheck();
+                depletionDue = publishDue = false;
+                scheduleNextUpdate();
+                break;
+            }
             // update the residual capacity (ongoing current draw)
             scheduleAt(simTime() + resolution, timeout);
             deductAndCheck();
             break;
 
         case PUBLISH:
+            // in analytic mode the capacity is not polled, bring it up to date.
+            // The timer keeps running even without NF_BATTERY_CHANGED
+            // subscribers, as they may subscribe later
+            if (analytic)
+                deductAndCheck();
             // publish the state to the BatteryStats module
             lastPublishCapacity = residualCapacity;
             scheduleAt(simTime() + publishTime, publish);
+            scheduleNextUpdate();
             break;
 
         default:
@@ -200,12 +221,60 @@ void InetSimpleBattery::handleMessage(cMessage *msg)
 
 
 
+double InetSimpleBattery::getCurrentDraw()
+{
+    double current = 0;
+    for (unsigned int i = 0; i < deviceEntryVector.size(); i++)
+        if (deviceEntryVector[i]->currentActivity > -1)
+            current += deviceEntryVector[i]->draw;
+    for (DeviceEntryMap::iterator it = deviceEntryMap.begin(); it!=deviceEntryMap.end(); it++)
+        if (it->second->currentActivity > -1)
+            current += it->second->draw;
+    return current;
+}
+
+void InetSimpleBattery::scheduleNextUpdate()
+{
+    if (!analytic)
+        return;
+
+    if (timeout->isScheduled())
+        cancelEvent(timeout);
+
+    // the draw is constant until the next change, so the capacity decreases
+    // linearly and the time it runs out (or crosses the next publishDelta
+    // step) can be computed directly
+    double power = getCurrentDraw() * voltage; // mW
+    if (residualCapacity <= 0 || power <= 0)
+        return;
+
+    depletionTime = simTime() + residualCapacity / power;
+    simtime_t next = depletionTime;
+
+    if (publishDelta < 1 && mpNb->hasSubscribers(NF_BATTERY_CHANGED))
+    {
+        double threshold = lastPublishCapacity - publishDelta * capacity;
+        if (threshold > 0)
+        {
+            simtime_t publishAt = simTime() + (residualCapacity - threshold) / power;
+            if (publishAt < next)
+                next = publishAt;
+        }
+    }
+
+    scheduleAt(next, timeout);
+}
+
 void InetSimpleBattery::finish()
 {
     // do a final update of battery capacity
     deductAndCheck();
+    recordScalar("residualCapacity", residualCapacity);
+    if (lifetime >= 0)
+        recordScalar("lifetime", lifetime);
     deviceEntryMap.clear();
     deviceEntryVector.clear();
+    lastRadio = NULL;
 }
 
 void InetSimpleBattery::receiveChangeNotification (int aCategory, const cPolymorphic* aDetails)
@@ -216,14 +285,19 @@ void InetSimpleBattery::receiveChangeNotification (int aCategory, const cPolymor
     {
         RadioState *rs = check_and_cast <RadioState *>(aDetails);
 
-        DeviceEntryMap::iterator it = deviceEntryMap.find(rs->getRadioId());
-        if (it==deviceEntryMap.end())
-            return;
+        if (rs->getRadioId() != lastRadioId || !lastRadio)
+        {
+            DeviceEntryMap::iterator it = deviceEntryMap.find(rs->getRadioId());
+            if (it==deviceEntryMap.end())
+                return;
+            lastRadioId = it->first;
+            lastRadio = it->second;
+        }
 
-        if (rs->getState()>=it->second->numAccts)
+        if (rs->getState()>=lastRadio->numAccts)
             opp_error("Error in battery states");
 
-        double current = it->second->radioUsageCurrent[rs->getState()];
+        double current = lastRadio->radioUsageCurrent[rs->getState()];
 
         EV << simTime() << " wireless device " << rs->getRadioId() << " draw current " << current <<
         "mA, new state = " << rs->getState() << "\n";
@@ -232,8 +306,9 @@ void InetSimpleBattery::receiveChangeNotification (int aCategory, const cPolymor
         deductAndCheck();
 
         // set the new current draw in the device vector
-        it->second->draw = current;
-        it->second->currentActivity = rs->getState();
+        lastRadio->draw = current;
+        lastRadio->currentActivity = rs->getState();
+        scheduleNextUpdate();
     }
 }
 
@@ -241,6 +316,7 @@ void InetSimpleBattery::receiveChangeNotification (int aCategory, const cPolymor
 
 void InetSimpleBattery::draw(int deviceID, DrawAmount& amount, int activity)
 {
+    Enter_Method_Silent();
     if (amount.getType() == DrawAmount::CURRENT)
     {
 
@@ -258,6 +334,7 @@ void InetSimpleBattery::draw(int deviceID, DrawAmount& amount, int activity)
         // set the new current draw in the device vector
         deviceEntryVector[deviceID]->draw = current;
         deviceEntryVector[deviceID]->currentActivity = activity;
+        scheduleNextUpdate();
     }
 
     else if (amount.getType() == DrawAmount::ENERGY)
@@ -278,6 +355,7 @@ void InetSimpleBattery::draw(int deviceID, DrawAmount& amount, int activity)
         // update the residual capacity (ongoing current draw), mostly
         // to check whether to publish (or perish)
         deductAndCheck();
+        scheduleNextUpdate();
     }
     else
     {
@@ -357,6 +435,9 @@ void InetSimpleBattery::deductAndCheck()
 
     lastUpdateTime = now;
 
+    if (depletionDue && residualCapacity > 0)
+        residualCapacity = 0;
+
     EV << "residual capacity = " << residualCapacity << "\n";
 
     cDisplayString* display_string = &getParentModule()->getDisplayString();
@@ -366,6 +447,7 @@ void InetSimpleBattery::deductAndCheck()
     {
 
         EV << "[BATTERY]: " << getParentModule()->getFullName() <<" 's battery exhausted, stop simulation" << "\n";
+        lifetime = now;
         display_string->setTagArg("i", 1, "#ff0000");
         endSimulation();
     }
@@ -374,7 +456,7 @@ void InetSimpleBattery::deductAndCheck()
     else
     {
         // publish the battery capacity if it changed by more than delta
-        if ((lastPublishCapacity - residualCapacity)/capacity >= publishDelta)
+        if (publishDue || (lastPublishCapacity - residualCapacity)/capacity >= publishDelta)
         {
             lastPublishCapacity = residualCapacity;
             Energy* p_ene = new Energy(residualCapacity);
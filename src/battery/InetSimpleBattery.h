@@ -98,7 +98,7 @@ class INET_API InetSimpleBattery : public BasicBattery
      */
     virtual void draw(int drainID, DrawAmount& amount, int account);
     ~InetSimpleBattery();
-    InetSimpleBattery() {mustSubscribe = true;}
+    InetSimpleBattery() {mustSubscribe = true; analytic = false; depletionDue = publishDue = false; lastRadioId = -1; lastRadio = NULL;}
     double getVoltage();
     /** @brief current state of charge of the battery, relative to its
      * rated nominal capacity [0..1]
@@ -120,7 +120,22 @@ class INET_API InetSimpleBattery : public BasicBattery
     cMessage *publish;
     simtime_t lastUpdateTime;
 
+    // analytic mode: timeout is scheduled at the predicted depletion time
+    // (or publishDelta crossing) instead of every resolution seconds
+    bool analytic;
+    simtime_t depletionTime;
+    bool depletionDue;
+    bool publishDue;
+
+    // the radio whose state changed last, saves the map lookup
+    int lastRadioId;
+    DeviceEntry *lastRadio;
+
     virtual void deductAndCheck();
+    /** @brief total current drawn by all devices at the moment (mA) */
+    double getCurrentDraw();
+    /** @brief analytic mode: (re)schedules timeout for the next predicted event */
+    virtual void scheduleNextUpdate();
     void receiveChangeNotification (int aCategory, const cPolymorphic* aDetails);
 
 };
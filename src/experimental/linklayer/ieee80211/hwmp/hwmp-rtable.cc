@@ -32,22 +32,53 @@ HwmpRtable::~HwmpRtable ()
 {
    DeleteProactivePath();
    m_routes.clear ();
+   m_routesByNextHop.clear ();
+}
+
+void
+HwmpRtable::addToNextHop (ReactiveRoutes::iterator route)
+{
+  std::vector<MACAddress> &destinations = m_routesByNextHop[route->second.retransmitter];
+  route->second.nextHopIndex = destinations.size ();
+  destinations.push_back (route->first);
+}
+
+void
+HwmpRtable::removeFromNextHop (ReactiveRoutes::iterator route)
+{
+  RoutesByNextHop::iterator it = m_routesByNextHop.find (route->second.retransmitter);
+  ASSERT (it != m_routesByNextHop.end ());
+  std::vector<MACAddress> &destinations = it->second;
+  unsigned int index = route->second.nextHopIndex;
+  ASSERT (index < destinations.size () && destinations[index] == route->first);
+  // swap-remove; the moved route learns its new position
+  if (index != destinations.size () - 1)
+    {
+      destinations[index] = destinations.back ();
+      m_routes.find (destinations[index])->second.nextHopIndex = index;
+    }
+  destinations.pop_back ();
+  if (destinations.empty ())
+    m_routesByNextHop.erase (it);
 }
 
 void
 HwmpRtable::AddReactivePath (MACAddress destination, MACAddress retransmitter, uint32_t interface,
     uint32_t metric, simtime_t lifetime, uint32_t seqnum,uint8_t hops,bool actualizeSeqnum)
 {
-  //uint64_t dest= MacToUint64(destination);
-  std::map<MACAddress, ReactiveRoute>::iterator i = m_routes.find (destination);
+  ReactiveRoutes::iterator i = m_routes.find (destination);
   if (i == m_routes.end ())
     {
-      ReactiveRoute newroute;
-      m_routes[destination] = newroute;
+      i = m_routes.insert (std::make_pair (destination, ReactiveRoute ())).first;
+      i->second.retransmitter = retransmitter;
+      addToNextHop (i);
+    }
+  else if (i->second.retransmitter != retransmitter)
+    {
+      removeFromNextHop (i);
+      i->second.retransmitter = retransmitter;
+      addToNextHop (i);
     }
-  i = m_routes.find (destination);
-  ASSERT (i != m_routes.end ());
-  i->second.retransmitter = retransmitter;
   i->second.interface = interface;
   i->second.metric = metric;
   i->second.whenExpire = simTime() + lifetime;
@@ -77,8 +108,7 @@ HwmpRtable::AddPrecursor (MACAddress destination, uint32_t precursorInterface,
   precursor.interface = precursorInterface;
   precursor.address = precursorAddress;
   precursor.whenExpire = simTime() + lifetime;
-  // uint64_t dest= MacToUint64(destination);
-  std::map<MACAddress, ReactiveRoute>::iterator i = m_routes.find (destination);
+  ReactiveRoutes::iterator i = m_routes.find (destination);
   if (i != m_routes.end ())
     {
       bool should_add = true;
@@ -124,10 +154,10 @@ HwmpRtable::DeleteProactivePath (MACAddress root)
 void
 HwmpRtable::DeleteReactivePath (MACAddress destination)
 {
- // uint64_t dest= MacToUint64(destination);
-  std::map<MACAddress, ReactiveRoute>::iterator i = m_routes.find (destination);
+  ReactiveRoutes::iterator i = m_routes.find (destination);
   if (i != m_routes.end ())
   {
+      removeFromNextHop (i);
       m_routes.erase (i);
   }
 }
@@ -135,8 +165,7 @@ HwmpRtable::DeleteReactivePath (MACAddress destination)
 HwmpRtable::LookupResult
 HwmpRtable::LookupReactive (MACAddress destination)
 {
-  // uint64_t dest= MacToUint64(destination);
-  std::map<MACAddress, ReactiveRoute>::iterator i = m_routes.find (destination);
+  ReactiveRoutes::iterator i = m_routes.find (destination);
   if (i == m_routes.end ())
     {
       return LookupResult ();
@@ -146,14 +175,16 @@ HwmpRtable::LookupReactive (MACAddress destination)
       EV << "Reactive route has expired, sorry." <<endl;
       return LookupResult ();
     }
-  return LookupReactiveExpired (destination);
+  if (i->second.whenExpire <= simTime())
+     return LookupResult (i->second.retransmitter, i->second.interface, i->second.metric, i->second.seqnum,0);
+  return LookupResult (i->second.retransmitter, i->second.interface, i->second.metric, i->second.seqnum,
+      i->second.whenExpire - simTime());
 }
 
 HwmpRtable::LookupResult
 HwmpRtable::LookupReactiveExpired (MACAddress destination)
 {
-  // uint64_t dest= MacToUint64(destination);
-  std::map<MACAddress, ReactiveRoute>::iterator i = m_routes.find (destination);
+  ReactiveRoutes::iterator i = m_routes.find (destination);
   if (i == m_routes.end ())
     {
       return LookupResult ();
@@ -189,13 +220,15 @@ HwmpRtable::GetUnreachableDestinations (MACAddress peerAddress)
 {
   HwmpFailedDestination dst;
   std::vector<HwmpFailedDestination> retval;
-  for (std::map<MACAddress, ReactiveRoute>::iterator i = m_routes.begin (); i != m_routes.end (); i++)
+  RoutesByNextHop::iterator it = m_routesByNextHop.find (peerAddress);
+  if (it != m_routesByNextHop.end ())
   {
-      if (i->second.retransmitter == peerAddress)
+      for (unsigned int j = 0; j < it->second.size (); j++)
         {
-          dst.destination = i->first;// Uint64ToMac(i->first);
-          i->second.seqnum++;
-          dst.seqnum = i->second.seqnum;
+          ReactiveRoute &route = m_routes.find (it->second[j])->second;
+          dst.destination = it->second[j];
+          route.seqnum++;
+          dst.seqnum = route.seqnum;
           retval.push_back (dst);
         }
   }
@@ -214,8 +247,7 @@ HwmpRtable::GetPrecursors (MACAddress destination)
 {
   //We suppose that no duplicates here can be
   PrecursorList retval;
-  // uint64_t dest= MacToUint64(destination);
-  std::map<MACAddress, ReactiveRoute>::iterator route = m_routes.find (destination);
+  ReactiveRoutes::iterator route = m_routes.find (destination);
   if (route != m_routes.end ())
     {
       for (std::vector<Precursor>::const_iterator i = route->second.precursors.begin ();
@@ -241,8 +273,7 @@ HwmpRtable::LookupResult::operator== (const HwmpRtable::LookupResult & o) const
 HwmpRtable::ReactiveRoute *
 HwmpRtable::getLookupReactivePtr (MACAddress destination)
 {
-	 // uint64_t dest= MacToUint64(destination);
-     std::map<MACAddress, ReactiveRoute>::iterator i = m_routes.find (destination);
+     ReactiveRoutes::iterator i = m_routes.find (destination);
      if (i == m_routes.end ())
          return NULL;
      if ((i->second.whenExpire < simTime()) && (i->second.whenExpire !=  0))
@@ -261,16 +292,10 @@ HwmpRtable::getLookupProactivePtr ()
 void
 HwmpRtable::deleteNeighborRoutes (MACAddress nextHop)
 {
-
-	for (std::map<MACAddress, ReactiveRoute>::iterator it = m_routes.begin ();it != m_routes.end ();)
-	{
-         if (it->second.retransmitter==nextHop)
-         {
-             std::map<MACAddress, ReactiveRoute>::iterator aux=it;
-             it++;
-             m_routes.erase(aux);
-         }
-         else
-             it++;
-	}
+  RoutesByNextHop::iterator it = m_routesByNextHop.find (nextHop);
+  if (it == m_routesByNextHop.end ())
+    return;
+  for (unsigned int j = 0; j < it->second.size (); j++)
+    m_routes.erase (it->second[j]);
+  m_routesByNextHop.erase (it);
 }
@@ -22,7 +22,9 @@
 #define HWMP_RTABLE_H
 
 #include <map>
+#include <vector>
 #include <omnetpp.h>
+#include "INETHashMap.h"
 #include "MACAddress.h"
 
 /**
@@ -94,6 +96,7 @@ public:
     simtime_t whenExpire;
     uint32_t seqnum;
     std::vector<Precursor> precursors;
+    unsigned int nextHopIndex; ///< position in m_routesByNextHop[retransmitter]
   };
   
   //Route fond in proactive mode
@@ -160,12 +163,20 @@ public:
   /// When peer link with a given MAC-address fails - it returns list of unreachable destination addresses
   std::vector<HwmpFailedDestination> GetUnreachableDestinations (MACAddress peerAddress);
   friend class HwmpProtocol;
+
 private:
+  typedef std::tr1::unordered_map<MACAddress, ReactiveRoute, MACAddressHash> ReactiveRoutes;
+  typedef std::tr1::unordered_map<MACAddress, std::vector<MACAddress>, MACAddressHash> RoutesByNextHop;
   /// List of routes
-  std::map<MACAddress, ReactiveRoute>  m_routes;
+  ReactiveRoutes m_routes;
+  /// Destinations of the reactive routes through each next hop (expired ones included)
+  RoutesByNextHop m_routesByNextHop;
   /// Path to proactive tree root MP
   ProactiveRoute  m_root;
 
+  void addToNextHop (ReactiveRoutes::iterator route);
+  void removeFromNextHop (ReactiveRoutes::iterator route);
+
       static uint64_t MacToUint64(const MACAddress &add)
       {
           uint64_t aux;
@@ -25,6 +25,7 @@
 #include "Ieee802Ctrl_m.h"
 #include <Ieee80211Etx.h>
 #include "Radio80211aControlInfo_m.h"
+#include <set>
 
 #define delay uniform(0.0,0.01)
 
@@ -129,6 +130,7 @@ HwmpProtocol::HwmpProtocol ()
     useEtxProc = false;
     m_isGann=false;
     ganVector.clear();
+    m_rqueueSize = 0;
 }
 
 HwmpProtocol::~HwmpProtocol ()
@@ -138,6 +140,8 @@ HwmpProtocol::~HwmpProtocol ()
     delete m_perrTimer;
     delete m_rtable;
     delete m_gannTimer;
+    for (PacketQueue::iterator it = m_rqueue.begin(); it != m_rqueue.end(); ++it)
+        delete it->pkt;
     neighborMap.clear();
     ganVector.clear();
 }
@@ -186,7 +190,7 @@ HwmpProtocol::initialize(int stage)
         }
 
 
-        WATCH_MAP (m_rtable->m_routes);
+        // the reactive routes are a hash map, which WATCH_MAP cannot display
         WATCH (m_rtable->m_root);
         Ieee80211Etx * etx= dynamic_cast<Ieee80211Etx *> (interface80211ptr->getEstimateCostProcess(0));
         if (etx==NULL)
@@ -255,7 +259,11 @@ void HwmpProtocol::processData (cMessage *msg)
             qpkt.inInterface = ctrl->getInputPort();
             delete ctrl;
         }
-        this->QueuePacket(qpkt);
+        if (!this->QueuePacket(qpkt))
+        {
+            m_stats.totalDropped ++;
+            delete qpkt.pkt;
+        }
 //        HwmpRtable::LookupResult result = m_rtable->LookupReactive (qpkt.dst);
 //        HwmpRtable::LookupResult resultProact = m_rtable->LookupProactive ();
         if (result.retransmitter.isUnspecified() &&  resultProact.retransmitter.isUnspecified())
@@ -592,13 +600,14 @@ void HwmpProtocol::sendMyPreq ()
 
 bool HwmpProtocol::shouldSendPreq (MACAddress dst)
 {
-    std::map<MACAddress, PreqEvent>::const_iterator i = m_preqTimeouts.find (dst);
+    PreqTimeouts::const_iterator i = m_preqTimeouts.find (dst);
     if (i == m_preqTimeouts.end ())
     {
-        m_preqTimeouts[dst].preqTimeout = new PreqTimeout(dst,this);
-        m_preqTimeouts[dst].preqTimeout->resched(m_dot11MeshHWMPnetDiameterTraversalTime * 2.0);
-        m_preqTimeouts[dst].whenScheduled = simTime();
-        m_preqTimeouts[dst].numOfRetry = 1;
+        PreqEvent &event = m_preqTimeouts[dst];
+        event.preqTimeout = new PreqTimeout(dst,this);
+        event.preqTimeout->resched(m_dot11MeshHWMPnetDiameterTraversalTime * 2.0);
+        event.whenScheduled = simTime();
+        event.numOfRetry = 1;
         return true;
     }
     return false;
@@ -609,7 +618,7 @@ void HwmpProtocol::retryPathDiscovery (MACAddress dst)
     HwmpRtable::LookupResult result = m_rtable->LookupReactive (dst);
     HwmpRtable::LookupResult resultProact = m_rtable->LookupProactive();
 
-    std::map<MACAddress, PreqEvent>::iterator i  = m_preqTimeouts.find (dst);
+    PreqTimeouts::iterator i  = m_preqTimeouts.find (dst);
     ASSERT (i != m_preqTimeouts.end ()); // always must be the preqTimeouts in the table
     if (!result.retransmitter.isUnspecified()) // address valid, don't retransmit
     {
@@ -637,9 +646,9 @@ void HwmpProtocol::retryPathDiscovery (MACAddress dst)
             delete packet.pkt;
             packet = dequeueFirstPacketByDst (dst);
         }
-        m_preqTimeouts.erase (i);
         i->second.preqTimeout->removeTimer();
         delete i->second.preqTimeout;
+        m_preqTimeouts.erase (i);
         return;
     }
 /*
@@ -813,6 +822,7 @@ uint32_t HwmpProtocol::GetLinkMetric (const MACAddress &peerAddress)
        neighborMap.erase(it);
        // delete the route with this address like next hop
        m_rtable->deleteNeighborRoutes(peerAddress);
+       notifyRouteChanged();
        return 0xFFFFFFF; // no Neighbor
     }
     if (par("minHopCost").boolValue()) // the cost is 1
@@ -1022,7 +1032,7 @@ void HwmpProtocol::receivePreq (Ieee80211ActionPREQFrame *preqFrame, MACAddress
         delete preqFrame;
         return;
     }
-    std::map<MACAddress, std::pair<uint32_t, uint32_t> >::const_iterator i = m_hwmpSeqnoMetricDatabase.find (
+    SeqnoMetricDatabase::const_iterator i = m_hwmpSeqnoMetricDatabase.find (
             originatorAddress);
     bool freshInfo (true);
     if (preqFrame->getControlInfo())
@@ -1062,6 +1072,7 @@ void HwmpProtocol::receivePreq (Ieee80211ActionPREQFrame *preqFrame, MACAddress
                 preqFrame->getBody().getHopsCount(),
                 true
         );
+        notifyRouteChanged();
         reactivePathResolved (originatorAddress);
     }
     if (
@@ -1080,6 +1091,7 @@ void HwmpProtocol::receivePreq (Ieee80211ActionPREQFrame *preqFrame, MACAddress
                 1,
                 false
         );
+        notifyRouteChanged();
         reactivePathResolved (fromMp);
     }
     std::vector<MACAddress> delAddress;
@@ -1108,6 +1120,7 @@ void HwmpProtocol::receivePreq (Ieee80211ActionPREQFrame *preqFrame, MACAddress
                         ((double)preqFrame->getBody().getLifeTime()*1024.0)/1000000.0,
                         originatorSeqNumber,
                         preqFrame->getBody().getHopsCount());
+                notifyRouteChanged();
                 proactivePathResolved ();
             }
             bool proactivePrep = false;
@@ -1289,7 +1302,7 @@ HwmpProtocol::receivePrep (Ieee80211ActionPREPFrame * prepFrame, MACAddress from
     uint32_t originatorSeqNumber = prepFrame->getBody().getOriginatorSeqNumber ();
     MACAddress destinationAddress = prepFrame->getBody().getTarget ();
     //acceptance cretirea:
-    std::map<MACAddress, std::pair<uint32_t, uint32_t> >::const_iterator i = m_hwmpSeqnoMetricDatabase.find (
+    SeqnoMetricDatabase::const_iterator i = m_hwmpSeqnoMetricDatabase.find (
             originatorAddress);
     if (prepFrame->getControlInfo())
         delete prepFrame->removeControlInfo();
@@ -1330,6 +1343,7 @@ HwmpProtocol::receivePrep (Ieee80211ActionPREPFrame * prepFrame, MACAddress from
                 originatorSeqNumber,
                 prepFrame->getBody().getHopsCount(),
                 true);
+        notifyRouteChanged();
         m_rtable->AddPrecursor (destinationAddress, interface, from,
                 ((double)prepFrame->getBody().getLifeTime()*1024.0)/1000000.0);
         if (!result.retransmitter.isUnspecified())
@@ -1354,6 +1368,7 @@ HwmpProtocol::receivePrep (Ieee80211ActionPREPFrame * prepFrame, MACAddress from
                 originatorSeqNumber,
                 1,
                 false);
+        notifyRouteChanged();
         reactivePathResolved (fromMp);
     }
     if (destinationAddress == GetAddress ())
@@ -1455,6 +1470,7 @@ HwmpProtocol::makePathError (std::vector<HwmpFailedDestination> destinations)
     {
         retval.destinations.push_back (destinations[i]);
         m_rtable->DeleteReactivePath (destinations[i].destination);
+        notifyRouteChanged();
     }
     return retval;
 }
@@ -1498,18 +1514,19 @@ HwmpProtocol::getPerrReceivers (std::vector<HwmpFailedDestination> failedDest)
         HwmpRtable::PrecursorList precursors = m_rtable->GetPrecursors (failedDest[i].destination);
         m_rtable->DeleteReactivePath (failedDest[i].destination);
         m_rtable->DeleteProactivePath (failedDest[i].destination);
+        notifyRouteChanged();
         for (unsigned int j = 0; j < precursors.size (); j ++)
             retval.push_back (precursors[j]);
     }
-    //Check if we have dublicates in retval and precursors:
+    //Remove the precursors of several failed destinations, keeping the first
+    std::set<MACAddress> seen;
+    unsigned int n = 0;
     for (unsigned int i = 0; i < retval.size (); i ++)
     {
-        for (unsigned int j = i+1; j < retval.size (); j ++)
-        {
-            if (retval[i].second == retval[j].second)
-                retval.erase (retval.begin () + j);
-        }
+        if (seen.insert (retval[i].second).second)
+            retval[n++] = retval[i];
     }
+    retval.resize (n);
     return retval;
 }
 
@@ -1612,11 +1629,13 @@ HwmpProtocol::getBroadcastReceivers (uint32_t interface)
 bool
 HwmpProtocol::QueuePacket (QueuedPacket packet)
 {
-    if (m_rqueue.size () > m_maxQueueSize)
+    if (m_rqueueSize > m_maxQueueSize)
     {
         return false;
     }
     m_rqueue.push_back (packet);
+    m_rqueueByDst[packet.dst].push_back (--m_rqueue.end ());
+    m_rqueueSize++;
     return true;
 }
 
@@ -1625,15 +1644,16 @@ HwmpProtocol::dequeueFirstPacketByDst (MACAddress dst)
 {
     HwmpProtocol::QueuedPacket retval;
     retval.pkt = 0;
-    for (std::vector<QueuedPacket>::iterator i = m_rqueue.begin (); i != m_rqueue.end (); i++)
-    {
-        if ((*i).dst == dst)
-        {
-            retval = (*i);
-            m_rqueue.erase (i);
-            break;
-        }
-    }
+    QueuedByDestination::iterator it = m_rqueueByDst.find (dst);
+    if (it == m_rqueueByDst.end ())
+        return retval;
+    PacketQueue::iterator packet = it->second.front ();
+    it->second.pop_front ();
+    if (it->second.empty ())
+        m_rqueueByDst.erase (it);
+    retval = *packet;
+    m_rqueue.erase (packet);
+    m_rqueueSize--;
     return retval;
 }
 
@@ -1642,18 +1662,16 @@ HwmpProtocol::dequeueFirstPacket ()
 {
     HwmpProtocol::QueuedPacket retval;
     retval.pkt = 0;
-    if (m_rqueue.size () != 0)
-    {
-        retval = m_rqueue[0];
-        m_rqueue.erase (m_rqueue.begin ());
-    }
-    return retval;
+    if (m_rqueue.empty ())
+        return retval;
+    // the oldest packet is also the oldest one of its destination
+    return dequeueFirstPacketByDst (m_rqueue.front ().dst);
 }
 
 void
 HwmpProtocol::reactivePathResolved (MACAddress dst)
 {
-    std::map<MACAddress, PreqEvent>::iterator i = m_preqTimeouts.find (dst);
+    PreqTimeouts::iterator i = m_preqTimeouts.find (dst);
     HwmpRtable::LookupResult result = m_rtable->LookupReactive (dst);
     ASSERT(result.retransmitter != MACAddress::BROADCAST_ADDRESS);
 
@@ -1909,6 +1927,7 @@ void HwmpProtocol::setRefreshRoute(const Uint128 &destination,const Uint128 &nex
     if (isReverse && !route && par("gratuitousReverseRoute").boolValue())
     {
         m_rtable->AddReactivePath (destination.getMACAddress(), nextHop.getMACAddress(), interface80211ptr->getInterfaceId(),HwmpRtable::MAX_METRIC, m_dot11MeshHWMPactivePathTimeout, 0, HwmpRtable::MAX_HOPS,false);
+        notifyRouteChanged();
     }
     /** the root is only actualized by the proactive mechanism
     HwmpRtable::ProactiveRoute * root = m_rtable->getLookupProactivePtr ();
@@ -27,6 +27,8 @@
 #include "hwmp-rtable.h"
 #include <vector>
 #include <map>
+#include <list>
+#include <deque>
 #include "ManetRoutingBase.h"
 #include "Ieee80211MgmtFrames_m.h"
 
@@ -309,7 +311,8 @@ private:
     ///\name Sequence number filters
     ///\{
     /// keeps HWMP seqno (first in pair) and HWMP metric (second in pair) for each address
-    std::map<MACAddress, std::pair<uint32_t, uint32_t> > m_hwmpSeqnoMetricDatabase;
+    typedef std::tr1::unordered_map<MACAddress, std::pair<uint32_t, uint32_t>, MACAddressHash> SeqnoMetricDatabase;
+    SeqnoMetricDatabase m_hwmpSeqnoMetricDatabase;
     ///\}
 
     /// Routing table
@@ -323,15 +326,21 @@ private:
         simtime_t whenScheduled;
         int numOfRetry;
     };
-    std::map<MACAddress, PreqEvent> m_preqTimeouts;
+    typedef std::tr1::unordered_map<MACAddress, PreqEvent, MACAddressHash> PreqTimeouts;
+    PreqTimeouts m_preqTimeouts;
     ProactivePreqTimer * m_proactivePreqTimer;
     PreqTimer * m_preqTimer;
     PerrTimer  * m_perrTimer;
 
     GannTimer *m_gannTimer;
     ///\}
-    /// Packet Queue
-    std::vector<QueuedPacket> m_rqueue;
+    /// Packet Queue, in arrival order
+    typedef std::list<QueuedPacket> PacketQueue;
+    PacketQueue m_rqueue;
+    unsigned int m_rqueueSize;
+    /// The queued packets of each destination, oldest first
+    typedef std::tr1::unordered_map<MACAddress, std::deque<PacketQueue::iterator>, MACAddressHash> QueuedByDestination;
+    QueuedByDestination m_rqueueByDst;
     ///\name HWMP-protocol parameters (attributes of GetTypeId)
     ///\{
     uint16_t m_maxQueueSize;
@@ -32,6 +32,10 @@ void Ieee80211Etx::initialize(int stage)
         etxInterval = par("ETXInterval");
         ettInterval = par("ETTInterval");
         etxMeasureInterval = par("ETXMeasureInterval");
+        expectedProbes = etxInterval > 0 ? (int)(etxMeasureInterval/etxInterval) : 1;
+        if (expectedProbes < 1)
+            expectedProbes = 1;
+        ettWindow = par("ETTWindow");
         etxSize = par("ETXSize");
         ettSize1 = par("ETTSize1");
         ettSize2 = par("ETTSize2");
@@ -94,9 +98,14 @@ void Ieee80211Etx::handleTimer(cMessage *msg)
         pkt->setBitLength(etxSize);
         pkt->setSource(myAddress);
         pkt->setDest(MACAddress::BROADCAST_ADDRESS);
+        // one pass: drop the neighbors not heard for too long, report the others
+        pkt->setNeighborsArraySize(neighbors.size());
+        pkt->setRecPacketsArraySize(neighbors.size());
+        int i = 0;
         for (NeighborsMap::iterator it= neighbors.begin(); it!= neighbors.end();)
         {
-            if (simTime()-it->second->getTime()>maxLive)
+            MacEtxNeighbor *neig = it->second;
+            if (simTime()-neig->getTime()>maxLive)
             {
                 NeighborsMap::iterator itAux = it;
                 it++;
@@ -104,17 +113,15 @@ void Ieee80211Etx::handleTimer(cMessage *msg)
                 neighbors.erase(itAux);
                 continue;
             }
-            it++;
-        }
-        pkt->setNeighborsArraySize(neighbors.size());
-        pkt->setRecPacketsArraySize(neighbors.size());
-        int i = 0;
-        for (NeighborsMap::iterator it= neighbors.begin(); it!= neighbors.end(); it++)
-        {
-            pkt->setNeighbors(i,it->second->getAddress());
-            pkt->setRecPackets(i,it->second->timeVector.size());
+            while (!neig->timeVector.empty() && (simTime()-neig->timeVector.front() >  etxMeasureInterval))
+                neig->timeVector.pop_front();
+            pkt->setNeighbors(i,neig->getAddress());
+            pkt->setRecPackets(i,neig->timeVector.size());
             i++;
+            it++;
         }
+        pkt->setNeighborsArraySize(i);
+        pkt->setRecPacketsArraySize(i);
         send(pkt,"toMac");
         scheduleAt(simTime()+par("jitter")+etxInterval,etxTimer);
     }
@@ -126,6 +133,7 @@ void Ieee80211Etx::handleTimer(cMessage *msg)
             {
                 NeighborsMap::iterator itAux = it;
                 it++;
+                delete itAux->second;
                 neighbors.erase(itAux);
                 continue;
             }
@@ -149,25 +157,36 @@ void Ieee80211Etx::handleTimer(cMessage *msg)
     }
 }
 
+MacEtxNeighbor *Ieee80211Etx::addNeighbor(const MACAddress &addr)
+{
+    // the probe window has room for all probes of a measure interval, plus one for jitter
+    MacEtxNeighbor *neig = new MacEtxNeighbor(expectedProbes+1, ettWindow, powerWindow);
+    neig->setAddress(addr);
+    neighbors[addr]=neig;
+    return neig;
+}
+
+void Ieee80211Etx::getDeliveryRatios(MacEtxNeighbor *neig, double &pr, double &ps)
+{
+    while (!neig->timeVector.empty() && (simTime()-neig->timeVector.front() >  etxMeasureInterval))
+        neig->timeVector.pop_front();
+    pr = (double)neig->timeVector.size()/expectedProbes;
+    ps = (double)neig->getPackets()/expectedProbes;
+    if (pr>1) pr=1;
+    if (ps>1) ps=1;
+}
+
 double Ieee80211Etx::getEtx(const MACAddress &add)
 {
     NeighborsMap::iterator it = neighbors.find(add);
-    MacEtxNeighbor *neig;
     if (it==neighbors.end())
     {
         return -1;
     }
     else
     {
-        neig = it->second;
-        int expectedPk = etxMeasureInterval/etxInterval;
-        while (!neig->timeVector.empty() && (simTime()-neig->timeVector.front() >  etxMeasureInterval))
-            neig->timeVector.erase(neig->timeVector.begin());
-        int pkRec = neig->timeVector.size();
-        double pr = pkRec/expectedPk;
-        double ps = neig->getPackets()/expectedPk;
-        if (pr>1) pr=1;
-        if (ps>1) ps=1;
+        double pr, ps;
+        getDeliveryRatios(it->second, pr, ps);
         if (ps ==0 || pr==0)
             return 1e100;
         return 1/(ps*pr);
@@ -189,21 +208,12 @@ double Ieee80211Etx::getEtt(const MACAddress &add)
         neig = it->second;
         if (neig->timeETT.empty())
             return -1;
-        int expectedPk = etxMeasureInterval/etxInterval;
-        while (!neig->timeVector.empty() && (simTime()-neig->timeVector.front() >  etxMeasureInterval))
-            neig->timeVector.erase(neig->timeVector.begin());
-        int pkRec = neig->timeVector.size();
-        double pr = pkRec/expectedPk;
-        double ps = neig->getPackets()/expectedPk;
-        if (pr>1) pr=1;
-        if (ps>1) ps=1;
+        double pr, ps;
+        getDeliveryRatios(neig, pr, ps);
         if (ps ==0 || pr==0)
             return 1e100;
         double etx =  1/(ps*pr);
-        simtime_t minTime = 100.0;
-        for (unsigned int i =0; i<neig->timeETT.size(); i++)
-            if (minTime>neig->timeETT[i])
-                minTime=neig->timeETT[i];
+        simtime_t minTime = neig->timeETT.getMin();
         double bw= ettSize2/minTime;
         return etx*(etxSize/bw);
     }
@@ -212,85 +222,48 @@ double Ieee80211Etx::getEtt(const MACAddress &add)
 double Ieee80211Etx::getPrec(const MACAddress &add)
 {
     NeighborsMap::iterator it = neighbors.find(add);
-    MacEtxNeighbor *neig;
     if (it==neighbors.end())
     {
         return 0;
     }
     else
     {
-        neig = it->second;
-        if (neig->signalToNoiseAndSignal.empty())
+        SNRWindow &window = it->second->signalToNoiseAndSignal;
+        window.expire(powerWindowTime);
+        if (window.empty())
             return 0;
-
-        double sum=0;
-        std::vector<SNRDataTime>::iterator itNeig;
-
-        for (itNeig = neig->signalToNoiseAndSignal.begin();itNeig!=neig->signalToNoiseAndSignal.end();)
-        {
-            if ((simTime()- itNeig->snrTime)>powerWindowTime)
-            {
-                std::vector<SNRDataTime>::iterator itAux =itNeig+1;
-                neig->signalToNoiseAndSignal.erase(itNeig);
-                itNeig = itAux;
-                continue;
-            }
-            sum += itNeig->signalPower;
-            itNeig++;
-        }
-        return sum/neig->signalToNoiseAndSignal.size();
+        return window.getMeanPower();
     }
 }
 
 double Ieee80211Etx::getSignalToNoise(const MACAddress &add)
 {
     NeighborsMap::iterator it = neighbors.find(add);
-    MacEtxNeighbor *neig;
     if (it==neighbors.end())
     {
         return 0;
     }
     else
     {
-        neig = it->second;
-        if (neig->signalToNoiseAndSignal.empty())
+        SNRWindow &window = it->second->signalToNoiseAndSignal;
+        window.expire(powerWindowTime);
+        if (window.empty())
             return 0;
-
-        double sum=0;
-        std::vector<SNRDataTime>::iterator itNeig;
-
-        for (itNeig = neig->signalToNoiseAndSignal.begin();itNeig!=neig->signalToNoiseAndSignal.end();)
-        {
-            if ((simTime()- itNeig->snrTime)>powerWindowTime)
-            {
-                std::vector<SNRDataTime>::iterator itAux =itNeig+1;
-                neig->signalToNoiseAndSignal.erase(itNeig);
-                itNeig = itAux;
-                continue;
-            }
-            sum += itNeig->snrData;
-            itNeig++;
-        }
-        return sum/neig->signalToNoiseAndSignal.size();
+        return window.getMeanSnr();
     }
 }
 
 double Ieee80211Etx::getPacketErrorToNeigh(const MACAddress &add)
 {
     NeighborsMap::iterator it = neighbors.find(add);
-    MacEtxNeighbor *neig;
     if (it==neighbors.end())
     {
         return -1;
     }
     else
     {
-        neig = it->second;
-        int expectedPk = etxMeasureInterval/etxInterval;
-        while (!neig->timeVector.empty() && (simTime()-neig->timeVector.front() >  etxMeasureInterval))
-            neig->timeVector.erase(neig->timeVector.begin());
-        double ps = neig->getPackets()/expectedPk;
-        if (ps>1) ps=1;
+        double pr, ps;
+        getDeliveryRatios(it->second, pr, ps);
         return 1-ps;
     }
 }
@@ -298,20 +271,14 @@ double Ieee80211Etx::getPacketErrorToNeigh(const MACAddress &add)
 double Ieee80211Etx::getPacketErrorFromNeigh(const MACAddress &add)
 {
     NeighborsMap::iterator it = neighbors.find(add);
-    MacEtxNeighbor *neig;
     if (it==neighbors.end())
     {
         return -1;
     }
     else
     {
-        neig = it->second;
-        int expectedPk = etxMeasureInterval/etxInterval;
-        while (!neig->timeVector.empty() && (simTime()-neig->timeVector.front() >  etxMeasureInterval))
-            neig->timeVector.erase(neig->timeVector.begin());
-        int pkRec = neig->timeVector.size();
-        double pr = pkRec/expectedPk;
-        if (pr>1) pr=1;
+        double pr, ps;
+        getDeliveryRatios(it->second, pr, ps);
         return 1-pr;
     }
 }
@@ -321,15 +288,11 @@ void Ieee80211Etx::handleEtxMessage(MACETXPacket *msg)
     NeighborsMap::iterator it = neighbors.find(msg->getSource());
     MacEtxNeighbor *neig;
     if (it==neighbors.end())
-    {
-        neig = new MacEtxNeighbor;
-        neig->setAddress(msg->getSource());
-        neighbors[msg->getSource()]=neig;
-    }
+        neig = addNeighbor(msg->getSource());
     else
         neig = it->second;
     while (!neig->timeVector.empty() && (simTime()-neig->timeVector.front() >  etxMeasureInterval))
-        neig->timeVector.erase(neig->timeVector.begin());
+        neig->timeVector.pop_front();
 
     neig->timeVector.push_back(simTime());
     neig->setTime(simTime());
@@ -376,25 +339,22 @@ void Ieee80211Etx::handleBwMessage(MACBwPacket *msg)
                 send(msg,"toMac");
             }
             else
+            {
                 prevAddress = MACAddress::UNSPECIFIED_ADDRESS;
-
+                delete msg;
+            }
         }
+        else
+            delete msg;
         return;
     }
 
     if (!neig)
-    {
-        neig = new MacEtxNeighbor;
-        neig->setAddress(msg->getSource());
-        neighbors[msg->getSource()]=neig;
-    }
+        neig = addNeighbor(msg->getSource());
 
     if (msg->getByteLength()==ettSize1)
-    {
-        if (neig->timeETT.size()> (unsigned int)ettWindow)
-            neig->timeETT.erase(neig->timeETT.begin());
-        neig->timeETT.push_back(msg->getTime());
-    }
+        neig->timeETT.add(msg->getTime());
+    delete msg;
 }
 
 void Ieee80211Etx::getNeighbors(std::vector<MACAddress> & add)
@@ -442,21 +402,11 @@ void Ieee80211Etx::receiveChangeNotification(int category, const cPolymorphic *d
             Radio80211aControlInfo * cinfo = dynamic_cast<Radio80211aControlInfo *> (frame->getControlInfo());
             if (cinfo)
             {
+                MacEtxNeighbor *neig;
                 if (it==neighbors.end())
-                {
-                    // insert new element
-                    MacEtxNeighbor *neig = new MacEtxNeighbor;
-                    neig->setAddress(frame->getTransmitterAddress());
-                    neighbors.insert(std::pair<MACAddress, MacEtxNeighbor*>(frame->getTransmitterAddress(),neig));
-                    it = neighbors.find(frame->getTransmitterAddress());
-                }
-                if (!it->second->signalToNoiseAndSignal.empty())
-                {
-                    while ((int)it->second->signalToNoiseAndSignal.size()>powerWindow-1)
-                        it->second->signalToNoiseAndSignal.erase(it->second->signalToNoiseAndSignal.begin());
-                    while (simTime() - it->second->signalToNoiseAndSignal.front().snrTime>powerWindowTime && !it->second->signalToNoiseAndSignal.empty())
-                        it->second->signalToNoiseAndSignal.erase(it->second->signalToNoiseAndSignal.begin());
-                }
+                    neig = addNeighbor(frame->getTransmitterAddress());
+                else
+                    neig = it->second;
 
                 SNRDataTime snrDataTime;
                 snrDataTime.signalPower=cinfo->getRecPow();
@@ -469,20 +419,12 @@ void Ieee80211Etx::receiveChangeNotification(int category, const cPolymorphic *d
                 	snrDataTime.airtimeValue = (uint32_t)ceil((snrDataTime.testFrameDuration/10.24e-6)/(1-snrDataTime.testFrameError));
                 else
                 	snrDataTime.airtimeValue = 0xFFFFFFF;
-                it->second->signalToNoiseAndSignal.push_back(snrDataTime);
+                neig->signalToNoiseAndSignal.expire(powerWindowTime);
+                neig->signalToNoiseAndSignal.add(snrDataTime);
                 if (snrDataTime.airtimeMetric)
-                {
-                	// found the best
-                	uint32_t cost = 0xFFFFFFFF;
-                	for (unsigned int i = 0; i < it->second->signalToNoiseAndSignal.size(); i++)
-                	{
-                		if (it->second->signalToNoiseAndSignal[i].airtimeMetric && cost > it->second->signalToNoiseAndSignal[i].airtimeValue)
-                			cost = it->second->signalToNoiseAndSignal[i].airtimeValue;
-                	}
-                	it->second->setAirtimeMetric(cost);
-                }
+                	neig->setAirtimeMetric(neig->signalToNoiseAndSignal.getMinAirtime()); // the best one in the window
                 else
-                	it->second->setAirtimeMetric(0xFFFFFFF);
+                	neig->setAirtimeMetric(0xFFFFFFF);
             }
         }
     }
@@ -494,10 +436,10 @@ uint32_t Ieee80211Etx::getAirtimeMetric(const MACAddress &addr)
     NeighborsMap::iterator it = neighbors.find(addr);
     if (it!=neighbors.end())
     {
-        while (!it->second->signalToNoiseAndSignal.empty() && (simTime() - it->second->signalToNoiseAndSignal.front().snrTime > powerWindowTime))
-            it->second->signalToNoiseAndSignal.erase(it->second->signalToNoiseAndSignal.begin());
+        it->second->signalToNoiseAndSignal.expire(powerWindowTime);
         if (it->second->signalToNoiseAndSignal.empty() && (simTime()-it->second->getTime()>maxLive))
         {
+            delete it->second;
             neighbors.erase(it);
             return 0xFFFFFFF;
         }
@@ -516,19 +458,19 @@ void Ieee80211Etx::getAirtimeMetricNeighbors(std::vector<MACAddress> &addr,std::
 	cost.clear();
 	for (NeighborsMap::iterator it =neighbors.begin();it!=neighbors.end();)
 	{
-        while (simTime() - it->second->signalToNoiseAndSignal.front().snrTime>powerWindowTime)
-            it->second->signalToNoiseAndSignal.erase(it->second->signalToNoiseAndSignal.begin());
+        it->second->signalToNoiseAndSignal.expire(powerWindowTime);
         if (it->second->signalToNoiseAndSignal.empty() && (simTime()-it->second->getTime()>maxLive))
         {
             NeighborsMap::iterator itAux = it;
             it++;
+            delete itAux->second;
             neighbors.erase(itAux);
         }
         else if (it->second->signalToNoiseAndSignal.empty())
         {
             it++;
         }
-        else if (it->second->signalToNoiseAndSignal.empty())
+        else
         {
             addr.push_back(it->first);
             cost.push_back(it->second->getAirtimeMetric());
@@ -20,10 +20,12 @@
 #define IEEE80211_ETX_ADHOC_H
 
 #include <omnetpp.h>
+#include "INETHashMap.h"
 #include "uint128.h"
 #include "IInterfaceTable.h"
 #include "ETXPacket_m.h"
 #include "NotificationBoard.h"
+#include "RingBuffer.h"
 
 /**
  *
@@ -52,6 +54,86 @@
     }
 }; // Store information about the SNR and the time that that measure was store
 
+/**
+ * The S/N and power samples of a neighbor: at most a fixed number of
+ * them, none older than the power window time. The averages and the best
+ * airtime cost are kept up to date as samples come and go, so neither
+ * needs a pass over the window.
+ */
+class SNRWindow
+{
+  protected:
+    RingBuffer<SNRDataTime> samples;
+    RingBufferMin<uint32_t> airtime; // airtime cost of each sample, 0xFFFFFFFF if it has none
+    double sumSnr;
+    double sumPower;
+
+    void removeOldest()
+    {
+        sumSnr -= samples.front().snrData;
+        sumPower -= samples.front().signalPower;
+        samples.pop_front();
+        airtime.pop();
+        if (samples.empty())
+            sumSnr = sumPower = 0; // do not let rounding errors accumulate
+    }
+
+  public:
+    SNRWindow() : sumSnr(0), sumPower(0) {}
+    void setCapacity(unsigned int capacity)
+    {
+        samples.setCapacity(capacity);
+        airtime.setCapacity(capacity);
+        sumSnr = sumPower = 0;
+    }
+    void add(const SNRDataTime &sample)
+    {
+        if (samples.full())
+            removeOldest();
+        samples.push_back(sample);
+        airtime.push(sample.airtimeMetric ? sample.airtimeValue : 0xFFFFFFFF);
+        sumSnr += sample.snrData;
+        sumPower += sample.signalPower;
+    }
+    /** Drops the samples taken more than maxAge ago */
+    void expire(simtime_t maxAge)
+    {
+        while (!samples.empty() && simTime() - samples.front().snrTime > maxAge)
+            removeOldest();
+    }
+    bool empty() const {return samples.empty();}
+    unsigned int size() const {return samples.size();}
+    double getMeanSnr() const {return sumSnr / samples.size();}
+    double getMeanPower() const {return sumPower / samples.size();}
+    /** Lowest airtime cost of the samples that have one, 0xFFFFFFFF if none has */
+    uint32_t getMinAirtime() const {return airtime.get();}
+};
+
+/**
+ * The last ETT probe pair delays measured to a neighbor, and their minimum
+ */
+class ETTWindow
+{
+  protected:
+    RingBuffer<simtime_t> samples;
+    RingBufferMin<simtime_t> minimum;
+
+  public:
+    void setCapacity(unsigned int capacity) {samples.setCapacity(capacity); minimum.setCapacity(capacity);}
+    void add(simtime_t t)
+    {
+        if (samples.full())
+        {
+            samples.pop_front();
+            minimum.pop();
+        }
+        samples.push_back(t);
+        minimum.push(t);
+    }
+    bool empty() const {return samples.empty();}
+    simtime_t getMin() const {return minimum.get();}
+};
+
 class MacEtxNeighbor
 {
   private:
@@ -64,16 +146,16 @@ class MacEtxNeighbor
     int     packets;
     int     numFailures;
   public:
-    std::vector<simtime_t> timeVector;
-    std::vector<simtime_t> timeETT;
-    std::vector<SNRDataTime> signalToNoiseAndSignal;// S/N received
+    RingBuffer<simtime_t> timeVector; // reception times of the ETX probes in the measure interval
+    ETTWindow timeETT;
+    SNRWindow signalToNoiseAndSignal;// S/N received
   public:
-    MacEtxNeighbor() {packets = 0; time=0; numFailures=0;}
-    ~MacEtxNeighbor()
+    MacEtxNeighbor(int etxWindow, int ettWindow, int powerWindow)
     {
-        timeVector.clear();
-        timeETT.clear();
-        signalToNoiseAndSignal.clear();
+        packets = 0; time=0; numFailures=0;
+        timeVector.setCapacity(etxWindow);
+        timeETT.setCapacity(ettWindow);
+        signalToNoiseAndSignal.setCapacity(powerWindow);
     }
     // this vector store a window of values
     void setAddress(const MACAddress &addr) {address = addr;}
@@ -98,7 +180,7 @@ class MacEtxNeighbor
     void  setAirtimeMetric(uint32_t p) {airTimeMetric=p;}
 };
 
-typedef std::map<MACAddress,MacEtxNeighbor*> NeighborsMap;
+typedef std::tr1::unordered_map<MACAddress,MacEtxNeighbor*,MACAddressHash> NeighborsMap;
 
 class INET_API Ieee80211Etx : public cSimpleModule,public MacEstimateCostProcess, public INotifiable
 {
@@ -110,6 +192,7 @@ class INET_API Ieee80211Etx : public cSimpleModule,public MacEstimateCostProcess
     simtime_t etxInterval;
     simtime_t ettInterval;
     simtime_t etxMeasureInterval;
+    int expectedProbes; // ETX probes sent in a measure interval
     int ettWindow;
     int etxSize;
     int ettSize1;
@@ -121,6 +204,11 @@ class INET_API Ieee80211Etx : public cSimpleModule,public MacEstimateCostProcess
     simtime_t powerWindowTime;
 
 
+  protected:
+    MacEtxNeighbor *addNeighbor(const MACAddress &addr);
+    /** Fractions of the expected ETX probes received from (pr) and by (ps) the neighbor */
+    void getDeliveryRatios(MacEtxNeighbor *neig, double &pr, double &ps);
+
   protected:
     virtual int numInitStages() const {return 3;}
     virtual void initialize(int);
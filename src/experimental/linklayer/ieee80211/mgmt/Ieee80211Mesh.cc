@@ -68,6 +68,7 @@ Ieee80211Mesh::Ieee80211Mesh()
     WMPLSCHECKMAC =NULL;
     //
     macBaseGateId = -1;
+    routeGeneration = 0;
 }
 
 void Ieee80211Mesh::initialize(int stage)
@@ -83,6 +84,7 @@ void Ieee80211Mesh::initialize(int stage)
         maxHopProactive = par("maxHopProactive");
         maxHopReactive = par("maxHopReactive");
         maxTTL=par("maxTTL");
+        forwardingCacheTimeout = par("forwardingCacheTimeout");
     }
     else if (stage==1)
     {
@@ -146,6 +148,7 @@ void Ieee80211Mesh::initialize(int stage)
         nb = NotificationBoardAccess().get();
         nb->subscribe(this, NF_LINK_BREAK);
         nb->subscribe(this,NF_LINK_REFRESH);
+        nb->subscribe(this,NF_MESH_ROUTE_CHANGED);
     }
     else if (stage==5)
     {
@@ -452,6 +455,10 @@ Ieee80211DataFrame *Ieee80211Mesh::encapsulate(cPacket *msg)
         }
         forwarding_ptr->last_use=simTime();
     }
+    else if (!useLwmpls && findCachedNextHop(dest,next))
+    {
+        // the routing modules were asked for this destination before
+    }
     else
     {
         std::vector<Uint128> add;
@@ -521,6 +528,8 @@ Ieee80211DataFrame *Ieee80211Mesh::encapsulate(cPacket *msg)
             }
         }
         next=add[0];
+        if (!useLwmpls)
+            cacheNextHop(dest,next);
         if (dist >1 && useLwmpls)
         {
             lwmplspk = new LWMPLSPacket(msg->getName());
@@ -622,13 +631,19 @@ void Ieee80211Mesh::receiveChangeNotification(int category, const cPolymorphic *
     Enter_Method_Silent();
     printNotificationBanner(category, details);
 
+    if (category == NF_MESH_ROUTE_CHANGED)
+    {
+        // stale entries are dropped when they are looked up
+        routeGeneration++;
+        return;
+    }
+
     if (details==NULL)
         return;
 
     if (category == NF_LINK_BREAK)
     {
-        if (details==NULL)
-            return;
+        routeGeneration++;
         Ieee80211TwoAddressFrame *frame  = dynamic_cast<Ieee80211TwoAddressFrame *>(const_cast<cPolymorphic*> (details));
         if (frame)
         {
@@ -844,10 +859,15 @@ bool Ieee80211Mesh::macLabelBasedSend (Ieee80211DataFrame *frame)
         return true;
     }
 
+    MACAddress nextHop;
     if (next)
     {
         frame->setReceiverAddress(Uint64ToMac(next));
     }
+    else if (findCachedNextHop(frame->getAddress4(),nextHop))
+    {
+        frame->setReceiverAddress(nextHop);
+    }
     else
     {
         std::vector<Uint128> add;
@@ -907,6 +927,7 @@ bool Ieee80211Mesh::macLabelBasedSend (Ieee80211DataFrame *frame)
         else
         {
             frame->setReceiverAddress(add[0].getMACAddress());
+            cacheNextHop(frame->getAddress4(),frame->getReceiverAddress());
         }
 
     }
@@ -916,6 +937,30 @@ bool Ieee80211Mesh::macLabelBasedSend (Ieee80211DataFrame *frame)
     return true;
 }
 
+bool Ieee80211Mesh::findCachedNextHop(const MACAddress &dest,MACAddress &next)
+{
+    ForwardingCache::iterator it = forwardingCache.find(dest);
+    if (it==forwardingCache.end())
+        return false;
+    if (it->second.generation!=routeGeneration || it->second.expires<=simTime())
+    {
+        forwardingCache.erase(it);
+        return false;
+    }
+    next = it->second.nextHop;
+    return true;
+}
+
+void Ieee80211Mesh::cacheNextHop(const MACAddress &dest,const MACAddress &next)
+{
+    if (forwardingCacheTimeout<=0)
+        return;
+    ForwardingCacheEntry &entry = forwardingCache[dest];
+    entry.nextHop = next;
+    entry.expires = simTime()+forwardingCacheTimeout;
+    entry.generation = routeGeneration;
+}
+
 void Ieee80211Mesh::sendUp(cMessage *msg)
 {
     if (isUpperLayer(msg))
@@ -64,6 +64,21 @@ private:
     bool activeMacBreak;
     int macBaseGateId;  // id of the nicOut[0] gate
 
+    // Next hop per final destination, as answered by the routing modules.
+    // An entry is only valid in the route generation it was stored in (every
+    // route change starts a new one) and for forwardingCacheTimeout, as the
+    // protocols let routes expire without telling
+    struct ForwardingCacheEntry
+    {
+        MACAddress nextHop;
+        simtime_t expires;
+        unsigned int generation;
+    };
+    typedef std::tr1::unordered_map<MACAddress,ForwardingCacheEntry,MACAddressHash> ForwardingCache;
+    ForwardingCache forwardingCache;
+    unsigned int routeGeneration;
+    simtime_t forwardingCacheTimeout;
+
     // start routing proccess
     virtual void startReactive();
     virtual void startProactive();
@@ -89,6 +104,8 @@ private:
     virtual bool forwardMessage (Ieee80211DataFrame *);
     virtual bool macLabelBasedSend (Ieee80211DataFrame *);
     virtual void actualizeReactive(cPacket *pkt,bool out);
+    virtual bool findCachedNextHop(const MACAddress &dest,MACAddress &next);
+    virtual void cacheNextHop(const MACAddress &dest,const MACAddress &next);
 
 
     static uint64_t MacToUint64(const MACAddress &add)
@@ -0,0 +1,110 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef __INET_RINGBUFFER_H
+#define __INET_RINGBUFFER_H
+
+#include <vector>
+#include <utility>
+#include <omnetpp.h>
+
+/**
+ * FIFO of at most a fixed number of elements, kept in a circular array.
+ * Pushing onto a full buffer drops the oldest element.
+ */
+template <class T>
+class RingBuffer
+{
+  protected:
+    std::vector<T> items;
+    unsigned int head;
+    unsigned int count;
+
+  public:
+    RingBuffer(unsigned int capacity = 1) : items(capacity > 0 ? capacity : 1), head(0), count(0) {}
+
+    /** Sets the capacity; the buffer is emptied */
+    void setCapacity(unsigned int capacity) {
+        items.assign(capacity > 0 ? capacity : 1, T());
+        head = count = 0;
+    }
+    unsigned int capacity() const {return items.size();}
+    unsigned int size() const {return count;}
+    bool empty() const {return count == 0;}
+    bool full() const {return count == items.size();}
+    void clear() {head = count = 0;}
+
+    /** The i-th element, counted from the oldest one */
+    const T& operator[](unsigned int i) const {return items[(head + i) % items.size()];}
+    const T& front() const {return items[head];}
+    const T& back() const {return (*this)[count - 1];}
+
+    void push_back(const T& x) {
+        if (full())
+            pop_front();
+        items[(head + count) % items.size()] = x;
+        count++;
+    }
+    void pop_front() {
+        ASSERT(count > 0);
+        head = (head + 1) % items.size();
+        count--;
+    }
+    void pop_back() {
+        ASSERT(count > 0);
+        count--;
+    }
+};
+
+/**
+ * Minimum of a sliding window of values: values are added at one end and
+ * removed in the same order at the other. Only the values that may still
+ * become the minimum are kept (in increasing order), so every operation
+ * is O(1) amortized. The capacity must be at least the window size.
+ */
+template <class T>
+class RingBufferMin
+{
+  protected:
+    RingBuffer<std::pair<T, unsigned long> > candidates; // value and sequence number
+    unsigned long nextSeq;  // sequence number of the next value added
+    unsigned long firstSeq; // sequence number of the oldest value in the window
+
+  public:
+    RingBufferMin(unsigned int capacity = 1) : candidates(capacity), nextSeq(0), firstSeq(0) {}
+
+    void setCapacity(unsigned int capacity) {candidates.setCapacity(capacity); nextSeq = firstSeq = 0;}
+    bool empty() const {return candidates.empty();}
+    void clear() {candidates.clear(); nextSeq = firstSeq = 0;}
+
+    /** Adds a value at the new end of the window */
+    void push(const T& x) {
+        while (!candidates.empty() && !(candidates.back().first < x))
+            candidates.pop_back();
+        candidates.push_back(std::make_pair(x, nextSeq++));
+    }
+    /** Removes the oldest value of the window */
+    void pop() {
+        if (!candidates.empty() && candidates.front().second == firstSeq)
+            candidates.pop_front();
+        firstSeq++;
+    }
+    /** The smallest value in the window; the window must not be empty */
+    const T& get() const {return candidates.front().first;}
+};
+
+#endif
+
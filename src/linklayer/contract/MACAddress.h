@@ -98,6 +98,15 @@ class INET_API MACAddress
      */
     unsigned char *getAddressBytes() {return address;}
 
+    /**
+     * Returns the address as a 48-bit integer, first byte being the most
+     * significant. Useful as a hash key.
+     */
+    uint64 getInt() const {
+        return ((uint64)address[0]<<40) | ((uint64)address[1]<<32) | ((uint64)address[2]<<24) |
+               ((uint64)address[3]<<16) | ((uint64)address[4]<<8) | (uint64)address[5];
+    }
+
     /**
      * Sets address bytes. The argument should point to an array of 6 unsigned chars.
      */
@@ -411,9 +411,10 @@ void EtherMAC::handleEndIFGPeriod()
 
 void EtherMAC::startFrameTransmission()
 {
-    cPacket *origFrame = (cPacket *)txQueue.front();
-    EV << "Transmitting a copy of frame " << origFrame << endl;
-    cPacket *frame = origFrame->dup();
+    // in half-duplex mode the frame may collide and have to be retransmitted,
+    // so only a copy is sent
+    cPacket *frame = takeFrameForTransmission(!duplexMode);
+    EV << "Transmitting frame " << frame << endl;
 
     // add preamble and SFD (Starting Frame Delimiter), then send out
     frame->addByteLength(PREAMBLE_BYTES+SFD_BYTES);
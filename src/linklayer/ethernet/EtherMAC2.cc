@@ -89,10 +89,9 @@ void EtherMAC2::handleMessage(cMessage *msg)
 
 void EtherMAC2::startFrameTransmission()
 {
-    EtherFrame *origFrame = (EtherFrame *)txQueue.front();
-    EV << "Transmitting a copy of frame " << origFrame << endl;
-
-    EtherFrame *frame = (EtherFrame *) origFrame->dup();
+    // full duplex: no collisions, so the frame is only needed again for
+    // the end of transmission notification
+    EtherFrame *frame = check_and_cast<EtherFrame *>(takeFrameForTransmission(hasSubscribers));
     frame->addByteLength(PREAMBLE_BYTES+SFD_BYTES);
 
     if (hasSubscribers)
@@ -152,7 +151,7 @@ void EtherMAC2::handleEndIFGPeriod()
 
 void EtherMAC2::handleEndTxPeriod()
 {
-    if (hasSubscribers)
+    if (hasSubscribers && curTxFrameInQueue)
     {
         // fire notification
         notifDetails.setPacket((cPacket *)txQueue.front());
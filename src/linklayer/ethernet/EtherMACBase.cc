@@ -75,6 +75,10 @@ void EtherMACBase::initialize()
     pauseUnitsRequested = 0;
     WATCH(pauseUnitsRequested);
 
+    curTxFrameBytes = 0;
+    curTxFrameIsPause = false;
+    curTxFrameInQueue = false;
+
     // initialize queue limit
     txQueueLimit = par("txQueueLimit");
     WATCH(txQueueLimit);
@@ -453,25 +457,27 @@ void EtherMACBase::handleEndTxPeriod()
     if (transmitState!=TRANSMITTING_STATE || (!duplexMode && receiveState!=RX_IDLE_STATE))
         error("End of transmission, and incorrect state detected");
 
-    if (txQueue.empty())
-        error("Frame under transmission cannot be found");
-
-    // get frame from buffer
-    cPacket *frame = (cPacket *)txQueue.pop();
+    // drop the frame from the buffer if only a copy of it was sent
+    if (curTxFrameInQueue)
+    {
+        if (txQueue.empty())
+            error("Frame under transmission cannot be found");
+        delete txQueue.pop();
+        curTxFrameInQueue = false;
+    }
 
     numFramesSent++;
-    numBytesSent += frame->getByteLength();
+    numBytesSent += curTxFrameBytes;
     numFramesSentVector.record(numFramesSent);
     numBytesSentVector.record(numBytesSent);
 
-    if (dynamic_cast<EtherPauseFrame*>(frame)!=NULL)
+    if (curTxFrameIsPause)
     {
         numPauseFramesSent++;
         numPauseFramesSentVector.record(numPauseFramesSent);
     }
 
-    EV << "Transmission of " << frame << " successfully completed\n";
-    delete frame;
+    EV << "Transmission of frame successfully completed\n";
 }
 
 void EtherMACBase::handleEndPausePeriod()
@@ -530,6 +536,21 @@ bool EtherMACBase::checkAndScheduleEndPausePeriod()
     return false;
 }
 
+/**
+ * Returns the frame at the front of txQueue, for sending it out. If it may
+ * be needed again (for retransmission after a collision, or for the end of
+ * transmission notification), it stays in the queue and a copy is returned;
+ * otherwise the frame itself is taken out of the queue and returned.
+ */
+cPacket *EtherMACBase::takeFrameForTransmission(bool keepInQueue)
+{
+    cPacket *frame = (cPacket *)txQueue.front();
+    curTxFrameBytes = frame->getByteLength();
+    curTxFrameIsPause = dynamic_cast<EtherPauseFrame*>(frame)!=NULL;
+    curTxFrameInQueue = keepInQueue;
+    return keepInQueue ? frame->dup() : (cPacket *)txQueue.pop();
+}
+
 void EtherMACBase::beginSendFrames()
 {
     if (!txQueue.empty())
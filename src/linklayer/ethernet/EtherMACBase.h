@@ -87,6 +87,11 @@ class INET_API EtherMACBase : public cSimpleModule, public INotifiable, public I
     int receiveState;               // State of the MAC unit receiving
     int pauseUnitsRequested;        // requested pause duration, or zero -- examined at endTx
 
+    // frame being transmitted, for the statistics at endTx
+    long curTxFrameBytes;           // its length, without preamble and SFD
+    bool curTxFrameIsPause;         // whether it is a PAUSE frame
+    bool curTxFrameInQueue;         // whether it is still at the front of txQueue (only a copy was sent)
+
     cQueue txQueue;                 // output queue
     IPassiveQueue *queueModule;     // optional module to receive messages from
 
@@ -166,6 +171,7 @@ class INET_API EtherMACBase : public cSimpleModule, public INotifiable, public I
 
     // helpers
     virtual bool checkAndScheduleEndPausePeriod();
+    virtual cPacket *takeFrameForTransmission(bool keepInQueue);
     virtual void fireChangeNotification(int type, cPacket *msg);
     virtual void beginSendFrames();
     virtual void frameReceptionComplete(EtherFrame *frame);
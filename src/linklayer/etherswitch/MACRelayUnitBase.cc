@@ -75,14 +75,14 @@ void MACRelayUnitBase::initialize()
     agingTime = par("agingTime");
     agingTime = agingTime > 0 ? agingTime : 10;
 
+    oldestEntry = newestEntry = NULL;
+
     // Option to pre-read in Address Table. To turn ot off, set addressTableFile to empty string
     const char *addressTableFile = par("addressTableFile");
     if (addressTableFile && *addressTableFile)
         readAddressTable(addressTableFile);
 
     seqNum = 0;
-
-    WATCH_MAP(addresstable);
 }
 
 void MACRelayUnitBase::handleAndDispatchFrame(EtherFrame *frame, int inputport)
@@ -122,58 +122,85 @@ void MACRelayUnitBase::handleAndDispatchFrame(EtherFrame *frame, int inputport)
 
 void MACRelayUnitBase::broadcastFrame(EtherFrame *frame, int inputport)
 {
-    for (int i=0; i<numPorts; ++i)
+    // Only the frame itself gets copied for each port: the encapsulated
+    // packet is shared among the copies by the simulation kernel (reference
+    // counted), and only gets duplicated if a receiver decapsulates it or
+    // otherwise modifies it. The last port gets the original frame.
+    int lastPort = (inputport==numPorts-1) ? numPorts-2 : numPorts-1;
+    if (lastPort<0)
+    {
+        delete frame;
+        return;
+    }
+    for (int i=0; i<lastPort; ++i)
         if (i!=inputport)
             send((EtherFrame*)frame->dup(), "lowerLayerOut", i);
-    delete frame;
+    send(frame, "lowerLayerOut", lastPort);
 }
 
 void MACRelayUnitBase::printAddressTable()
 {
-    AddressTable::iterator iter;
+    // print in aging order, oldest first
     EV << "Address Table (" << addresstable.size() << " entries):\n";
-    for (iter = addresstable.begin(); iter!=addresstable.end(); ++iter)
+    for (AddressEntry *entry = oldestEntry; entry; entry = entry->newer)
     {
-        EV << "  " << iter->first << " --> port" << iter->second.portno <<
-              (iter->second.insertionTime+agingTime <= simTime() ? " (aged)" : "") << endl;
+        EV << "  " << entry->address << " --> port" << entry->portno <<
+              (entry->insertionTime+agingTime <= simTime() ? " (aged)" : "") << endl;
     }
 }
 
 void MACRelayUnitBase::removeAgedEntriesFromTable()
 {
-    for (AddressTable::iterator iter = addresstable.begin(); iter != addresstable.end();)
+    // the aging list is ordered by insertionTime, so aged entries are all at its front
+    while (oldestEntry && oldestEntry->insertionTime + agingTime <= simTime())
     {
-        AddressTable::iterator cur = iter++; // iter will get invalidated after erase()
-        AddressEntry& entry = cur->second;
-        if (entry.insertionTime + agingTime <= simTime())
-        {
-            EV << "Removing aged entry from Address Table: " <<
-                  cur->first << " --> port" << cur->second.portno << "\n";
-            addresstable.erase(cur);
-        }
+        EV << "Removing aged entry from Address Table: " <<
+              oldestEntry->address << " --> port" << oldestEntry->portno << "\n";
+        removeTableEntry(addresstable.find(oldestEntry->address));
     }
 }
 
 void MACRelayUnitBase::removeOldestTableEntry()
 {
-    AddressTable::iterator oldest = addresstable.end();
-    simtime_t oldestInsertTime = simTime()+1;
-    for (AddressTable::iterator iter = addresstable.begin(); iter != addresstable.end(); iter++)
-    {
-        if (iter->second.insertionTime < oldestInsertTime)
-        {
-            oldest = iter;
-            oldestInsertTime = iter->second.insertionTime;
-        }
-    }
-    if (oldest != addresstable.end())
+    if (oldestEntry)
     {
         EV << "Table full, removing oldest entry: " <<
-              oldest->first << " --> port" << oldest->second.portno << "\n";
-        addresstable.erase(oldest);
+              oldestEntry->address << " --> port" << oldestEntry->portno << "\n";
+        removeTableEntry(addresstable.find(oldestEntry->address));
     }
 }
 
+void MACRelayUnitBase::removeTableEntry(AddressTable::iterator iter)
+{
+    ASSERT(iter != addresstable.end());
+    unlinkEntry(&iter->second);
+    addresstable.erase(iter);
+}
+
+void MACRelayUnitBase::linkAsNewest(AddressEntry *entry)
+{
+    entry->older = newestEntry;
+    entry->newer = NULL;
+    if (newestEntry)
+        newestEntry->newer = entry;
+    else
+        oldestEntry = entry;
+    newestEntry = entry;
+}
+
+void MACRelayUnitBase::unlinkEntry(AddressEntry *entry)
+{
+    if (entry->older)
+        entry->older->newer = entry->newer;
+    else
+        oldestEntry = entry->newer;
+    if (entry->newer)
+        entry->newer->older = entry->older;
+    else
+        newestEntry = entry->older;
+    entry->older = entry->newer = NULL;
+}
+
 void MACRelayUnitBase::updateTableWithAddress(MACAddress& address, int portno)
 {
     AddressTable::iterator iter;
@@ -194,18 +221,21 @@ void MACRelayUnitBase::updateTableWithAddress(MACAddress& address, int portno)
 
         // Add entry to table
         EV << "Adding entry to Address Table: "<< address << " --> port" << portno << "\n";
-        AddressEntry entry;
+        AddressEntry& entry = addresstable[address];
         entry.portno = portno;
         entry.insertionTime = simTime();
-        addresstable[address] = entry;
+        entry.address = address;
+        linkAsNewest(&entry);
     }
     else
     {
-        // Update existing entry
+        // Update existing entry, and move it to the newest end of the aging list
         EV << "Updating entry in Address Table: "<< address << " --> port" << portno << "\n";
         AddressEntry& entry = iter->second;
         entry.insertionTime = simTime();
         entry.portno = portno;
+        unlinkEntry(&entry);
+        linkAsNewest(&entry);
     }
 }
 
@@ -221,7 +251,7 @@ int MACRelayUnitBase::getPortForAddress(MACAddress& address)
     {
         // don't use (and throw out) aged entries
         EV << "Ignoring and deleting aged entry: "<< iter->first << " --> port" << iter->second.portno << "\n";
-        addresstable.erase(iter);
+        removeTableEntry(iter);
         return -1;
     }
     return iter->second.portno;
@@ -268,10 +298,15 @@ void MACRelayUnitBase::readAddressTable(const char* fileName)
             error("line %d invalid in address table file `%s'", lineno, fileName);
 
         // Create an entry with address and portno and insert into table
-        AddressEntry entry;
+        MACAddress address(hexaddress);
+        AddressTable::iterator iter = addresstable.find(address);
+        if (iter != addresstable.end())
+            removeTableEntry(iter);
+        AddressEntry& entry = addresstable[address];
         entry.insertionTime = 0;
         entry.portno = atoi(portno);
-        addresstable[MACAddress(hexaddress)] = entry;
+        entry.address = address;
+        linkAsNewest(&entry);
 
         // Garbage collection before next iteration
         delete [] line;
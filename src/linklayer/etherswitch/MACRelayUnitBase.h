@@ -20,8 +20,8 @@
 #define __INET_MACRELAYUNITBASE_H
 
 #include <omnetpp.h>
-#include <map>
 #include <string>
+#include "INETHashMap.h"
 #include "MACAddress.h"
 
 class EtherFrame;
@@ -41,16 +41,21 @@ class INET_API MACRelayUnitBase : public cSimpleModule
     {
         int portno;              // Input port
         simtime_t insertionTime; // Arrival time of Lookup Address Table entry
+        MACAddress address;      // key of this entry, for erasing it via the aging list
+        AddressEntry *older;     // aging list links, see oldestEntry/newestEntry
+        AddressEntry *newer;
     };
 
   protected:
-    struct MAC_compare
+    struct MAC_hash
     {
-        bool operator()(const MACAddress& u1, const MACAddress& u2) const
-            {return u1.compareTo(u2) < 0;}
+        size_t operator()(const MACAddress& a) const {
+            uint64 x = a.getInt();
+            return inet_hashmix((uint32)x ^ inet_hashmix((uint32)(x>>32)));
+        }
     };
 
-    typedef std::map<MACAddress, AddressEntry, MAC_compare> AddressTable;
+    typedef std::tr1::unordered_map<MACAddress, AddressEntry, MAC_hash> AddressTable;
 
     // Parameters controlling how the switch operates
     int numPorts;               // Number of ports of the switch
@@ -59,6 +64,13 @@ class INET_API MACRelayUnitBase : public cSimpleModule
 
     AddressTable addresstable;  // Address Lookup Table
 
+    // Entries of addresstable, linked in the order of their insertionTime
+    // (every insert or update moves the entry to the newest end). Aged
+    // entries are therefore always at the oldest end, which makes aging
+    // and eviction O(1) per removed entry.
+    AddressEntry *oldestEntry;
+    AddressEntry *newestEntry;
+
     int seqNum;                 // counter for PAUSE frames
 
   protected:
@@ -112,6 +124,19 @@ class INET_API MACRelayUnitBase : public cSimpleModule
      */
     virtual void removeOldestTableEntry();
 
+    /**
+     * Utility function: removes the given entry from the table and
+     * from the aging list. Subclasses must use this instead of
+     * addresstable.erase().
+     */
+    virtual void removeTableEntry(AddressTable::iterator iter);
+
+    /** @name Aging list maintenance */
+    //@{
+    void linkAsNewest(AddressEntry *entry);
+    void unlinkEntry(AddressEntry *entry);
+    //@}
+
     /**
      * Utility function (for use by subclasses) to send a flow control
      * PAUSE frame on the given port.
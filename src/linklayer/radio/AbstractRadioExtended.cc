@@ -805,7 +805,7 @@ void AbstractRadioExtended::changeChannel(int channel)
         {
             AirFrameExtended *airframe = check_and_cast<AirFrameExtended *> (*it);
             // time for the message to reach us
-            double distance = myHostRef->pos.distance(airframe->getSenderPos());
+            double distance = getMyPosition().distance(airframe->getSenderPos());
             simtime_t propagationDelay = distance / LIGHT_SPEED;
 
             // if this transmission is on our new channel and it would reach us in the future, then schedule it
@@ -850,7 +850,7 @@ void AbstractRadioExtended::changeChannel(int channel)
         {
             AirFrame *airframe = *it;
             // time for the message to reach us
-            double distance = myHostRef->pos.distance(airframe->getSenderPos());
+            double distance = getMyPosition().distance(airframe->getSenderPos());
             simtime_t propagationDelay = distance / LIGHT_SPEED;
 
             // if this transmission is on our new channel and it would reach us in the future, then schedule it
@@ -96,7 +96,17 @@ void BasicMobility::handleMessage(cMessage * msg)
 void BasicMobility::updatePosition()
 {
     cc->updateHostPosition(myHostRef, pos);
+    positionUpdated();
+}
 
+void BasicMobility::updateMotion(const Coord& speed, simtime_t until)
+{
+    cc->updateHostMotion(myHostRef, pos, speed, until);
+    positionUpdated();
+}
+
+void BasicMobility::positionUpdated()
+{
     if (ev.isGUI())
     {
         double r = cc->getCommunicationRange(myHostRef);
@@ -97,6 +97,18 @@ class INET_API BasicMobility : public BasicModule
      */
     virtual void updatePosition();
 
+    /**
+     * @brief Alternative to updatePosition() for hosts that move along a
+     * straight line: pos is the current position, and the host keeps moving
+     * with the given speed (m/s) until the given time. ChannelControl
+     * then computes the position on demand, so no further updates are
+     * needed until the movement changes.
+     */
+    virtual void updateMotion(const Coord& speed, simtime_t until);
+
+    /** @brief Refreshes the display and fires NF_HOSTPOSITION_UPDATED */
+    virtual void positionUpdated();
+
     /** @brief Returns the width of the playground */
     virtual double getPlaygroundSizeX() const  {return cc->getPgs()->x;}
 
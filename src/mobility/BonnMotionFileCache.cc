@@ -15,16 +15,15 @@
 // along with this program; if not, see <http://www.gnu.org/licenses/>.
 //
 
-#include <fstream>
-#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "BonnMotionFileCache.h"
 
 
 const BonnMotionFile::Line *BonnMotionFile::getLine(int nodeId) const
 {
-    LineList::const_iterator it = lines.begin();
-    for (int i=0; i<nodeId && it!=lines.end(); i++) it++;
-    return (it==lines.end()) ? NULL : &(*it);
+    return (nodeId<0 || nodeId>=(int)lines.size()) ? NULL : &lines[nodeId];
 }
 
 
@@ -61,23 +60,63 @@ const BonnMotionFile *BonnMotionFileCache::getFile(const char *filename)
 
 void BonnMotionFileCache::parseFile(const char *filename, BonnMotionFile& bmFile)
 {
-    std::ifstream in(filename, std::ios::in);
-    if (in.fail())
+    // Read the whole file with a single fread() and parse it in place with
+    // strtod(); this is an order of magnitude faster than getline() plus
+    // stringstream on multi-gigabyte traces.
+    FILE *f = fopen(filename, "rb");
+    if (!f)
         opp_error("Cannot open file '%s'",filename);
-
-    std::string line;
-    while (std::getline(in, line))
+    std::vector<char> buffer;
+    if (fseek(f, 0, SEEK_END)==0)
     {
-        bmFile.lines.push_back(BonnMotionFile::Line());
-        BonnMotionFile::Line& vec = bmFile.lines.back();
-
-        std::stringstream linestream(line);
-        double d;
-        while (linestream >> d)
-            vec.push_back(d);
+        long size = ftell(f);
+        if (size > 0)
+            buffer.reserve(size+1);  // +1 for the terminator
+        rewind(f);
     }
-    in.close();
-}
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        buffer.insert(buffer.end(), chunk, chunk+n);
+    bool readError = ferror(f)!=0;
+    fclose(f);
+    if (readError)
+        opp_error("Error reading file '%s'",filename);
+    buffer.push_back('\0');  // terminator for strtod()
 
+    // rough estimate of the number of values, to avoid reallocations
+    bmFile.values.reserve(buffer.size()/8);
 
+    const char *s = &buffer[0];
+    const char *end = s + buffer.size() - 1;
+    while (s < end)
+    {
+        // one line: parse numbers until end of line or first non-number (like operator>>)
+        bmFile.lineStarts.push_back(bmFile.values.size());
+        const char *eol = (const char *)memchr(s, '\n', end-s);
+        if (!eol)
+            eol = end;
+        while (s < eol)
+        {
+            while (s < eol && (*s==' ' || *s=='\t' || *s=='\r'))
+                s++;
+            if (s == eol)
+                break;
+            char *next;
+            double d = strtod(s, &next);
+            if (next == s || next > eol)
+                break;
+            bmFile.values.push_back(d);
+            s = next;
+        }
+        s = eol + 1;
+    }
+    bmFile.lineStarts.push_back(bmFile.values.size());
 
+    // create the line views now that values[] won't be reallocated any more
+    int numLines = bmFile.lineStarts.size()-1;
+    const double *base = bmFile.values.empty() ? NULL : &bmFile.values[0];
+    bmFile.lines.reserve(numLines);
+    for (int i=0; i<numLines; i++)
+        bmFile.lines.push_back(BonnMotionFile::Line(base + bmFile.lineStarts[i], bmFile.lineStarts[i+1]-bmFile.lineStarts[i]));
+}
@@ -18,7 +18,6 @@
 #ifndef BONNMOTIONFILECACHE_H
 #define BONNMOTIONFILECACHE_H
 
-#include <list>
 #include <vector>
 #include <omnetpp.h>
 #include "BasicMobility.h"
@@ -26,19 +25,36 @@
 class BonnMotionFileCache;
 
 /**
- * Represents a BonnMotion file's contents.
+ * Represents a BonnMotion file's contents. All numbers of the file are
+ * stored in one contiguous array; lines are handed out as lightweight
+ * views into it, so they are not copied per node.
  * @see BonnMotionFileCache, BonnMotionMobility
  */
 class INET_API BonnMotionFile
 {
   public:
-    typedef std::vector<double> Line;
+    /**
+     * The numbers of one line of the file. Points into the storage of the
+     * BonnMotionFile, and stays valid as long as the file is in the cache.
+     */
+    class Line
+    {
+      protected:
+        const double *data;
+        int n;
+      public:
+        Line(const double *data, int n) : data(data), n(n) {}
+        int size() const {return n;}
+        double operator[](int i) const {return data[i];}
+    };
   protected:
     friend class BonnMotionFileCache;
-    typedef std::list<Line> LineList;
-    LineList lines;
+    std::vector<double> values;    // numbers of all lines, concatenated
+    std::vector<int> lineStarts;   // index of first number of each line in values[], plus end marker
+    std::vector<Line> lines;       // filled in when parsing is complete
   public:
     const Line *getLine(int nodeId) const;
+    int getNumLines() const {return lines.size();}
 };
 
 
@@ -32,6 +32,7 @@ void LineSegmentsMobilityBase::initialize(int stage)
         targetTime = simTime();
 
         // host moves the first time after some random delay to avoid synchronized movements
+        // (in analytic mode the delay is zero, but we still draw it to keep the RNG stream unchanged)
         scheduleAt(simTime() + uniform(0, updateInterval), new cMessage("move"));
     }
 }
@@ -54,6 +55,15 @@ void LineSegmentsMobilityBase::beginNextMove(cMessage *msg)
         step.x = step.y = 0;
         delete msg;
     }
+    else if (updateInterval == 0)
+    {
+        // analytic mode: step is the speed; wake up only at the end of the segment
+        if (targetPos == pos || targetTime == now)
+            step.x = step.y = 0;
+        else
+            step = (targetPos - pos) / SIMTIME_DBL(targetTime - now);
+        scheduleAt(std::max(targetTime,simTime()), msg);
+    }
     else if (targetPos==pos)
     {
         // no movement, just wait
@@ -83,6 +93,16 @@ void LineSegmentsMobilityBase::handleSelfMsg(cMessage *msg)
         delete msg;
         return;
     }
+    else if (updateInterval == 0)
+    {
+        beginNextMove(msg);
+        fixIfHostGetsOutside();
+        if (stationary)
+            updatePosition();
+        else
+            updateMotion(step, targetTime);
+        return;
+    }
     else if (simTime()+updateInterval >= targetTime)
     {
         beginNextMove(msg);
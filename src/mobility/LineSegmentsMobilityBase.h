@@ -29,6 +29,14 @@
  * Subclasses must redefine setTargetPosition() which is suppsed to set
  * a new target position and target time once the previous one is reached.
  *
+ * With updateInterval=0 the module runs in analytic mode: it only wakes
+ * up at the end of each line segment, and announces the segment to
+ * ChannelControl via updateMotion(). Positions in between are computed
+ * on demand, and connectivity changes are scheduled by ChannelControl at
+ * the exact times hosts enter or leave each other's range. Note that
+ * NF_HOSTPOSITION_UPDATED is then only fired at segment boundaries, and
+ * border policies are only applied there.
+ *
  * @ingroup mobility
  * @author Andras Varga
  */
@@ -36,12 +44,12 @@ class INET_API LineSegmentsMobilityBase : public BasicMobility
 {
   protected:
     // config
-    double updateInterval; ///< time interval to update the host's position
+    double updateInterval; ///< time interval to update the host's position; 0 means analytic mode
 
     // state
     simtime_t targetTime;  ///< end time of current linear movement
     Coord targetPos;       ///< end position of current linear movement
-    Coord step;            ///< step size (added to pos every updateInterval)
+    Coord step;            ///< step size (added to pos every updateInterval); speed in analytic mode
     bool stationary;       ///< if set to true, host won't move
 
   protected:
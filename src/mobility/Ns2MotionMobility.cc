@@ -29,21 +29,55 @@
 Define_Module(Ns2MotionMobility);
 
 
-void Ns2MotionMobility::parseFile(const char *filename)
+Ns2MotionFileCache *Ns2MotionFileCache::inst;
+int Ns2MotionFileCache::refCount;
+
+Ns2MotionFileCache *Ns2MotionFileCache::getInstance()
+{
+    if (!inst)
+        inst = new Ns2MotionFileCache;
+    refCount++;
+    return inst;
+}
+
+void Ns2MotionFileCache::releaseInstance()
+{
+    // other nodes may still move along the cached files
+    if (inst && --refCount == 0)
+    {
+        delete inst;
+        inst = NULL;
+    }
+}
+
+const Ns2MotionFile *Ns2MotionFileCache::getFile(const char *filename, int nodeId)
+{
+    FileMap::iterator it = cache.find(std::string(filename));
+    if (it==cache.end())
+    {
+        // load and store in cache
+        it = cache.insert(std::make_pair(std::string(filename), NodeMap())).first;
+        parseFile(filename, it->second);
+    }
+
+    NodeMap::const_iterator nodeIt = it->second.find(nodeId);
+    return nodeIt==it->second.end() ? NULL : &(nodeIt->second);
+}
+
+void Ns2MotionFileCache::parseFile(const char *filename, NodeMap& nodes)
 {
 
     std::ifstream in(filename, std::ios::in);
 
     if (in.fail())
         opp_error("Cannot open file '%s'",filename);
-    ns2File->initial[0]=ns2File->initial[1]=ns2File->initial[2]=-1;
     std::string line;
     std::string subline;
 
     while (std::getline(in, line))
     {
         // '#' line
-        int num_node;
+        int num_node = -1;
         std::string::size_type found=line.find('#');
         if (found == 0)
             continue;
@@ -59,8 +93,9 @@ void Ns2MotionMobility::parseFile(const char *filename)
         std::string::size_type pos2 = subline.find(')');
         if (pos2-pos1>1)
             num_node = std::atoi (subline.substr(pos1+1,pos2-1).c_str());
-        if (num_node!=nodeId)
+        if (num_node<0)
             continue;
+        Ns2MotionFile *ns2File = &nodes[num_node];
         // Initial position
         found = subline.find("set ");
         if (found!=std::string::npos)
@@ -101,10 +136,6 @@ void Ns2MotionMobility::parseFile(const char *filename)
         }
     }
     in.close();
-    // exist data?
-    if (ns2File->initial[0]==-1 || ns2File->initial[1]==-1 || ns2File->initial[2]==-1)
-        opp_error("node '%d' Error ns2 motion file '%s'",nodeId,filename);
-
 }
 
 
@@ -124,8 +155,12 @@ void Ns2MotionMobility::initialize(int stage)
             nodeId = getParentModule()->getIndex();
 
         const char *fname = par("traceFile");
-        ns2File = new Ns2MotionFile;
-        parseFile(fname);
+        cache = Ns2MotionFileCache::getInstance();
+        ns2File = cache->getFile(fname, nodeId);
+
+        // exist data?
+        if (!ns2File || ns2File->initial[0]==-1 || ns2File->initial[1]==-1 || ns2File->initial[2]==-1)
+            error("node '%d' Error ns2 motion file '%s'",nodeId,fname);
 
         // obtain initial position
         pos.x = ns2File->initial[0]+scrollX;
@@ -139,8 +174,8 @@ void Ns2MotionMobility::initialize(int stage)
 
 Ns2MotionMobility::~Ns2MotionMobility()
 {
-    if (ns2File)
-        delete ns2File;
+    if (cache)
+        Ns2MotionFileCache::releaseInstance();
 }
 
 void Ns2MotionMobility::setTargetPosition()
@@ -20,6 +20,9 @@
 #ifndef NS2MOTION_MOBILITY_H
 #define NS2MOTION_MOBILITY_H
 
+#include <map>
+#include <string>
+#include <vector>
 #include <omnetpp.h>
 #include "LineSegmentsMobilityBase.h"
 
@@ -41,11 +44,49 @@ class INET_API Ns2MotionFile
   public:
     typedef std::vector<double> Line;
     double initial[3];
+    Ns2MotionFile() {initial[0] = initial[1] = initial[2] = -1;}
   protected:
     friend class Ns2MotionMobility;
+    friend class Ns2MotionFileCache;
     typedef std::vector<Line> LineList;
     LineList lines;
+};
+
+/**
+ * Singleton object to read and store ns2 motion files, similar to
+ * BonnMotionFileCache. A file is parsed only once, and the movements
+ * of all nodes are stored from it; without this, every node would
+ * read through the whole file to find its own lines.
+ */
+class INET_API Ns2MotionFileCache
+{
+  protected:
+    typedef std::map<int,Ns2MotionFile> NodeMap;  // nodeId -> movements
+    typedef std::map<std::string,NodeMap> FileMap;
+    FileMap cache;
+    static Ns2MotionFileCache *inst;
+    static int refCount;
+    void parseFile(const char *filename, NodeMap& nodes);
+    Ns2MotionFileCache() {}
+    virtual ~Ns2MotionFileCache() {}
+
+  public:
+    /**
+     * Returns the singleton instance, creating it if needed. Every call
+     * must be paired with a releaseInstance() call.
+     */
+    static Ns2MotionFileCache *getInstance();
 
+    /**
+     * Releases the instance; the last release deletes it.
+     */
+    static void releaseInstance();
+
+    /**
+     * Returns the movements of the given node in the given file, or NULL
+     * if the file does not mention the node.
+     */
+    virtual const Ns2MotionFile *getFile(const char *filename, int nodeId);
 };
 
 
@@ -55,17 +96,16 @@ class INET_API Ns2MotionMobility : public LineSegmentsMobilityBase
   protected:
     // state
     unsigned int vecpos;
-    Ns2MotionFile *ns2File;
+    Ns2MotionFileCache *cache;
+    const Ns2MotionFile *ns2File;
     int nodeId;
     double scrollX;
     double scrollY;
 
   public:
     ~Ns2MotionMobility();
-    Ns2MotionMobility() {ns2File=NULL;}
+    Ns2MotionMobility() {cache=NULL; ns2File=NULL;}
   protected:
-    void parseFile(const char *filename);
-
     /** @brief Initializes mobility model parameters.*/
     virtual void initialize(int);
 
@@ -27,16 +27,8 @@ static std::ostream& operator<< (std::ostream& out, cMessage *msg)
     return out;
 }
 
-static std::ostream& operator<< (std::ostream& out, const ARP::ARPCacheEntry& e)
-{
-    if (e.pending)
-        out << "pending (" << e.numRetries << " retries)";
-    else
-        out << "MAC:" << e.macAddress << "  age:" << floor(simTime()-e.lastUpdate) << "s";
-    return out;
-}
-
 ARP::ARPCache ARP::globalArpCache;
+ARP::InverseARPCache ARP::globalInverseArpCache;
 
 Define_Module (ARP);
 
@@ -60,6 +52,7 @@ void ARP::initialize(int stage)
         updateTimeOut=par("updateTimeOut");
 
         pendingQueue.setName("pendingQueue");
+        retryTimer = new cMessage("ARP timeout");
 
         // init statistics
         numRequestsSent = numRepliesSent = 0;
@@ -69,8 +62,8 @@ void ARP::initialize(int stage)
         WATCH(numResolutions);
         WATCH(numFailedResolutions);
 
-        WATCH_PTRMAP(arpCache);
-        WATCH_PTRMAP(globalArpCache);
+        // the caches are hash maps, which WATCH_PTRMAP cannot display;
+        // the display string shows the size of arpCache
 
 // initialize global cache
         for (int i=0; i<ift->getNumInterfaces(); i++)
@@ -78,16 +71,11 @@ void ARP::initialize(int stage)
             InterfaceEntry *ie = ift->getInterface(i);
             if (ie->isLoopback())
                 continue;
-            ARPCacheEntry *entry = new ARPCacheEntry();
-            entry->ie = ie;
-            entry->pending = false;
-            entry->timer = NULL;
-            entry->numRetries = 0;
-            entry->macAddress = ie->getMacAddress();
-            IPAddress nextHopAddr = ie->ipv4Data()->getIPAddress();
-            ARPCache::iterator where = globalArpCache.insert(globalArpCache.begin(), std::make_pair(nextHopAddr,entry));
-            entry->myIter = where; // note: "inserting a new element into a map does not invalidate iterators that point to existing elements"
-            localAddress.push_back(nextHopAddr);
+            ARPCacheEntry *entry = createCacheEntry(globalArpCache, ie->ipv4Data()->getIPAddress(), ie);
+            if (!entry)
+                continue; // address already taken by another node; first one wins
+            setCacheEntryMAC(globalInverseArpCache, entry, ie->getMacAddress());
+            localEntries.push_back(entry);
         }
         nb = NotificationBoardAccess().get();
         if (nb!=NULL && globalARP)
@@ -111,35 +99,74 @@ void ARP::finish()
 ARP::~ARP()
 {
     while (!arpCache.empty())
+        deleteCacheEntry(arpCache, inverseArpCache, arpCache.begin()->second);
+
+    // delete our own entries from the global cache
+    while (!localEntries.empty())
     {
-        ARPCache::iterator i = arpCache.begin();
-        delete (*i).second;
-        arpCache.erase(i);
+        deleteCacheEntry(globalArpCache, globalInverseArpCache, localEntries.back());
+        localEntries.pop_back();
     }
-    if (!globalArpCache.empty())
+    cancelAndDelete(retryTimer);
+}
+
+ARP::ARPCacheEntry *ARP::createCacheEntry(ARPCache& cache, const IPAddress& ipAddress, InterfaceEntry *ie)
+{
+    ARPCacheEntry *entry = new ARPCacheEntry();
+    entry->ipAddress = ipAddress;
+    entry->ie = ie;
+    entry->pending = false;
+    entry->numRetries = 0;
+    if (!cache.insert(std::make_pair(ipAddress, entry)).second)
     {
-    // delete local address from the globalArpCache
-        while (!localAddress.empty())
-        {
-            ARPCache::iterator it = globalArpCache.find(localAddress.back());
-            if (it==globalArpCache.end()) {
-//                throw cRuntimeError(this, "Addres not found in global");
-            	std::cerr << "Error removing address " << localAddress.back().str() << ": Address not found in global ARP cache" << std::endl;
-            } else
-            {
-                delete (*it).second;
-                globalArpCache.erase(it);
-            }
-            localAddress.pop_back();
-        }
+        delete entry;
+        return NULL;
     }
+    return entry;
+}
+
+void ARP::setCacheEntryMAC(InverseARPCache& inverseCache, ARPCacheEntry *entry, const MACAddress& macAddress)
+{
+    if (entry->macAddress == macAddress)
+    {
+        if (!macAddress.isUnspecified())
+            inverseCache[macAddress] = entry; // most recently confirmed mapping wins
+        return;
+    }
+    if (!entry->macAddress.isUnspecified())
+    {
+        InverseARPCache::iterator it = inverseCache.find(entry->macAddress);
+        if (it!=inverseCache.end() && it->second==entry)
+            inverseCache.erase(it);
+    }
+    entry->macAddress = macAddress;
+    if (!macAddress.isUnspecified())
+        inverseCache[macAddress] = entry;
+}
+
+void ARP::rekeyCacheEntry(ARPCache& cache, ARPCacheEntry *entry, const IPAddress& ipAddress)
+{
+    ARPCache::iterator it = cache.find(entry->ipAddress);
+    if (it!=cache.end() && it->second==entry)
+        cache.erase(it);
+    entry->ipAddress = ipAddress;
+    cache[ipAddress] = entry;
+}
+
+void ARP::deleteCacheEntry(ARPCache& cache, InverseARPCache& inverseCache, ARPCacheEntry *entry)
+{
+    ARPCache::iterator it = cache.find(entry->ipAddress);
+    if (it!=cache.end() && it->second==entry)
+        cache.erase(it);
+    setCacheEntryMAC(inverseCache, entry, MACAddress::UNSPECIFIED_ADDRESS);
+    delete entry;
 }
 
 void ARP::handleMessage(cMessage *msg)
 {
-    if (msg->isSelfMessage())
+    if (msg==retryTimer)
     {
-        requestTimedOut(msg);
+        processRetryTimer();
     }
     else if (dynamic_cast<ARPPacket *>(msg))
     {
@@ -254,10 +281,7 @@ void ARP::processOutboundPacket(cMessage *msg)
     if (it==arpCache.end())
     {
         // no cache entry: launch ARP request
-        ARPCacheEntry *entry = new ARPCacheEntry();
-        ARPCache::iterator where = arpCache.insert(arpCache.begin(), std::make_pair(nextHopAddr,entry));
-        entry->myIter = where; // note: "inserting a new element into a map does not invalidate iterators that point to existing elements"
-        entry->ie = ie;
+        ARPCacheEntry *entry = createCacheEntry(arpCache, nextHopAddr, ie);
 
         EV << "Starting ARP resolution for " << nextHopAddr << "\n";
         initiateARPResolution(entry);
@@ -298,20 +322,50 @@ void ARP::processOutboundPacket(cMessage *msg)
 
 void ARP::initiateARPResolution(ARPCacheEntry *entry)
 {
-    IPAddress nextHopAddr = entry->myIter->first;
     entry->pending = true;
     entry->numRetries = 0;
     entry->lastUpdate = 0;
-    sendARPRequest(entry->ie, nextHopAddr);
+    sendARPRequest(entry->ie, entry->ipAddress);
 
     // start timer
-    cMessage *msg = entry->timer = new cMessage("ARP timeout");
-    msg->setContextPointer(entry);
-    scheduleAt(simTime()+retryTimeout, msg);
+    scheduleRetry(entry);
+    armRetryTimer();
 
     numResolutions++;
 }
 
+void ARP::scheduleRetry(ARPCacheEntry *entry)
+{
+    entry->retryTime = simTime()+retryTimeout;
+    retryQueue.push_back(std::make_pair(entry->retryTime, entry));
+}
+
+void ARP::armRetryTimer()
+{
+    // all retries use the same timeout, so the queue is ordered by
+    // retry time and the timer always belongs to its front
+    if (retryTimer->isScheduled())
+        cancelEvent(retryTimer);
+    if (!retryQueue.empty())
+        scheduleAt(retryQueue.front().first, retryTimer);
+}
+
+void ARP::processRetryTimer()
+{
+    // an entry is deleted only when its own (matching) item is processed,
+    // and later items never refer to an entry with an earlier retryTime,
+    // so the skipped items never point to deleted entries
+    while (!retryQueue.empty() && retryQueue.front().first <= simTime())
+    {
+        ARPCacheEntry *entry = retryQueue.front().second;
+        simtime_t retryTime = retryQueue.front().first;
+        retryQueue.pop_front();
+        if (entry->pending && entry->retryTime == retryTime)
+            requestTimedOut(entry);
+    }
+    armRetryTimer();
+}
+
 void ARP::sendPacketToNIC(cMessage *msg, InterfaceEntry *ie, const MACAddress& macAddress)
 {
     // add control info with MAC address
@@ -348,17 +402,15 @@ void ARP::sendARPRequest(InterfaceEntry *ie, IPAddress ipAddress)
     numRequestsSent++;
 }
 
-void ARP::requestTimedOut(cMessage *selfmsg)
+void ARP::requestTimedOut(ARPCacheEntry *entry)
 {
-    ARPCacheEntry *entry = (ARPCacheEntry *)selfmsg->getContextPointer();
     entry->numRetries++;
     if (entry->numRetries < retryCount)
     {
         // retry
-        IPAddress nextHopAddr = entry->myIter->first;
-        EV << "ARP request for " << nextHopAddr << " timed out, resending\n";
-        sendARPRequest(entry->ie, nextHopAddr);
-        scheduleAt(simTime()+retryTimeout, selfmsg);
+        EV << "ARP request for " << entry->ipAddress << " timed out, resending\n";
+        sendARPRequest(entry->ie, entry->ipAddress);
+        scheduleRetry(entry);
         return;
     }
 
@@ -366,7 +418,7 @@ void ARP::requestTimedOut(cMessage *selfmsg)
     // throw out entry from cache, delete pending messages
     MsgPtrVector& pendingPackets = entry->pendingPackets;
     EV << "ARP timeout, max retry count " << retryCount << " for "
-    << entry->myIter->first << " reached. Dropping " << pendingPackets.size()
+    << entry->ipAddress << " reached. Dropping " << pendingPackets.size()
     << " waiting packets from the queue\n";
     while (!pendingPackets.empty())
     {
@@ -376,9 +428,7 @@ void ARP::requestTimedOut(cMessage *selfmsg)
         pendingQueue.remove(msg);
         delete msg;
     }
-    delete selfmsg;
-    arpCache.erase(entry->myIter);
-    delete entry;
+    deleteCacheEntry(arpCache, inverseArpCache, entry);
     numFailedResolutions++;
 }
 
@@ -476,14 +526,7 @@ void ARP::processARPPacket(ARPPacket *arp)
             }
             else
             {
-                entry = new ARPCacheEntry();
-                ARPCache::iterator where = arpCache.insert(arpCache.begin(), std::make_pair(srcIPAddress,entry));
-                entry->myIter = where;
-                entry->ie = ie;
-
-                entry->pending = false;
-                entry->timer = NULL;
-                entry->numRetries = 0;
+                entry = createCacheEntry(arpCache, srcIPAddress, ie);
             }
             updateARPCache(entry, srcMACAddress);
         }
@@ -533,17 +576,15 @@ void ARP::processARPPacket(ARPPacket *arp)
 
 void ARP::updateARPCache(ARPCacheEntry *entry, const MACAddress& macAddress)
 {
-    EV << "Updating ARP cache entry: " << entry->myIter->first << " <--> " << macAddress << "\n";
+    EV << "Updating ARP cache entry: " << entry->ipAddress << " <--> " << macAddress << "\n";
 
-    // update entry
+    // update entry; a pending retry is skipped when it comes due
     if (entry->pending)
     {
         entry->pending = false;
-        delete cancelEvent(entry->timer);
-        entry->timer = NULL;
         entry->numRetries = 0;
     }
-    entry->macAddress = macAddress;
+    setCacheEntryMAC(inverseArpCache, entry, macAddress);
     entry->lastUpdate = simTime();
 
     // process queued packets
@@ -580,47 +621,34 @@ const MACAddress ARP::getDirectAddressResolution(const IPAddress & add) const
 
 const IPAddress ARP::getInverseAddressResolution(const MACAddress &add) const
 {
-    IPAddress address;
-    ARPCache::const_iterator it;
     if (globalARP)
     {
-        for (it = globalArpCache.begin(); it!=globalArpCache.end(); it++)
-            if ((*it).second->macAddress==add)
-            {
-                address = (*it).first;
-                return address;
-            }
-    }
-    else
-    {
-        for (it = arpCache.begin(); it!=arpCache.end(); it++)
-            if ((*it).second->macAddress==add)
-            {
-                address = (*it).first;
-                return address;
-            }
+        InverseARPCache::const_iterator it = globalInverseArpCache.find(add);
+        return it!=globalInverseArpCache.end() ? it->second->ipAddress : IPAddress();
     }
-    return address;
+
+    // entries are not purged when they expire, so check on lookup
+    InverseARPCache::const_iterator it = inverseArpCache.find(add);
+    if (it==inverseArpCache.end())
+        return IPAddress();
+    const ARPCacheEntry *entry = it->second;
+    if (entry->pending || entry->lastUpdate+cacheTimeout<simTime())
+        return IPAddress();
+    return entry->ipAddress;
 }
 
 void ARP::setChangeAddress(const IPAddress &oldAddress)
 {
     Enter_Method_Silent();
-    ARPCache::iterator it;
-    MACAddress address = MACAddress::UNSPECIFIED_ADDRESS;
     if (globalARP)
     {
-        it = globalArpCache.find(oldAddress);
+        ARPCache::iterator it = globalArpCache.find(oldAddress);
         if (it!=globalArpCache.end())
         {
             ARPCacheEntry *entry = (*it).second;
-            globalArpCache.erase(it);
             entry->pending = false;
-            entry->timer = NULL;
             entry->numRetries = 0;
-            IPAddress nextHopAddr = entry->ie->ipv4Data()->getIPAddress();
-            ARPCache::iterator where = globalArpCache.insert(globalArpCache.begin(),std::make_pair(nextHopAddr,entry));
-            entry->myIter = where; // note: "inserting a new element into a map does not invalidate iterators that point to existing elements"
+            rekeyCacheEntry(globalArpCache, entry, entry->ie->ipv4Data()->getIPAddress());
         }
     }
 }
@@ -633,46 +661,31 @@ void ARP::receiveChangeNotification(int category, const cPolymorphic *details)
     if (category == NF_INTERFACE_IPv4CONFIG_CHANGED)
     {
     	// rebuild the arp cache
-        localAddress.clear();
         for (int i=0; i<ift->getNumInterfaces(); i++)
         {
             InterfaceEntry *ie = ift->getInterface(i);
             if (ie->isLoopback())
                 continue;
-            ARPCache::iterator it;
-            for (it=globalArpCache.begin();it!=globalArpCache.end();it++)
+            ARPCacheEntry *entry = NULL;
+            for (unsigned int j=0; j<localEntries.size() && !entry; j++)
+                if (localEntries[j]->ie==ie)
+                    entry = localEntries[j];
+            IPAddress ipAddr = ie->ipv4Data()->getIPAddress();
+            if (!entry)
             {
-                if (it->second->ie==ie)
-                    break;
-            }
-            if (it==globalArpCache.end())
-            {
-                ARPCacheEntry *entry = new ARPCacheEntry();
-                entry->ie = ie;
-                entry->pending = false;
-                entry->timer = NULL;
-                entry->numRetries = 0;
-                entry->macAddress = ie->getMacAddress();
-                IPAddress ipAddr = ie->ipv4Data()->getIPAddress();
-                ARPCache::iterator where = globalArpCache.insert(globalArpCache.begin(),std::make_pair(ipAddr,entry));
-                entry->myIter = where; // note: "inserting a new element into a map does not invalidate iterators that point to existing elements"
-                localAddress.push_back(ipAddr);
+                entry = createCacheEntry(globalArpCache, ipAddr, ie);
+                if (!entry)
+                    continue;
+                localEntries.push_back(entry);
             }
             else
             {
                 // actualize
-            	ARPCacheEntry *entry = it->second;
-            	globalArpCache.erase(it);
-                entry->ie = ie;
                 entry->pending = false;
-                entry->timer = NULL;
                 entry->numRetries = 0;
-                entry->macAddress = ie->getMacAddress();
-                IPAddress ipAddr = ie->ipv4Data()->getIPAddress();
-                ARPCache::iterator where=globalArpCache.insert(globalArpCache.begin(),std::make_pair(ipAddr,entry));
-                entry->myIter = where; // note: "inserting a new element into a map does not invalidate iterators that point to existing elements"
-                localAddress.push_back(ipAddr);
+                rekeyCacheEntry(globalArpCache, entry, ipAddr);
             }
+            setCacheEntryMAC(globalInverseArpCache, entry, ie->getMacAddress());
         }
 	}
 }
@@ -22,7 +22,9 @@
 #include <string.h>
 #include <vector>
 #include <map>
+#include <deque>
 #include <omnetpp.h>
+#include "INETHashMap.h"
 #include "IPAddress.h"
 #include "ARPPacket_m.h"
 #include "IPControlInfo.h"
@@ -42,23 +44,25 @@ class INET_API ARP : public cSimpleModule, public INotifiable
 {
   public:
     struct ARPCacheEntry;
-    typedef std::map<IPAddress, ARPCacheEntry*> ARPCache;
     typedef std::vector<cMessage*> MsgPtrVector;
-    std::vector<IPAddress> localAddress;
 
     // IPAddress -> MACAddress table
     // TBD should we key it on (IPAddress, InterfaceEntry*)?
+    typedef std::tr1::unordered_map<IPAddress, ARPCacheEntry*, IPAddressHash> ARPCache;
+    // MACAddress -> IPAddress index into the same entries, for inverse resolution
+    typedef std::tr1::unordered_map<MACAddress, ARPCacheEntry*, MACAddressHash> InverseARPCache;
+
     struct ARPCacheEntry
     {
+        IPAddress ipAddress;  // key of this entry in the cache
         InterfaceEntry *ie; // NIC to send the packet to
         bool pending; // true if resolution is pending
-        MACAddress macAddress;  // MAC address
+        MACAddress macAddress;  // MAC address; in the inverse index if specified
         simtime_t lastUpdate;  // entries should time out after cacheTimeout
         int numRetries; // if pending==true: 0 after first ARP request, 1 after second, etc.
-        cMessage *timer;  // if pending==true: request timeout msg
+        simtime_t retryTime;  // if pending==true: when the current request times out
         MsgPtrVector pendingPackets;  // if pending==true: ptrs to packets waiting for resolution
         // (packets are owned by pendingQueue)
-        ARPCache::iterator myIter;  // iterator pointing to this entry
     };
 
   protected:
@@ -75,7 +79,17 @@ class INET_API ARP : public cSimpleModule, public INotifiable
     long numRepliesSent;
 
     ARPCache arpCache;
+    InverseARPCache inverseArpCache;
     static ARPCache globalArpCache;
+    static InverseARPCache globalInverseArpCache;
+    std::vector<ARPCacheEntry*> localEntries; // our own interfaces in the global cache
+
+    // Pending resolutions in the order they time out. retryTimeout is the
+    // same for all of them, so appending keeps the order, and one timer
+    // for the front replaces a timeout message per entry. Entries that got
+    // resolved meanwhile are skipped (their retryTime no longer matches).
+    std::deque<std::pair<simtime_t, ARPCacheEntry*> > retryQueue;
+    cMessage *retryTimer;
 
     cQueue pendingQueue; // outbound packets waiting for ARP resolution
     int nicOutBaseGateId;  // id of the nicOut[0] gate
@@ -85,7 +99,7 @@ class INET_API ARP : public cSimpleModule, public INotifiable
     NotificationBoard* nb;
 
   public:
-    ARP() {}
+    ARP() {retryTimer = NULL;}
     virtual ~ARP();
     int numInitStages() const {return 5;}
     const MACAddress getDirectAddressResolution(const IPAddress &) const;
@@ -104,11 +118,20 @@ class INET_API ARP : public cSimpleModule, public INotifiable
 
     virtual void initiateARPResolution(ARPCacheEntry *entry);
     virtual void sendARPRequest(InterfaceEntry *ie, IPAddress ipAddress);
-    virtual void requestTimedOut(cMessage *selfmsg);
+    virtual void scheduleRetry(ARPCacheEntry *entry);
+    virtual void armRetryTimer();
+    virtual void processRetryTimer();
+    virtual void requestTimedOut(ARPCacheEntry *entry);
     virtual bool addressRecognized(IPAddress destAddr, InterfaceEntry *ie);
     virtual void processARPPacket(ARPPacket *arp);
     virtual void updateARPCache(ARPCacheEntry *entry, const MACAddress& macAddress);
 
+    // cache maintenance, keeping the inverse index in sync
+    static ARPCacheEntry *createCacheEntry(ARPCache& cache, const IPAddress& ipAddress, InterfaceEntry *ie);
+    static void setCacheEntryMAC(InverseARPCache& inverseCache, ARPCacheEntry *entry, const MACAddress& macAddress);
+    static void rekeyCacheEntry(ARPCache& cache, ARPCacheEntry *entry, const IPAddress& ipAddress);
+    static void deleteCacheEntry(ARPCache& cache, InverseARPCache& inverseCache, ARPCacheEntry *entry);
+
     virtual void dumpARPPacket(ARPPacket *arp);
     virtual void updateDisplayString();
 
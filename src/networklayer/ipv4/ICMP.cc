@@ -63,6 +63,16 @@ void ICMP::sendErrorMessage(IPDatagram *origDatagram, ICMPType type, ICMPCode co
         return;
     }
 
+    // only the first fragment carries the transport packet (and the header the
+    // sender needs to identify its socket), so as RFC 1122 3.2.2 says, no ICMP
+    // error message is sent about other fragments
+    if (origDatagram->getFragmentOffset() != 0)
+    {
+        EV << "won't send ICMP error messages for non-first fragment " << origDatagram << endl;
+        delete origDatagram;
+        return;
+    }
+
     // do not reply with error message to error message
     if (origDatagram->getTransportProtocol() == IP_PROT_ICMP)
     {
@@ -41,6 +41,8 @@ void IP::initialize()
     rt = RoutingTableAccess().get();
 
     queueOutGate = gate("queueOut");
+    transportInBaseId = gateBaseId("transportIn");
+    fastPath = (delay == 0);
 
     defaultTimeToLive = par("timeToLive");
     defaultMCTimeToLive = par("multicastTimeToLive");
@@ -91,21 +93,30 @@ void IP::updateDisplayString()
     getDisplayString().setTagArg("t",0,buf);
 }
 
+void IP::handleMessage(cMessage *msg)
+{
+    // with zero service time the queue never holds anything and no timer
+    // is scheduled, so the packet can go straight to endService()
+    if (fastPath && msg->isPacket())
+        endService((cPacket *)msg);
+    else
+        QueueBase::handleMessage(msg);
+}
+
 void IP::endService(cPacket *msg)
 {
-    if (msg->getArrivalGate()->isName("transportIn"))
+    if (msg->getArrivalGate()->getBaseId() == transportInBaseId)
     {
         handleMessageFromHL( msg );
     }
-    else if (dynamic_cast<ARPPacket *>(msg))
+    else if (IPDatagram *dgram = dynamic_cast<IPDatagram *>(msg))
     {
-        // dispatch ARP packets to ARP
-        handleARP((ARPPacket *)msg);
+        handlePacketFromNetwork(dgram);
     }
     else
     {
-        IPDatagram *dgram = check_and_cast<IPDatagram *>(msg);
-        handlePacketFromNetwork(dgram);
+        // dispatch ARP packets to ARP
+        handleARP(check_and_cast<ARPPacket *>(msg));
     }
 
     if (ev.isGUI())
@@ -741,10 +752,9 @@ void IP::fragmentAndSend(IPDatagram *datagram, InterfaceEntry *ie, IPAddress nex
 
     int headerLength = datagram->getHeaderLength();
     int payload = datagram->getByteLength() - headerLength;
+    int fragmentPayload = mtu - headerLength;
 
-    int noOfFragments =
-        int(ceil((float(payload)/mtu) /
-        (1-float(headerLength)/mtu) ) ); // FIXME ???
+    int noOfFragments = (payload + fragmentPayload - 1) / fragmentPayload;
 
     // if "don't fragment" bit is set, throw datagram away and send ICMP error message
     if (datagram->getDontFragment() && noOfFragments>1)
@@ -760,13 +770,30 @@ void IP::fragmentAndSend(IPDatagram *datagram, InterfaceEntry *ie, IPAddress nex
     std::string fragMsgName = datagram->getName();
     fragMsgName += "-frag";
 
-    // FIXME revise this!
+    // The encapsulated packet travels in the first fragment only, like the
+    // transport header does; the others carry just their length, so the
+    // payload is never copied. IPFragBuf returns the first fragment as the
+    // reassembled datagram. When a fragment is fragmented again, only the
+    // one that carries the packet passes it on.
+#if OMNETPP_VERSION > 0x0400
+    cPacket *transportPacket = datagram->getEncapsulatedPacket();
+#else
+    cPacket *transportPacket = datagram->getEncapsulatedMsg();
+#endif
+    if (transportPacket)
+    {
+        // a fragment is shorter than its encapsulated packet, which decapsulate() does not allow
+        datagram->setByteLength(headerLength + transportPacket->getByteLength());
+        transportPacket = datagram->decapsulate();
+    }
+    int offset = datagram->getFragmentOffset();
+
     for (int i=0; i<noOfFragments; i++)
     {
-        // FIXME is it ok that full encapsulated packet travels in every datagram fragment?
-        // should better travel in the last fragment only. Cf. with reassembly code!
         IPDatagram *fragment = (IPDatagram *) datagram->dup();
         fragment->setName(fragMsgName.c_str());
+        if (i == 0 && transportPacket)
+            fragment->encapsulate(transportPacket);
 
         // total_length equal to mtu, except for last fragment;
         // "more fragments" bit is unchanged in the last fragment, otherwise true
@@ -778,10 +805,9 @@ void IP::fragmentAndSend(IPDatagram *datagram, InterfaceEntry *ie, IPAddress nex
         else
         {
             // size of last fragment
-            int bytes = datagram->getByteLength() - (noOfFragments-1) * (mtu - datagram->getHeaderLength());
-            fragment->setByteLength(bytes);
+            fragment->setByteLength(headerLength + payload - (noOfFragments-1) * fragmentPayload);
         }
-        fragment->setFragmentOffset( i*(mtu - datagram->getHeaderLength()) );
+        fragment->setFragmentOffset(offset + i*fragmentPayload);
 
         sendDatagramToOutput(fragment, ie, nextHopAddr);
     }
@@ -1096,23 +1122,39 @@ void IP::reassembleAndDeliver(IPDatagram *datagram)
 #endif
 
 
+// ports of the datagram for the filter rules; -1 if it has none, also for
+// fragments other than the first, which do not carry the transport packet
+static void getTransportPorts(const IPDatagram *datagram, int& sport, int& dport)
+{
+    sport = dport = -1;
+#if OMNETPP_VERSION > 0x0400
+    cPacket *transportPacket = datagram->getEncapsulatedPacket();
+#else
+    cPacket *transportPacket = datagram->getEncapsulatedMsg();
+#endif
+    if (!transportPacket)
+        return;
+    if (datagram->getTransportProtocol()==IP_PROT_UDP)
+    {
+        UDPPacket *udpPacket = check_and_cast<UDPPacket *>(transportPacket);
+        sport = udpPacket->getSourcePort();
+        dport = udpPacket->getDestinationPort();
+    }
+    else if (datagram->getTransportProtocol()==IP_PROT_TCP)
+    {
+        TCPSegment *tcpseg = check_and_cast<TCPSegment *>(transportPacket);
+        sport = tcpseg->getSrcPort();
+        dport = tcpseg->getDestPort();
+    }
+}
+
 const IPRouteRule * IP::checkInputRule(const IPDatagram* datagram)
 {
     if (rt->getNumRules(false)>0)
     {
     	int protocol = datagram->getTransportProtocol();
-    	int sport=-1;
-    	int dport=-1;
-    	if (protocol==IP_PROT_UDP)
-    	{
-    		sport = dynamic_cast<UDPPacket*> (datagram->getEncapsulatedPacket())->getSourcePort();
-    		dport = dynamic_cast<UDPPacket*> (datagram->getEncapsulatedPacket())->getDestinationPort();
-    	}
-    	else if (protocol==IP_PROT_TCP)
-    	{
-    		sport = dynamic_cast<TCPSegment*> (datagram->getEncapsulatedPacket())->getSrcPort();
-    		dport = dynamic_cast<TCPSegment*> (datagram->getEncapsulatedPacket())->getDestPort();
-    	}
+    	int sport, dport;
+    	getTransportPorts(datagram, sport, dport);
     	IPDatagram *pkt = const_cast<IPDatagram*>(datagram);
     	InterfaceEntry *iface=getSourceInterfaceFrom(pkt);
     	const IPRouteRule *rule = rt->findRule(false,protocol,sport,datagram->getSrcAddress(),dport,datagram->getDestAddress(),iface);
@@ -1126,18 +1168,8 @@ const IPRouteRule * IP::checkOutputRule(const IPDatagram* datagram,const Interfa
     if (rt->getNumRules(true)>0)
     {
     	int protocol = datagram->getTransportProtocol();
-    	int sport=-1;
-    	int dport=-1;
-    	if (protocol==IP_PROT_UDP)
-    	{
-    		sport = dynamic_cast<UDPPacket*> (datagram->getEncapsulatedPacket())->getSourcePort();
-    		dport = dynamic_cast<UDPPacket*> (datagram->getEncapsulatedPacket())->getDestinationPort();
-    	}
-    	else if (protocol==IP_PROT_TCP)
-    	{
-    		sport = dynamic_cast<TCPSegment*> (datagram->getEncapsulatedPacket())->getSrcPort();
-    		dport = dynamic_cast<TCPSegment*> (datagram->getEncapsulatedPacket())->getDestPort();
-    	}
+    	int sport, dport;
+    	getTransportPorts(datagram, sport, dport);
     	InterfaceEntry *iface =NULL;
     	if (destIE)
             iface=const_cast<InterfaceEntry*>(destIE);
@@ -1158,18 +1190,8 @@ const IPRouteRule * IP::checkOutputRuleMulticast(const IPDatagram* datagram)
     if (rt->getNumRules(true)>0)
     {
     	int protocol = datagram->getTransportProtocol();
-    	int sport=-1;
-    	int dport=-1;
-    	if (protocol==IP_PROT_UDP)
-    	{
-    		sport = dynamic_cast<UDPPacket*> (datagram->getEncapsulatedPacket())->getSourcePort();
-    		dport = dynamic_cast<UDPPacket*> (datagram->getEncapsulatedPacket())->getDestinationPort();
-    	}
-    	else if (protocol==IP_PROT_TCP)
-    	{
-    		sport = dynamic_cast<TCPSegment*> (datagram->getEncapsulatedPacket())->getSrcPort();
-    		dport = dynamic_cast<TCPSegment*> (datagram->getEncapsulatedPacket())->getDestPort();
-    	}
+    	int sport, dport;
+    	getTransportPorts(datagram, sport, dport);
     	InterfaceEntry *iface =NULL;
     	const IPRouteRule *rule = rt->findRule(true,protocol,sport,datagram->getSrcAddress(),dport,datagram->getDestAddress(),iface);
     	return rule;
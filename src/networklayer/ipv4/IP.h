@@ -47,6 +47,8 @@ class INET_API IP : public QueueBase
     IInterfaceTable *ift;
     ICMPAccess icmpAccess;
     cGate *queueOutGate; // the most frequently used output gate
+    int transportInBaseId; // for dispatching on the arrival gate without comparing names
+    bool fastPath; // procDelay is zero: packets are processed right in handleMessage()
     bool manetRouting;
 
     // config
@@ -172,6 +174,12 @@ class INET_API IP : public QueueBase
      */
     virtual void initialize();
 
+    /**
+     * With zero procDelay, processes the packet at once, bypassing the
+     * queue machinery of QueueBase; otherwise defers to it.
+     */
+    virtual void handleMessage(cMessage *msg);
+
     /**
      * Processing of IP datagrams. Called when a datagram reaches the front
      * of the queue.
@@ -37,6 +37,7 @@ IPFragBuf::~IPFragBuf()
 			delete bufs.begin()->second.datagram;
 		bufs.erase(bufs.begin());
 	}
+	ageList.clear();
 }
 
 void IPFragBuf::init(ICMP *icmp)
@@ -58,8 +59,10 @@ IPDatagram *IPFragBuf::addFragment(IPDatagram *datagram, simtime_t now)
     if (i==bufs.end())
     {
         // this is the first fragment of that datagram, create reassembly buffer for it
-        buf = &bufs[key];
+        i = bufs.insert(std::make_pair(key, DatagramBuffer())).first;
+        buf = &(i->second);
         buf->datagram = NULL;
+        buf->age = ageList.insert(ageList.end(), i);
     }
     else
     {
@@ -74,12 +77,12 @@ IPDatagram *IPFragBuf::addFragment(IPDatagram *datagram, simtime_t now)
                                            !datagram->getMoreFragments());
 
     // store datagram. Only one fragment carries the actual modelled
-    // content (getEncapsulatedMsg()), other (empty) ones are only
-    // preserved so that we can send them in ICMP if reassembly times out.
+    // content (getEncapsulatedMsg()); an empty one is only kept until
+    // that arrives, so that there is something to return or to send in ICMP.
 #if OMNETPP_VERSION > 0x0400
-    if (datagram->getEncapsulatedPacket())
+    if (datagram->getEncapsulatedPacket() || !buf->datagram)
 #else
-    if (datagram->getEncapsulatedMsg())
+    if (datagram->getEncapsulatedMsg() || !buf->datagram)
 #endif
     {
         delete buf->datagram;
@@ -98,6 +101,7 @@ IPDatagram *IPFragBuf::addFragment(IPDatagram *datagram, simtime_t now)
         ret->setByteLength(ret->getHeaderLength()+buf->buf.getTotalLength());
         ret->setFragmentOffset(0);
         ret->setMoreFragments(false);
+        ageList.erase(buf->age);
         bufs.erase(i);
         return ret;
     }
@@ -105,38 +109,36 @@ IPDatagram *IPFragBuf::addFragment(IPDatagram *datagram, simtime_t now)
     {
         // there are still missing fragments
         buf->lastupdate = now;
+        ageList.splice(ageList.end(), ageList, buf->age);
         return NULL;
     }
 }
 
 void IPFragBuf::purgeStaleFragments(simtime_t lastupdate)
 {
-    // this method shouldn't be called too often because iteration on
-    // an std::map is *very* slow...
-
-    ASSERT(icmpModule);
-
-    for (Buffers::iterator i=bufs.begin(); i!=bufs.end(); )
+    while (!ageList.empty() && ageList.front()->second.lastupdate < lastupdate)
     {
-        // if too old, remove it
+        Buffers::iterator i = ageList.front();
         DatagramBuffer& buf = i->second;
-        if (buf.lastupdate < lastupdate)
+
+        if (buf.datagram->getFragmentOffset()==0)
         {
             // send ICMP error.
             // Note: receiver MUST NOT call decapsulate() on the datagram fragment,
             // because its length (being a fragment) is smaller than the encapsulated
             // packet, resulting in "length became negative" error. Use getEncapsulatedMsg().
+            ASSERT(icmpModule);
             EV << "datagram fragment timed out in reassembly buffer, sending ICMP_TIME_EXCEEDED\n";
             icmpModule->sendErrorMessage(buf.datagram, ICMP_TIME_EXCEEDED, 0);
-
-            // delete
-            Buffers::iterator oldi = i++;
-            bufs.erase(oldi);
         }
         else
         {
-            ++i;
+            EV << "datagram fragment timed out in reassembly buffer, first fragment missing\n";
+            delete buf.datagram;
         }
+
+        // delete
+        ageList.pop_front();
+        bufs.erase(i);
     }
 }
-
@@ -18,6 +18,7 @@
 #ifndef __INET_IPFRAGBUF_H
 #define __INET_IPFRAGBUF_H
 
+#include <list>
 #include <map>
 #include <vector>
 #include "INETDefs.h"
@@ -48,22 +49,32 @@ class INET_API IPFragBuf
         }
     };
 
+    struct DatagramBuffer;
+
+    // we use std::map for fast lookup by datagram Id
+    typedef std::map<Key,DatagramBuffer> Buffers;
+
+    // buffers in the order of their last update, oldest first
+    typedef std::list<Buffers::iterator> AgeList;
+
     //
     // Reassembly buffer for the datagram
     //
     struct DatagramBuffer
     {
         ReassemblyBuffer buf;  // reassembly buffer
-        IPDatagram *datagram;  // the actual datagram
+        IPDatagram *datagram;  // the fragment carrying the payload, or any fragment until that arrives
         simtime_t lastupdate;  // last time a new fragment arrived
+        AgeList::iterator age; // position in ageList
     };
 
-    // we use std::map for fast lookup by datagram Id
-    typedef std::map<Key,DatagramBuffer> Buffers;
-
     // the reassembly buffers
     Buffers bufs;
 
+    // lastupdate only grows, so moving an updated buffer to the back keeps
+    // this sorted and purging only has to look at the front
+    AgeList ageList;
+
     // needed for TIME_EXCEEDED errors
     ICMP *icmpModule;
 
@@ -94,7 +105,9 @@ class INET_API IPFragBuf
     /**
      * Throws out all fragments which are incomplete and their
      * last update (last fragment arrival) was before "lastupdate",
-     * and sends ICMP TIME EXCEEDED message about them.
+     * and sends ICMP TIME EXCEEDED message about them if the first
+     * fragment was received (RFC 1122 3.2.1.4). Only the timed out
+     * buffers are visited.
      *
      * Timeout should be between 60 seconds and 120 seconds (RFC1122).
      * This method should be called more frequently, maybe every
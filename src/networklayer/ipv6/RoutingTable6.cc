@@ -72,12 +72,14 @@ std::ostream& operator<<(std::ostream& os, const RoutingTable6::DestCacheEntry&
 
 RoutingTable6::RoutingTable6()
 {
+    trieRoot = new TrieNode();
 }
 
 RoutingTable6::~RoutingTable6()
 {
     for (unsigned int i=0; i<routeList.size(); i++)
         delete routeList[i];
+    trieDelete(trieRoot);
 }
 
 void RoutingTable6::initialize(int stage)
@@ -94,7 +96,8 @@ void RoutingTable6::initialize(int stage)
         nb->subscribe(this, NF_INTERFACE_IPv6CONFIG_CHANGED);
 
         WATCH_PTRVECTOR(routeList);
-        WATCH_MAP(destCache); // FIXME commented out for now
+        // destCache is a hash map, which WATCH_MAP cannot display; its size
+        // is shown in the display string
         isrouter = par("isRouter");
         WATCH(isrouter);
 
@@ -367,7 +370,7 @@ InterfaceEntry *RoutingTable6::getInterfaceByAddress(const IPv6Address& addr)
 
 bool RoutingTable6::isLocalAddress(const IPv6Address& dest) const
 {
-    Enter_Method("isLocalAddress(%s) y/n", dest.str().c_str());
+    Enter_Method_Silent(); // note: formatting dest would be too slow here
 
     // first, check if we have an interface with this address
     for (int i=0; i<ift->getNumInterfaces(); i++)
@@ -401,7 +404,7 @@ bool RoutingTable6::isLocalAddress(const IPv6Address& dest) const
 
 const IPv6Address& RoutingTable6::lookupDestCache(const IPv6Address& dest, int& outInterfaceId) const
 {
-    Enter_Method("lookupDestCache(%s)", dest.str().c_str());
+    Enter_Method_Silent(); // note: formatting dest would be too slow here
 
     DestCache::const_iterator it = destCache.find(dest);
     if (it == destCache.end())
@@ -415,27 +418,52 @@ const IPv6Address& RoutingTable6::lookupDestCache(const IPv6Address& dest, int&
 
 const IPv6Route *RoutingTable6::doLongestPrefixMatch(const IPv6Address& dest)
 {
-    Enter_Method("doLongestPrefixMatch(%s)", dest.str().c_str());
+    Enter_Method_Silent(); // note: formatting dest would be too slow here
 
-    // we'll just stop at the first match, because the table is sorted
-    // by prefix lengths and metric (see addRoute())
-    for (RouteList::const_iterator it=routeList.begin(); it!=routeList.end(); it++)
+    // walk down the trie along the bits of dest, remembering the nodes
+    // that carry routes; the deepest such node is the longest match
+    TrieNode *path[129];
+    int pathLen = 0;
+    TrieNode *node = trieRoot;
+    for (int depth = 0; node; depth++)
+    {
+        if (!node->routes.empty())
+            path[pathLen++] = node;
+        if (depth == 128)
+            break;
+        node = node->child[addressBit(dest, depth)];
+    }
+
+    // routes within a node are sorted by metric (see trieInsert()), so we
+    // can stop at the first one that has not expired
+    const IPv6Route *bestRoute = NULL;
+    RouteList expiredRoutes;
+    simtime_t now = simTime();
+    while (pathLen > 0 && !bestRoute)
     {
-        if (dest.matches((*it)->getDestPrefix(),(*it)->getPrefixLength()))
+        RouteList& routes = path[--pathLen]->routes;
+        for (RouteList::const_iterator it=routes.begin(); it!=routes.end(); it++)
         {
-            // FIXME proofread this code, iterator invalidation-wise, etc
-            bool entryExpired = false;
-            if (simTime() > (*it)->getExpiryTime() && (*it)->getExpiryTime() != 0)//since 0 represents infinity.
+            simtime_t expiryTime = (*it)->getExpiryTime();
+            if (expiryTime != 0 && now > expiryTime) // since 0 represents infinity
             {
                 EV << "Expired prefix detected!!" << endl;
-                removeOnLinkPrefix((*it)->getDestPrefix(), (*it)->getPrefixLength());
-                entryExpired = true;
+                if ((*it)->getSrc()==IPv6Route::FROM_RA)
+                    expiredRoutes.push_back(*it);
+            }
+            else
+            {
+                bestRoute = *it;
+                break;
             }
-            if (entryExpired == false) return *it;
         }
     }
-    // FIXME todo: if we selected an expired route, throw it out and select again!
-    return NULL;
+
+    // throw out expired prefixes only now, as that modifies the trie
+    for (RouteList::iterator it=expiredRoutes.begin(); it!=expiredRoutes.end(); it++)
+        removeOnLinkPrefix((*it)->getDestPrefix(), (*it)->getPrefixLength());
+
+    return bestRoute;
 }
 
 bool RoutingTable6::isPrefixPresent(const IPv6Address& prefix) const
@@ -448,9 +476,9 @@ bool RoutingTable6::isPrefixPresent(const IPv6Address& prefix) const
 
 void RoutingTable6::updateDestCache(const IPv6Address& dest, const IPv6Address& nextHopAddr, int interfaceId)
 {
-    // FIXME this performs 2 lookups -- optimize to do only one
-    destCache[dest].nextHopAddr = nextHopAddr;
-    destCache[dest].interfaceId = interfaceId;
+    DestCacheEntry& entry = destCache[dest];
+    entry.nextHopAddr = nextHopAddr;
+    entry.interfaceId = interfaceId;
 
     updateDisplayString();
 }
@@ -563,6 +591,7 @@ void RoutingTable6::removeOnLinkPrefix(const IPv6Address& destPrefix, int prefix
     {
         if ((*it)->getSrc()==IPv6Route::FROM_RA && (*it)->getDestPrefix()==destPrefix && (*it)->getPrefixLength()==prefixLength)
         {
+            trieRemove(*it);
             routeList.erase(it);
             return; // there can be only one such route, addOrUpdateOnLinkPrefix() guarantees that
         }
@@ -623,6 +652,7 @@ void RoutingTable6::addRoute(IPv6Route *route)
     // we keep entries sorted by prefix length in routeList, so that we can
     // stop at the first match when doing the longest prefix matching
     std::sort(routeList.begin(), routeList.end(), routeLessThan);
+    trieInsert(route);
 
     updateDisplayString();
 
@@ -636,12 +666,66 @@ void RoutingTable6::removeRoute(IPv6Route *route)
 
     nb->fireChangeNotification(NF_IPv6_ROUTE_DELETED, route); // rather: going to be deleted
 
+    trieRemove(route);
     routeList.erase(it);
     delete route;
 
     updateDisplayString();
 }
 
+void RoutingTable6::trieInsert(IPv6Route *route)
+{
+    const IPv6Address& prefix = route->getDestPrefix();
+    TrieNode *node = trieRoot;
+    for (int depth = 0; depth < route->getPrefixLength(); depth++)
+    {
+        TrieNode *&child = node->child[addressBit(prefix, depth)];
+        if (!child)
+            child = new TrieNode();
+        node = child;
+    }
+
+    // keep routes of the node ordered by metric, same as in routeList
+    RouteList& routes = node->routes;
+    routes.insert(std::upper_bound(routes.begin(), routes.end(), route, routeLessThan), route);
+}
+
+void RoutingTable6::trieRemove(IPv6Route *route)
+{
+    trieRemove(trieRoot, route, 0);
+}
+
+bool RoutingTable6::trieRemove(TrieNode *node, IPv6Route *route, int depth)
+{
+    // returns true if the node became empty and can be deleted by the caller
+    if (depth == route->getPrefixLength())
+    {
+        RouteList::iterator it = std::find(node->routes.begin(), node->routes.end(), route);
+        if (it != node->routes.end())
+            node->routes.erase(it);
+    }
+    else
+    {
+        int bit = addressBit(route->getDestPrefix(), depth);
+        TrieNode *child = node->child[bit];
+        if (child && trieRemove(child, route, depth+1))
+        {
+            delete child;
+            node->child[bit] = NULL;
+        }
+    }
+    return depth > 0 && node->routes.empty() && !node->child[0] && !node->child[1];
+}
+
+void RoutingTable6::trieDelete(TrieNode *node)
+{
+    if (!node)
+        return;
+    trieDelete(node->child[0]);
+    trieDelete(node->child[1]);
+    delete node;
+}
+
 int RoutingTable6::getNumRoutes() const
 {
     return routeList.size();
@@ -21,6 +21,7 @@
 #include <vector>
 #include <omnetpp.h>
 #include "INETDefs.h"
+#include "INETHashMap.h"
 #include "IPv6Address.h"
 #include "IInterfaceTable.h"
 #include "NotificationBoard.h"
@@ -116,7 +117,14 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable
         // more destination specific data may be added here, e.g. path MTU
     };
     friend std::ostream& operator<<(std::ostream& os, const DestCacheEntry& e);
-    typedef std::map<IPv6Address,DestCacheEntry> DestCache;
+    struct IPv6AddressHash
+    {
+        size_t operator()(const IPv6Address& a) const {
+            const uint32 *d = a.words();
+            return inet_hashmix(d[0] ^ d[1] ^ d[2] ^ inet_hashmix(d[3]));
+        }
+    };
+    typedef std::tr1::unordered_map<IPv6Address,DestCacheEntry,IPv6AddressHash> DestCache;
     DestCache destCache;
 
     // RouteList contains local prefixes, and (for routers)
@@ -124,11 +132,29 @@ class INET_API RoutingTable6 : public cSimpleModule, protected INotifiable
     typedef std::vector<IPv6Route*> RouteList;
     RouteList routeList;
 
+    // Binary trie over the 128 address bits, indexing the same routes as
+    // routeList. A node at depth n holds the routes with prefix length n,
+    // ordered by metric, so doLongestPrefixMatch() only has to walk the
+    // bits of the destination address.
+    struct TrieNode
+    {
+        TrieNode *child[2];
+        RouteList routes;
+        TrieNode() {child[0] = child[1] = NULL;}
+    };
+    TrieNode *trieRoot;
+
   protected:
     // internal: routes of different type can only be added via well-defined functions
     virtual void addRoute(IPv6Route *route);
     // helper for addRoute()
     static bool routeLessThan(const IPv6Route *a, const IPv6Route *b);
+    // helpers for maintaining the route trie
+    virtual void trieInsert(IPv6Route *route);
+    virtual void trieRemove(IPv6Route *route);
+    static bool trieRemove(TrieNode *node, IPv6Route *route, int depth);
+    static void trieDelete(TrieNode *node);
+    static int addressBit(const IPv6Address& addr, int i) {return (addr.words()[i>>5] >> (31-(i&31))) & 1;}
     // internal
     virtual void configureInterfaceForIPv6(InterfaceEntry *ie);
     /**
@@ -1195,28 +1195,25 @@ bool LDP::lookupLabel(IPDatagram *ipdatagram, LabelOpVector& outLabel, std::stri
         return false;
 
 #if OMNETPP_VERSION > 0x0400
-    // LDP traffic (both discovery...
-    if (protocol == IP_PROT_UDP && check_and_cast<UDPPacket*>(ipdatagram->getEncapsulatedPacket())->getDestinationPort() == LDP_PORT)
-        return false;
-
-    // ...and session)
-    if (protocol == IP_PROT_TCP && check_and_cast<TCPSegment*>(ipdatagram->getEncapsulatedPacket())->getDestPort() == LDP_PORT)
-        return false;
-    if (protocol == IP_PROT_TCP && check_and_cast<TCPSegment*>(ipdatagram->getEncapsulatedPacket())->getSrcPort() == LDP_PORT)
-        return false;
-
+    cPacket *transportPacket = ipdatagram->getEncapsulatedPacket();
 #else
-    // LDP traffic (both discovery...
-    if (protocol == IP_PROT_UDP && check_and_cast<UDPPacket*>(ipdatagram->getEncapsulatedMsg())->getDestinationPort() == LDP_PORT)
-        return false;
+    cPacket *transportPacket = ipdatagram->getEncapsulatedMsg();
+#endif
 
-    // ...and session)
-    if (protocol == IP_PROT_TCP && check_and_cast<TCPSegment*>(ipdatagram->getEncapsulatedMsg())->getDestPort() == LDP_PORT)
-        return false;
-    if (protocol == IP_PROT_TCP && check_and_cast<TCPSegment*>(ipdatagram->getEncapsulatedMsg())->getSrcPort() == LDP_PORT)
-        return false;
+    // non-first fragments carry no transport header, so they are
+    // classified like regular traffic
+    if (transportPacket)
+    {
+        // LDP traffic (both discovery...
+        if (protocol == IP_PROT_UDP && check_and_cast<UDPPacket*>(transportPacket)->getDestinationPort() == LDP_PORT)
+            return false;
 
-#endif
+        // ...and session)
+        if (protocol == IP_PROT_TCP && check_and_cast<TCPSegment*>(transportPacket)->getDestPort() == LDP_PORT)
+            return false;
+        if (protocol == IP_PROT_TCP && check_and_cast<TCPSegment*>(transportPacket)->getSrcPort() == LDP_PORT)
+            return false;
+    }
 
     // regular traffic, classify, label etc.
 
@@ -27,8 +27,9 @@
 
 void NS_CLASS packet_queue_init(void)
 {
-    INIT_LIST_HEAD(&PQ.head);
-    PQ.len = 0;
+    PQ.buffer.setMaxPackets(par("maxQueuedPackets"));
+    PQ.buffer.setMaxBytes(par("maxQueuedBytes").longValue());
+    PQ.buffer.setMaxAge(MAX_QUEUE_TIME / 1000.0);
 
 #ifdef GARBAGE_COLLECT
     /* Set up garbage collector */
@@ -41,20 +42,11 @@ void NS_CLASS packet_queue_init(void)
 
 void NS_CLASS packet_queue_destroy(void)
 {
-    int count = 0;
-    list_t *pos, *tmp;
-
-    list_foreach_safe(pos, tmp, &PQ.head)
-    {
-        struct q_pkt *qp = (struct q_pkt *)pos;
-        list_detach(pos);
-
-        delete  qp->p;
+    std::vector<cPacket *> pkts;
+    int count = PQ.buffer.takeAll(pkts);
 
-        free(qp);
-        count++;
-        PQ.len--;
-    }
+    for (unsigned int i = 0; i < pkts.size(); i++)
+        delete pkts[i];
 
     DEBUG(LOG_INFO, 0, "Destroyed %d buffered packets!", count);
 }
@@ -62,26 +54,11 @@ void NS_CLASS packet_queue_destroy(void)
 /* Garbage collect packets which have been queued for too long... */
 int NS_CLASS packet_queue_garbage_collect(void)
 {
-    int count = 0;
-    list_t *pos, *tmp;
-    struct timeval now;
+    std::vector<cPacket *> pkts;
+    int count = PQ.buffer.takeExpired(pkts);
 
-    gettimeofday(&now, NULL);
-
-    list_foreach_safe(pos, tmp, &PQ.head)
-    {
-        struct q_pkt *qp = (struct q_pkt *)pos;
-        if (timeval_diff(&now, &qp->q_time) > MAX_QUEUE_TIME)
-        {
-            list_detach(pos);
-            //icmpAccess.get()->sendErrorMessage(qp->p, ICMP_DESTINATION_UNREACHABLE, 0);
-            //   drop (qp->p);
-            sendICMP(qp->p);
-            free(qp);
-            count++;
-            PQ.len--;
-        }
-    }
+    for (unsigned int i = 0; i < pkts.size(); i++)
+        sendICMP(pkts[i]);
 
     if (count)
     {
@@ -90,57 +67,31 @@ int NS_CLASS packet_queue_garbage_collect(void)
 
     return count;
 }
-/* Buffer a packet in a FIFO queue. Implemented as a linked list,
-   where we add elements at the end and remove at the beginning.... */
+/* Buffer a packet in a FIFO queue, indexed by destination. When the
+   queue is full, the oldest packet is dropped. */
 
 void NS_CLASS packet_queue_add(cPacket * p, struct in_addr dest_addr)
 {
-    struct q_pkt *qp;
-    cPacket *dgram;
-
-    if (PQ.len >= MAX_QUEUE_LENGTH)
-    {
-        DEBUG(LOG_DEBUG, 0, "MAX Queue length! Removing first packet.");
-        if (!list_empty(&PQ.head))
-        {
-            qp = (struct q_pkt *)PQ.head.next;
-            list_detach(PQ.head.next);
-            dgram =qp->p;
-            // drop (dgram);
-            sendICMP(dgram);
-//  icmpAccess.get()->sendErrorMessage(dgram, ICMP_DESTINATION_UNREACHABLE, ICMP_AODV_QUEUE_FULL);
-            free(qp);
-            PQ.len--;
-        }
-    }
+    std::vector<cPacket *> evicted;
 
-    qp = (struct q_pkt *) malloc(sizeof(struct q_pkt));
+    PQ.buffer.add(dest_addr.s_addr, p, p->getByteLength(), evicted);
 
-    if (qp == NULL)
+    for (unsigned int i = 0; i < evicted.size(); i++)
     {
-        fprintf(stderr, "Malloc failed!\n");
-        exit(-1);
+        DEBUG(LOG_DEBUG, 0, "MAX Queue length! Removing first packet.");
+        sendICMP(evicted[i]);
     }
 
-    qp->p = p;
-    qp->dest_addr = dest_addr;
-
-    gettimeofday(&qp->q_time, NULL);
-
-    list_add_tail(&PQ.head, &qp->l);
-
-    PQ.len++;
-
     DEBUG(LOG_INFO, 0, "buffered pkt to %s qlen=%u",
-          ip_to_str(dest_addr), PQ.len);
+          ip_to_str(dest_addr), PQ.buffer.getNumPackets());
 }
 
 int NS_CLASS packet_queue_set_verdict(struct in_addr dest_addr, int verdict)
 {
     int count = 0;
     rt_table_t *rt, *next_hop_rt, *inet_rt = NULL;
-    list_t *pos, *tmp;
     struct in_addr gw_addr;
+    std::vector<cPacket *> pkts;
 
     double delay = 0;
 #define ARP_DELAY 0.005
@@ -153,54 +104,49 @@ int NS_CLASS packet_queue_set_verdict(struct in_addr dest_addr, int verdict)
     else
         rt = rt_table_find(dest_addr);
 
-    list_foreach_safe(pos, tmp, &PQ.head)
-    {
+    // without a route the packets stay queued
+    if (verdict == PQ_SEND && !rt)
+        return PQ.buffer.contains(dest_addr.s_addr) ? -1 : 0;
 
-        struct q_pkt *qp = (struct q_pkt *)pos;
-        if (qp->dest_addr.s_addr == dest_addr.s_addr)
-        {
-            list_detach(pos);
+    count = PQ.buffer.take(dest_addr.s_addr, pkts);
 
-            switch (verdict)
+    for (unsigned int i = 0; i < pkts.size(); i++)
+    {
+        cPacket *p = pkts[i];
+        switch (verdict)
+        {
+        case PQ_ENC_SEND:
+            if (dynamic_cast <IPDatagram *> (p))
             {
-            case PQ_ENC_SEND:
-                if (dynamic_cast <IPDatagram *> (qp->p))
-                {
-                    qp->p = pkt_encapsulate(dynamic_cast <IPDatagram *> (qp->p), *gateWayAddress);
-                    // now Ip layer decremented again
-                    /* Apparently, the link layer implementation can't handle
-                     a burst of packets. So to keep ARP happy, buffered              *                   *
-                     packets are sent with ARP_DELAY seconds between sends. */
-                    sendDelayed (qp->p,delay,"to_ip");
-                    delay += ARP_DELAY;
-                }
-                else
-                {
-                    // drop(qp->p);
-                    sendICMP(qp->p);
-                }
-                break;
-            case PQ_SEND:
-                if (!rt)
-                    return -1;
-                /* Apparently, the link layer implementation can't handle
-                 * a burst of packets. So to keep ARP happy, buffered
-                 * packets are sent with ARP_DELAY seconds between
-                 * sends. */
+                p = pkt_encapsulate(dynamic_cast <IPDatagram *> (p), *gateWayAddress);
                 // now Ip layer decremented again
-                sendDelayed(qp->p, delay, "to_ip");
+                /* Apparently, the link layer implementation can't handle
+                 a burst of packets. So to keep ARP happy, buffered              *                   *
+                 packets are sent with ARP_DELAY seconds between sends. */
+                sendDelayed (p,delay,"to_ip");
                 delay += ARP_DELAY;
-                break;
-            case PQ_DROP:
-                //drop(qp->p);
-                sendICMP(qp->p);
-
-//              icmpAccess.get()->sendErrorMessage(qp->p, ICMP_DESTINATION_UNREACHABLE, 0);
-                break;
             }
-            free(qp);
-            count++;
-            PQ.len--;
+            else
+            {
+                // drop(p);
+                sendICMP(p);
+            }
+            break;
+        case PQ_SEND:
+            /* Apparently, the link layer implementation can't handle
+             * a burst of packets. So to keep ARP happy, buffered
+             * packets are sent with ARP_DELAY seconds between
+             * sends. */
+            // now Ip layer decremented again
+            sendDelayed(p, delay, "to_ip");
+            delay += ARP_DELAY;
+            break;
+        case PQ_DROP:
+            //drop(p);
+            sendICMP(p);
+
+//          icmpAccess.get()->sendErrorMessage(p, ICMP_DESTINATION_UNREACHABLE, 0);
+            break;
         }
     }
     /* Update rt timeouts */
@@ -222,7 +168,7 @@ int NS_CLASS packet_queue_set_verdict(struct in_addr dest_addr, int verdict)
         }
 
         DEBUG(LOG_INFO, 0, "SENT %d packets to %s qlen=%u",
-              count, ip_to_str(dest_addr), PQ.len);
+              count, ip_to_str(dest_addr), PQ.buffer.getNumPackets());
     }
     else if (verdict == PQ_DROP)
     {
@@ -232,4 +178,3 @@ int NS_CLASS packet_queue_set_verdict(struct in_addr dest_addr, int verdict)
 
     return count;
 }
-
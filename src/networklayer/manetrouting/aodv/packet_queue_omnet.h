@@ -24,12 +24,11 @@
 
 #ifndef NS_NO_GLOBALS
 
-#define MAX_QUEUE_LENGTH 512
 #define MAX_QUEUE_TIME 10000 /* Maximum time packets can be queued (ms) */
 #define GARBAGE_COLLECT_TIME 1000 /* Interval between running the
 * garbage collector (ms) */
 #include "aodv-uu/defs_aodv.h"
-#include "aodv-uu/list.h"
+#include "ManetPendingBuffer.h"
 
 /* Verdicts for queued packets: */
 enum
@@ -39,18 +38,9 @@ enum
     PQ_ENC_SEND = 2
 };
 
-struct q_pkt
-{
-    list_t l;
-    struct in_addr  dest_addr;
-    struct timeval q_time;
-    cPacket *p;
-};
-
 struct packet_queue
 {
-    list_t head;
-    unsigned int len;
+    ManetPendingBuffer<cPacket *> buffer;
     struct timer garbage_collect_timer;
 };
 
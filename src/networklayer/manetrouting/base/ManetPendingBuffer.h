@@ -0,0 +1,228 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef __INET_MANETPENDINGBUFFER_H
+#define __INET_MANETPENDINGBUFFER_H
+
+#include <list>
+#include <vector>
+#include <omnetpp.h>
+#include "INETHashMap.h"
+#include "uint128.h"
+
+/**
+ * Packets waiting for a route, as buffered by the on-demand MANET routing
+ * protocols while route discovery is in progress. The packets are kept
+ * in arrival order and indexed by destination, so the packets to one
+ * destination can be taken out (to be sent or dropped) without looking
+ * at the rest.
+ *
+ * The buffer can be limited in packets and in bytes; when a new packet
+ * does not fit, the oldest packets are evicted, whatever their
+ * destination. Packets that have waited maxAge are returned by
+ * takeExpired(). Evicted and expired packets are handed back to the
+ * caller, who owns them; so is disposing of the packets left in the
+ * buffer (see takeAll()).
+ *
+ * T is what the protocol keeps about a packet, e.g. a cPacket pointer.
+ */
+template <class T>
+class ManetPendingBuffer
+{
+  protected:
+    struct Entry
+    {
+        T item;
+        Uint128 dest;
+        int bytes;
+        simtime_t queueTime;
+    };
+    typedef std::list<Entry> EntryList;
+    typedef typename EntryList::iterator EntryIterator;
+    typedef std::list<EntryIterator> DestEntries;   // packets to one destination, oldest first
+
+    struct AddressHash
+    {
+        size_t operator()(const Uint128& a) const {
+            uint64_t lo = a.toUint64();
+            return inet_hashmix((uint32)lo ^ (uint32)(lo >> 32));
+        }
+    };
+    typedef std::tr1::unordered_map<Uint128, DestEntries, AddressHash> DestMap;
+
+    EntryList entries;   // all packets, oldest first
+    DestMap byDest;
+    int numPackets;
+    long numBytes;
+    int maxPackets;      // -1: no limit
+    long maxBytes;       // -1: no limit
+    simtime_t maxAge;    // 0: no limit
+
+    void removeOldest(std::vector<T>& removed)
+    {
+        Entry& e = entries.front();
+        typename DestMap::iterator it = byDest.find(e.dest);
+        it->second.pop_front();
+        if (it->second.empty())
+            byDest.erase(it);
+        removed.push_back(e.item);
+        numPackets--;
+        numBytes -= e.bytes;
+        entries.pop_front();
+    }
+
+  public:
+    ManetPendingBuffer() : numPackets(0), numBytes(0), maxPackets(-1), maxBytes(-1), maxAge(0) {}
+
+    void setMaxPackets(int n) {maxPackets = n;}
+    void setMaxBytes(long n) {maxBytes = n;}
+    void setMaxAge(simtime_t t) {maxAge = t;}
+
+    int getNumPackets() const {return numPackets;}
+    long getNumBytes() const {return numBytes;}
+    bool empty() const {return numPackets==0;}
+
+    /**
+     * Appends a packet to dest. If the buffer is over its limits
+     * afterwards, the oldest packets are removed and appended to evicted
+     * (this may be the new packet itself if it is larger than maxBytes).
+     */
+    void add(const Uint128& dest, const T& item, int bytes, std::vector<T>& evicted)
+    {
+        Entry e;
+        e.item = item;
+        e.dest = dest;
+        e.bytes = bytes;
+        e.queueTime = simTime();
+        entries.push_back(e);
+        byDest[dest].push_back(--entries.end());
+        numPackets++;
+        numBytes += bytes;
+
+        while ((maxPackets!=-1 && numPackets>maxPackets) || (maxBytes!=-1 && numBytes>maxBytes))
+            removeOldest(evicted);
+    }
+
+    /** True if there are packets to dest */
+    bool contains(const Uint128& dest) const {return byDest.find(dest)!=byDest.end();}
+
+    /** The oldest packet to dest, or NULL */
+    T *front(const Uint128& dest)
+    {
+        typename DestMap::iterator it = byDest.find(dest);
+        return it==byDest.end() ? NULL : &it->second.front()->item;
+    }
+
+    /**
+     * Removes the packets to dest and appends them to items, oldest first.
+     * Returns their number.
+     */
+    int take(const Uint128& dest, std::vector<T>& items)
+    {
+        typename DestMap::iterator it = byDest.find(dest);
+        if (it==byDest.end())
+            return 0;
+        DestEntries& list = it->second;
+        int count = 0;
+        for (typename DestEntries::iterator i = list.begin(); i!=list.end(); ++i, ++count)
+        {
+            items.push_back((*i)->item);
+            numBytes -= (*i)->bytes;
+            entries.erase(*i);
+        }
+        numPackets -= count;
+        byDest.erase(it);
+        return count;
+    }
+
+    /**
+     * Removes the packets whose destination satisfies pred, and appends
+     * them to items in arrival order. Returns their number. Walks the
+     * whole buffer; use take() if the destination is known.
+     */
+    template <class Pred>
+    int takeIf(Pred pred, std::vector<T>& items)
+    {
+        int count = 0;
+        EntryIterator e = entries.begin();
+        while (e!=entries.end())
+        {
+            if (!pred(e->dest))
+            {
+                ++e;
+                continue;
+            }
+            // visiting oldest first, e is the oldest packet left to its destination
+            typename DestMap::iterator it = byDest.find(e->dest);
+            it->second.pop_front();
+            if (it->second.empty())
+                byDest.erase(it);
+            items.push_back(e->item);
+            numPackets--;
+            numBytes -= e->bytes;
+            e = entries.erase(e);
+            count++;
+        }
+        return count;
+    }
+
+    /**
+     * Removes the packets that have waited maxAge or longer and appends
+     * them to items. Returns their number.
+     */
+    int takeExpired(std::vector<T>& items)
+    {
+        int count = 0;
+        if (maxAge==0)
+            return count;
+        simtime_t limit = simTime() - maxAge;
+        while (!entries.empty() && entries.front().queueTime <= limit)
+        {
+            removeOldest(items);
+            count++;
+        }
+        return count;
+    }
+
+    /** Arrival time of the oldest packet; the buffer must not be empty */
+    simtime_t getOldestQueueTime() const {return entries.front().queueTime;}
+
+    /** Removes all packets and appends them to items, oldest first */
+    int takeAll(std::vector<T>& items)
+    {
+        int count = numPackets;
+        while (!entries.empty())
+            removeOldest(items);
+        return count;
+    }
+
+    /** Appends the destinations with packets to dests */
+    void getDestinations(std::vector<Uint128>& dests) const
+    {
+        for (typename DestMap::const_iterator it = byDest.begin(); it!=byDest.end(); ++it)
+            dests.push_back(it->first);
+    }
+
+    /** Number of packets to dest */
+    int getNumPacketsTo(const Uint128& dest) const
+    {
+        typename DestMap::const_iterator it = byDest.find(dest);
+        return it==byDest.end() ? 0 : it->second.size();
+    }
+};
+
+#endif
+
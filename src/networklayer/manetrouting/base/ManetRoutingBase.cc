@@ -675,7 +675,10 @@ void ManetRoutingBase::omnet_chg_rte (const Uint128 &dst, const Uint128 &gtwy, c
     }
 
     if (mac_layer_)
+    {
+        notifyRouteChanged();
         return;
+    }
 
     bool found = false;
     for (int i=inet_rt->getNumRoutes(); i>0 ; --i)
@@ -770,7 +773,10 @@ void ManetRoutingBase::omnet_chg_rte (const Uint128 &dst, const Uint128 &gtwy, c
          }
     }
     if (mac_layer_)
+    {
+        notifyRouteChanged();
         return;
+    }
     bool found = false;
     for (int i=inet_rt->getNumRoutes(); i>0 ; --i)
     {
@@ -866,7 +872,10 @@ void ManetRoutingBase::omnet_clean_rte ()
 
     const IPRoute *entry;
     if (mac_layer_)
+    {
+        notifyRouteChanged();
         return;
+    }
     // clean the route table wlan interface entry
     for (int i=inet_rt->getNumRoutes()-1; i>=0; i--)
     {
@@ -878,6 +887,13 @@ void ManetRoutingBase::omnet_clean_rte ()
     }
 }
 
+void ManetRoutingBase::notifyRouteChanged()
+{
+    // Ieee80211Mesh caches the next hops it got from the protocol
+    if (mac_layer_)
+        nb->fireChangeNotification(NF_MESH_ROUTE_CHANGED, this);
+}
+
 //
 // generic receiveChangeNotification, the protocols must implemet processLinkBreak and processPromiscuous only
 //
@@ -165,6 +165,12 @@ class INET_API ManetRoutingBase : public cSimpleModule, public INotifiable
     virtual bool omnet_exist_rte (struct in_addr dst);
     virtual void omnet_clean_rte ();
 
+//
+// Tells Ieee80211Mesh that the routes changed, called by omnet_chg_rte and
+// omnet_clean_rte; protocols with their own table in the mac layer call it directly
+//
+    virtual void notifyRouteChanged();
+
 /////////////////////////
 //  Cross layer routines
 /////////////////////////
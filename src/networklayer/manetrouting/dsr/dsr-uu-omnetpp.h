@@ -206,7 +206,7 @@ class DSRUU:public cSimpleModule, public INotifiable
 
     struct tbl rreq_tbl;
     struct tbl grat_rrep_tbl;
-    struct tbl send_buf;
+    ManetPendingBuffer<struct send_buf_entry> send_buf;
     struct tbl neigh_tbl;
     struct tbl maint_buf;
 
@@ -34,149 +34,60 @@
 #include "dsr-srt.h"
 #include "timer.h"
 
-#ifdef __KERNEL__
-#define SEND_BUF_PROC_FS_NAME "send_buf"
-
-TBL(send_buf, SEND_BUF_MAX_LEN);
-static DSRUUTimer send_buf_timer;
-static int send_buf_print(struct tbl *t, char *buffer);
-#endif
-
-struct send_buf_entry
-{
-    list_t l;
-    struct dsr_pkt *dp;
-    struct timeval qtime;
-    xmit_fct_t okfn;
-};
-
+/* The send buffer is a ManetPendingBuffer, so packets to a destination
+ * are found without scanning the others. This file is always compiled
+ * with OMNETPP defined (see the top of the file); the Linux kernel and
+ * ns-2 code paths of the original DSR-UU, which kept the packets in a
+ * struct tbl, are not part of this port. */
 
-static inline int crit_addr(void *pos, void *addr)
-{
-    struct in_addr *a = (struct in_addr *)addr;
-    struct send_buf_entry *e = (struct send_buf_entry *)pos;
-
-    if (e->dp->dst.s_addr == a->s_addr)
-        return 1;
-    return 0;
-}
-
-static inline int crit_garbage(void *pos, void *n)
+void NSCLASS send_buf_set_max_len(unsigned int max_len)
 {
-    struct timeval *now = (struct timeval *)n;
-    struct send_buf_entry *e = (struct send_buf_entry *)pos;
-
-    if (timeval_diff(now, &e->qtime) >=
-            (int)ConfValToUsecs(SendBufferTimeout))
-    {
-        if (e->dp)
-            dsr_pkt_free(e->dp);
-        return 1;
-    }
-    return 0;
+    send_buf.setMaxPackets(max_len);
 }
 
-
-
-void NSCLASS send_buf_set_max_len(unsigned int max_len)
+int NSCLASS send_buf_find(struct in_addr dst)
 {
-    send_buf.max_len = max_len;
+    return send_buf.contains(dst.s_addr);
 }
 
 void NSCLASS send_buf_timeout(unsigned long data)
 {
-    struct send_buf_entry *e;
-    int pkts;
-    struct timeval expires, now;
-    /*  char buf[2048]; */
+    std::vector<struct send_buf_entry> expired;
+    int pkts = send_buf.takeExpired(expired);
 
-    gettime(&now);
-
-    /*  send_buf_print(&send_buf, buf); */
-    /*  DEBUG("\n%s\n", buf); */
-
-    pkts = tbl_for_each_del(&send_buf, &now, crit_garbage);
+    for (unsigned int i = 0; i < expired.size(); i++)
+        dsr_pkt_free(expired[i].dp);
 
     DEBUG("%d packets garbage collected\n", pkts);
 
-    DSR_READ_LOCK(&send_buf.lock);
-    /* Get first packet in maintenance buffer */
-    e = (struct send_buf_entry *)__tbl_find(&send_buf, NULL, crit_none);
-
-    if (!e)
+    if (send_buf.empty())
     {
         DEBUG("No packet to set timeout for\n");
-        DSR_READ_UNLOCK(&send_buf.lock);
         return;
     }
-    expires = e->qtime;
 
-    timeval_add_usecs(&expires, ConfValToUsecs(SendBufferTimeout));
-
-    DEBUG("now=%s qtime=%s exp=%s\n", print_timeval(&now), print_timeval(&e->qtime), print_timeval(&expires));
-    DSR_READ_UNLOCK(&send_buf.lock);
-
-    set_timer(&send_buf_timer, &expires);
-}
-#ifdef OMNETPP
-struct send_buf_entry * NSCLASS send_buf_entry_create(struct dsr_pkt *dp,xmit_fct_t okfn)
-#else
-static struct send_buf_entry *  send_buf_entry_create(struct dsr_pkt *dp,xmit_fct_t okfn)
-#endif
-{
-    struct send_buf_entry *e;
-
-    e = (struct send_buf_entry *)MALLOC(sizeof(*e), GFP_ATOMIC);
-
-    if (!e)
-        return NULL;
-
-    e->dp = dp;
-    e->okfn = okfn;
-    gettime(&e->qtime);
-
-    return e;
+    /* Expire the first packet in the buffer */
+    set_timer(&send_buf_timer, SIMTIME_DBL(send_buf.getOldestQueueTime()) +
+              ConfValToUsecs(SendBufferTimeout) / 1000000.0);
 }
 
 int NSCLASS send_buf_enqueue_packet(struct dsr_pkt *dp, xmit_fct_t okfn)
 {
-    struct send_buf_entry *e;
+    struct send_buf_entry e;
+    std::vector<struct send_buf_entry> evicted;
     struct timeval expires;
-    int res, empty = 0;
-
-    if (tbl_empty(&send_buf))
-        empty = 1;
-
-    e = send_buf_entry_create(dp, okfn);
-
-    if (!e)
-        return -ENOMEM;
+    int empty = send_buf.empty();
 
     DEBUG("enqueing packet to %s\n", print_ip(dp->dst));
 
-    res = tbl_add_tail(&send_buf, &e->l);
+    e.dp = dp;
+    e.okfn = okfn;
+    send_buf.add(dp->dst.s_addr, e, IP_HDR_LEN + dsr_pkt_opts_len(dp) + dp->payload_len, evicted);
 
-    if (res < 0)
+    for (unsigned int i = 0; i < evicted.size(); i++)
     {
-        struct send_buf_entry *f;
-
         DEBUG("buffer full, removing first\n");
-        f = (struct send_buf_entry *)tbl_detach_first(&send_buf);
-
-        if (f)
-        {
-            dsr_pkt_free(f->dp);
-            FREE(f);
-        }
-
-        res = tbl_add_tail(&send_buf, &e->l);
-
-        if (res < 0)
-        {
-            DEBUG("Could not buffer packet\n");
-            FREE(e);
-            return -1;
-        }
+        dsr_pkt_free(evicted[i].dp);
     }
 
     if (empty)
@@ -186,42 +97,27 @@ int NSCLASS send_buf_enqueue_packet(struct dsr_pkt *dp, xmit_fct_t okfn)
         set_timer(&send_buf_timer, &expires);
     }
 
-    return res;
+    return send_buf.getNumPackets();
 }
 
 int NSCLASS send_buf_set_verdict(int verdict, struct in_addr dst)
 {
-    struct send_buf_entry *e;
-    int pkts = 0;
+    std::vector<struct send_buf_entry> entries;
+    int pkts = send_buf.take(dst.s_addr, entries);
 
     switch (verdict)
     {
     case SEND_BUF_DROP:
 
-        while ((e =
-                    (struct send_buf_entry *)tbl_find_detach(&send_buf,
-                            &dst,
-                            crit_addr)))
-        {
-            /* Only send one ICMP message */
-#ifdef __KERNEL__
-            if (pkts == 0)
-                icmp_send(e->dp->skb, ICMP_DEST_UNREACH,
-                          ICMP_HOST_UNREACH, 0);
-#endif
-            dsr_pkt_free(e->dp);
-            FREE(e);
-            pkts++;
-        }
+        for (unsigned int i = 0; i < entries.size(); i++)
+            dsr_pkt_free(entries[i].dp);
         DEBUG("Dropped %d queued pkts for %s\n", pkts, print_ip(dst));
         break;
     case SEND_BUF_SEND:
 
-        while ((e =
-                    (struct send_buf_entry *)tbl_find_detach(&send_buf,
-                            &dst,
-                            crit_addr)))
+        for (unsigned int i = 0; i < entries.size(); i++)
         {
+            struct send_buf_entry *e = &entries[i];
             DEBUG("Send packet\n");
             /* Get source route */
             e->dp->srt = dsr_rtc_find(e->dp->src, e->dp->dst);
@@ -235,18 +131,11 @@ int NSCLASS send_buf_set_verdict(int verdict, struct in_addr dst)
                     dsr_pkt_free(e->dp);
                 }
                 else
+                {
                     /* Send packet */
-#ifdef OMNETPP
-
                     AddCost(e->dp,e->dp->srt);
-                (this->*e->okfn) (e->dp);
-#else
-#ifdef NS2
                     (this->*e->okfn) (e->dp);
-#else
-                e->okfn(e->dp);
-#endif
-#endif
+                }
             }
             else
             {
@@ -255,8 +144,6 @@ int NSCLASS send_buf_set_verdict(int verdict, struct in_addr dst)
 
                 dsr_pkt_free(e->dp);
             }
-            pkts++;
-            FREE(e);
         }
         DEBUG("Sent %d queued packets to %s\n", pkts, print_ip(dst));
 
@@ -267,88 +154,11 @@ int NSCLASS send_buf_set_verdict(int verdict, struct in_addr dst)
     return pkts;
 }
 
-static inline int send_buf_flush(struct tbl *t)
-{
-    struct send_buf_entry *e;
-    int pkts = 0;
-    /* Flush send buffer */
-    while ((e =
-                (struct send_buf_entry *)tbl_find_detach(t, NULL, crit_none)))
-    {
-        dsr_pkt_free(e->dp);
-        FREE(e);
-        pkts++;
-    }
-    return pkts;
-}
-
-#ifdef __KERNEL__
-static int send_buf_print(struct tbl *t, char *buffer)
-{
-    list_t *p;
-    int len;
-    struct timeval now;
-
-    gettime(&now);
-
-    len = sprintf(buffer, "# %-15s %-8s\n", "IPAddr", "Age (s)");
-
-    DSR_READ_LOCK(&t->lock);
-
-    list_for_each(p, &t->head)
-    {
-        struct send_buf_entry *e = (struct send_buf_entry *)p;
-
-        if (e && e->dp)
-            len += sprintf(buffer + len, "  %-15s %-8lu\n",
-                           print_ip(e->dp->dst),
-                           timeval_diff(&now, &e->qtime) / 1000000);
-    }
-
-    len += sprintf(buffer + len,
-                   "\nQueue length      : %u\n"
-                   "Queue max. length : %u\n", t->len, t->max_len);
-
-    DSR_READ_UNLOCK(&t->lock);
-
-    return len;
-}
-
-static int
-send_buf_get_info(char *buffer, char **start, off_t offset, int length)
-{
-    int len;
-
-    len = send_buf_print(&send_buf, buffer);
-
-    *start = buffer + offset;
-    len -= offset;
-
-    if (len > length)
-        len = length;
-    else if (len < 0)
-        len = 0;
-    return len;
-}
-
-#endif              /* __KERNEL__ */
-
 int __init NSCLASS send_buf_init(void)
 {
-#ifdef __KERNEL__
-    struct proc_dir_entry *proc;
-
-    proc = proc_net_create(SEND_BUF_PROC_FS_NAME, 0, send_buf_get_info);
-    if (proc)
-        proc->owner = THIS_MODULE;
-    else
-    {
-        printk(KERN_ERR "send_buf: failed to create proc entry\n");
-        return -1;
-    }
-#endif
-
-    INIT_TBL(&send_buf, SEND_BUF_MAX_LEN);
+    send_buf.setMaxPackets(ConfVal(SendBufferSize));
+    send_buf.setMaxBytes(par("SendBufferBytes").longValue());
+    send_buf.setMaxAge(ConfValToUsecs(SendBufferTimeout) / 1000000.0);
 
     init_timer(&send_buf_timer);
 
@@ -359,18 +169,16 @@ int __init NSCLASS send_buf_init(void)
 
 void __exit NSCLASS send_buf_cleanup(void)
 {
+    std::vector<struct send_buf_entry> entries;
     int pkts;
-#ifdef KERNEL26
-    synchronize_net();
-#endif
+
     if (timer_pending(&send_buf_timer))
         del_timer_sync(&send_buf_timer);
 
-    pkts = send_buf_flush(&send_buf);
+    /* Flush send buffer */
+    pkts = send_buf.takeAll(entries);
+    for (unsigned int i = 0; i < entries.size(); i++)
+        dsr_pkt_free(entries[i].dp);
 
     DEBUG("Flushed %d packets\n", pkts);
-
-#ifdef __KERNEL__
-    proc_net_remove(SEND_BUF_PROC_FS_NAME);
-#endif
 }
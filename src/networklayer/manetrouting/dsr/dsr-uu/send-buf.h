@@ -24,7 +24,14 @@ typedef int (*xmit_fct_t) (struct dsr_pkt *);
 #endif
 #else
 #include "dsr-uu-omnetpp.h"
+#include "ManetPendingBuffer.h"
 typedef void (DSRUU::*xmit_fct_t) (struct dsr_pkt *);
+
+struct send_buf_entry
+{
+    struct dsr_pkt *dp;
+    xmit_fct_t okfn;
+};
 #endif /* OMNETPP */
 
 #endif              /* NO_GLOBALS */
@@ -32,10 +39,6 @@ typedef void (DSRUU::*xmit_fct_t) (struct dsr_pkt *);
 #ifndef NO_DECLS
 
 
-#ifdef OMNETPP
-struct send_buf_entry * send_buf_entry_create(struct dsr_pkt *dp,xmit_fct_t okfn);
-#endif
-
 void send_buf_set_max_len(unsigned int max_len);
 int send_buf_find(struct in_addr dst);
 int send_buf_enqueue_packet(struct dsr_pkt *dp, xmit_fct_t okfn);
@@ -27,9 +27,9 @@
 
 void NS_CLASS packet_queue_init(void)
 {
-
-    INIT_DLIST_HEAD(&PQ.head);
-    PQ.len = 0;
+    PQ.buffer.setMaxPackets(par("maxQueuedPackets"));
+    PQ.buffer.setMaxBytes(par("maxQueuedBytes").longValue());
+    PQ.buffer.setMaxAge(MAX_QUEUE_TIME / 1000.0);
 
 #ifdef GARBAGE_COLLECT
     /* Set up garbage collector */
@@ -42,22 +42,12 @@ void NS_CLASS packet_queue_init(void)
 
 void NS_CLASS packet_queue_destroy(void)
 {
-    int count = 0;
-    dlist_head_t *pos, *tmp;
-    if (!dlist_empty(&PQ.head))
-    {
-       dlist_for_each_safe(pos, tmp, &PQ.head)
-       {
-    	   struct q_pkt *qp = (struct q_pkt *)pos;
-    	   dlist_del(pos);
+    std::vector<struct q_pkt> pkts;
+    int count = PQ.buffer.takeAll(pkts);
 
-    	   delete  qp->p;
+    for (unsigned int i = 0; i < pkts.size(); i++)
+        delete pkts[i].p;
 
-    	   free(qp);
-    	   count++;
-    	   PQ.len--;
-       }
-    }
     dlog(LOG_INFO, 0, __FUNCTION__, "Dropped %d buffered packets", count);
     //  DEBUG(LOG_INFO, 0, "Destroyed %d buffered packets!", count);
 }
@@ -65,27 +55,11 @@ void NS_CLASS packet_queue_destroy(void)
 /* Garbage collect packets which have been queued for too long... */
 int NS_CLASS packet_queue_garbage_collect(void)
 {
-    int count = 0;
-    dlist_head_t *pos, *tmp;
-    struct timeval now;
-
-    gettimeofday(&now, NULL);
+    std::vector<struct q_pkt> pkts;
+    int count = PQ.buffer.takeExpired(pkts);
 
-    dlist_for_each_safe(pos, tmp, &PQ.head)
-    {
-        struct q_pkt *qp = (struct q_pkt *)pos;
-        if (timeval_diff(&now, &qp->q_time) > MAX_QUEUE_TIME)
-        {
-
-            dlist_del(pos);
-            //icmpAccess.get()->sendErrorMessage(qp->p, ICMP_DESTINATION_UNREACHABLE, 0);
-            //drop(qp->p);
-            sendICMP(qp->p);
-            free(qp);
-            count++;
-            PQ.len--;
-        }
-    }
+    for (unsigned int i = 0; i < pkts.size(); i++)
+        sendICMP(pkts[i].p);
 
     if (count)
     {
@@ -94,60 +68,35 @@ int NS_CLASS packet_queue_garbage_collect(void)
 
     return count;
 }
-/* Buffer a packet in a FIFO queue. Implemented as a linked list,
-   where we add elements at the end and remove at the beginning.... */
+/* Buffer a packet in a FIFO queue, indexed by destination. When the
+   queue is full, the oldest packet is dropped. */
 
 void NS_CLASS packet_queue_add(cPacket * p, struct in_addr dest_addr)
 {
-    struct q_pkt *qp;
-    cPacket *dgram;
+    struct q_pkt qp;
+    std::vector<struct q_pkt> evicted;
 
     if (p->getControlInfo())
         delete p->removeControlInfo();
 
-    if (PQ.len >= MAX_QUEUE_LENGTH)
+    qp.p = p;
+    qp.inTransit = false;
+    PQ.buffer.add(dest_addr.s_addr, qp, p->getByteLength(), evicted);
+
+    for (unsigned int i = 0; i < evicted.size(); i++)
     {
         dlog(LOG_DEBUG, 0, __FUNCTION__, "Max queue length reached,"
              " removing first packet");
-        if (!dlist_empty(&PQ.head))
-        {
-            qp = (struct q_pkt *)PQ.head.next;
-
-            dlist_del(PQ.head.next);
-            dgram =qp->p;
-            sendICMP(dgram);
-            //drop(dgram);
-            //icmpAccess.get()->sendErrorMessage(dgram, ICMP_DESTINATION_UNREACHABLE, ICMP_AODV_QUEUE_FULL);
-            free(qp);
-            PQ.len--;
-        }
-    }
-
-    qp = (struct q_pkt *) malloc(sizeof(struct q_pkt));
-
-    if (qp == NULL)
-    {
-        opp_error ("Dymo packet queue, Malloc failed!\n");
-        exit (-1);
+        sendICMP(evicted[i].p);
     }
-
-    qp->p = p;
-
-    qp->dest_addr = dest_addr;
-    qp->inTransit = false;
-
-    gettimeofday(&qp->q_time, NULL);
-    INIT_DLIST_ELEM(&qp->l);
-    dlist_add_tail(&qp->l, &PQ.head);
-    PQ.len++;
 }
 
 int NS_CLASS packet_queue_set_verdict(struct in_addr dest_addr, int verdict)
 {
     int count = 0;
     rtable_entry_t *rt;
-    dlist_head_t *pos, *tmp;
     struct in_addr gw_addr;
+    std::vector<struct q_pkt> pkts;
 
     double delay = 0;
 #define ARP_DELAY 0.005
@@ -159,76 +108,73 @@ int NS_CLASS packet_queue_set_verdict(struct in_addr dest_addr, int verdict)
     else
         rt = rtable_find(dest_addr);
 
-    dlist_for_each_safe(pos, tmp, &PQ.head)
+    // without a route the packets stay queued
+    if (verdict == PQ_SEND && !rt)
+        return PQ.buffer.contains(dest_addr.s_addr) ? -1 : 0;
+
+    count = PQ.buffer.take(dest_addr.s_addr, pkts);
+
+    for (unsigned int i = 0; i < pkts.size(); i++)
     {
-        struct q_pkt *qp = (struct q_pkt *)pos;
-        if (qp->dest_addr.s_addr == dest_addr.s_addr)
+        struct q_pkt *qp = &pkts[i];
+        switch (verdict)
         {
-            dlist_del(pos);
-            switch (verdict)
+        case PQ_ENC_SEND:
+            if (isInMacLayer())
             {
-            case PQ_ENC_SEND:
+                //drop(qp->p);
+                sendICMP(qp->p);
+            }
+            else if (dynamic_cast <IPDatagram *> (qp->p))
+            {
+                /* Apparently, the link layer implementation can't handle
+                    * a burst of packets. So to keep ARP happy, buffered
+                    * packets are sent with ARP_DELAY seconds between
+                    * sends. */
+                qp->p = pkt_encapsulate(dynamic_cast <IPDatagram *> (qp->p), *gateWayAddress);
+                // now Ip layer decremented again
+                // sendDelayed(qp->p, delay, "to_ip_from_network");
+                sendDelayed (qp->p,delay,"to_ip");
+                delay += ARP_DELAY;
+            }
+            else
+            {
+                //drop(qp->p);
+                sendICMP(qp->p);
+            }
+            break;
+        case PQ_SEND:
+            if (qp->inTransit)
+            {
+                // drop(qp->p);
+                sendICMP(qp->p);
+            }
+            else
+            {
+                /* Apparently, the link layer implementation can't handle
+                 * a burst of packets. So to keep ARP happy, buffered
+                 * packets are sent with ARP_DELAY seconds between
+                 * sends. */
+                // now Ip layer decremented again
                 if (isInMacLayer())
                 {
-                    //drop(qp->p);
-                    sendICMP(qp->p);
+                    Ieee802Ctrl *ctrl = new Ieee802Ctrl;
+                    Uint128 nextHop;
+                    int iface;
+                    double cost;
+                    getNextHop(dest_addr.s_addr,nextHop,iface,cost);
+                    ctrl->setDest(nextHop.getMACAddress());
+                    qp->p->setControlInfo(ctrl);
                 }
-                else if (dynamic_cast <IPDatagram *> (qp->p))
-                {
-                    /* Apparently, the link layer implementation can't handle
-                        * a burst of packets. So to keep ARP happy, buffered
-                        * packets are sent with ARP_DELAY seconds between
-                        * sends. */
-                    qp->p = pkt_encapsulate(dynamic_cast <IPDatagram *> (qp->p), *gateWayAddress);
-                    // now Ip layer decremented again
-                    // sendDelayed(qp->p, delay, "to_ip_from_network");
-                    sendDelayed (qp->p,delay,"to_ip");
-                    delay += ARP_DELAY;
-                }
-                else
-                {
-                    //drop(qp->p);
-                    sendICMP(qp->p);
-                }
-                break;
-            case PQ_SEND:
-                if (!rt)
-                    return -1;
-                if (qp->inTransit)
-                {
-                    // drop(qp->p);
-                    sendICMP(qp->p);
-                }
-                else
-                {
-                    /* Apparently, the link layer implementation can't handle
-                     * a burst of packets. So to keep ARP happy, buffered
-                     * packets are sent with ARP_DELAY seconds between
-                     * sends. */
-                    // now Ip layer decremented again
-                    if (isInMacLayer())
-                    {
-                        Ieee802Ctrl *ctrl = new Ieee802Ctrl;
-                        Uint128 nextHop;
-                        int iface;
-                        double cost;
-                        getNextHop(dest_addr.s_addr,nextHop,iface,cost);
-                        ctrl->setDest(nextHop.getMACAddress());
-                        qp->p->setControlInfo(ctrl);
-                    }
-                    sendDelayed(qp->p, delay, "to_ip");
-                    delay += ARP_DELAY;
-                }
-                break;
-            case PQ_DROP:
-                // drop(qp->p);
-                sendICMP(qp->p);
-                // icmpAccess.get()->sendErrorMessage(qp->p, ICMP_DESTINATION_UNREACHABLE, 0);
-                break;
+                sendDelayed(qp->p, delay, "to_ip");
+                delay += ARP_DELAY;
             }
-            free(qp);
-            count++;
-            PQ.len--;
+            break;
+        case PQ_DROP:
+            // drop(qp->p);
+            sendICMP(qp->p);
+            // icmpAccess.get()->sendErrorMessage(qp->p, ICMP_DESTINATION_UNREACHABLE, 0);
+            break;
         }
     }
     /* Update rt timeouts. must be in Dymo?*/
@@ -249,4 +195,3 @@ int NS_CLASS packet_queue_set_verdict(struct in_addr dest_addr, int verdict)
     */
     return count;
 }
-
@@ -24,12 +24,11 @@
 
 #ifndef NS_NO_GLOBALS
 
-#define MAX_QUEUE_LENGTH 512
 #define MAX_QUEUE_TIME 10000 /* Maximum time packets can be queued (ms) */
 #define GARBAGE_COLLECT_TIME 1000 /* Interval between running the
 * garbage collector (ms) */
 #include "dymoum/defs_dymo.h"
-#include "dymoum/dlist.h"
+#include "ManetPendingBuffer.h"
 
 /* Verdicts for queued packets: */
 enum
@@ -41,17 +40,13 @@ enum
 
 struct q_pkt
 {
-    dlist_head_t l;
-    struct in_addr  dest_addr;
-    struct timeval q_time;
     cPacket *p;
     bool inTransit;
 };
 
 struct packet_queue
 {
-    dlist_head_t head;
-    unsigned int len;
+    ManetPendingBuffer<struct q_pkt> buffer;
     struct timer garbage_collect_timer;
 };
 
@@ -1643,15 +1643,11 @@ bool DYMOUM::getNextHopGroup(const Uint128& dest,Uint128 &next,int &iface,Uint12
 
 cPacket * DYMOUM::get_packet_queue(struct in_addr dest_addr)
 {
-    dlist_head_t *pos;
-    dlist_for_each(pos, &PQ.head)
+    struct q_pkt *qp = PQ.buffer.front(dest_addr.s_addr);
+    if (qp)
     {
-        struct q_pkt *qp = (struct q_pkt *)pos;
-        if (qp->dest_addr.s_addr == dest_addr.s_addr)
-        {
-            qp->inTransit = true;
-            return qp->p;
-        }
+        qp->inTransit = true;
+        return qp->p;
     }
     return NULL;
 }
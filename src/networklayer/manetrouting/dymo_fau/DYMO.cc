@@ -572,7 +572,7 @@ void DYMO::handleLowerRERR(DYMO_RERR *my_rerr)
         if (IPAddress(unreachableNode.getAddress()).isMulticast()) continue;
 
         // check whether this invalidates entries in our routing table
-        std::vector<DYMO_RoutingEntry *> RouteVector = dymo_routingTable->getRoutingTable();
+        std::vector<DYMO_RoutingEntry *> RouteVector = dymo_routingTable->getRoutesVia(sourceAddr);
         for (unsigned int i = 0; i < RouteVector.size(); i++)
         {
             DYMO_RoutingEntry* entry = RouteVector[i];
@@ -594,11 +594,12 @@ void DYMO::handleLowerRERR(DYMO_RERR *my_rerr)
 
             // mark as broken and delete associated forwarding route
             entry->routeBroken = true;
-            dymo_routingTable->maintainAssociatedRoutingTable();
+            dymo_routingTable->maintainAssociatedRoutingEntryFor(entry);
 
             // start delete timer
             // TODO: not specified in draft, but seems to make sense
             entry->routeDelete.start(ROUTE_DELETE_TIMEOUT);
+            dymo_routingTable->updateTimeout(entry);
 
             // update unreachableNode.SeqNum
             // TODO: not specified in draft, but seems to make sense
@@ -678,40 +679,29 @@ void DYMO::handleSelfMsg(cMessage* apMsg)
             handleRREQTimeout(*outstandingRREQ);
         }
 
-        // Maybe it's a DYMO_RoutingEntry
-        for (int i = 0; i < dymo_routingTable->getNumRoutes(); i++)
+        // Maybe it's a DYMO_RoutingEntry (the routing table keeps them ordered by their next timeout)
+        DYMO_RoutingEntry *entry;
+        while ((entry = dymo_routingTable->getExpiredRoute()) != NULL)
         {
-            DYMO_RoutingEntry *entry = dymo_routingTable->getRoute(i);
-            if (entry->routeAgeMin.isExpired())
-            {
-                break;
-            }
+            // all expired timers of the entry are handled here, so none stays due
+            entry->routeAgeMin.isExpired();
             if (entry->routeAgeMax.isExpired())
             {
                 dymo_routingTable->deleteRoute(entry);
-                break; // if other timeouts also expired, they will have gotten their own DYMO_Timeout scheduled, so it's ok to stop here
-            }
-            if (entry->routeNew.isExpired())
-            {
-                if (!entry->routeUsed.isRunning())
-                {
-                    entry->routeDelete.start(ROUTE_DELETE_TIMEOUT);
-                }
-                break;
-            }
-            if (entry->routeUsed.isExpired())
-            {
-                if (!entry->routeNew.isRunning())
-                {
-                    entry->routeDelete.start(ROUTE_DELETE_TIMEOUT);
-                }
-                break;
+                continue;
             }
             if (entry->routeDelete.isExpired())
             {
                 dymo_routingTable->deleteRoute(entry);
-                break;
+                continue;
+            }
+            bool routeNewExpired = entry->routeNew.isExpired();
+            bool routeUsedExpired = entry->routeUsed.isExpired();
+            if ((routeNewExpired && !entry->routeUsed.isRunning()) || (routeUsedExpired && !entry->routeNew.isRunning()))
+            {
+                entry->routeDelete.start(ROUTE_DELETE_TIMEOUT);
             }
+            dymo_routingTable->updateTimeout(entry);
         }
 
     }
@@ -911,11 +901,11 @@ void DYMO::sendRERR(unsigned int targetAddr, unsigned int targetSeqNum)
         if (!brokenEntry->routeBroken) throw std::runtime_error("sendRERR called for targetAddr that has a perfectly fine routing table entry");
 
         // add route entries with same routeNextHopAddress as broken route
-        std::vector<DYMO_RoutingEntry *> RouteVector = dymo_routingTable->getRoutingTable();
+        std::vector<DYMO_RoutingEntry *> RouteVector = dymo_routingTable->getRoutesVia(brokenEntry->routeNextHopAddress);
         for (unsigned int i = 0; i < RouteVector.size(); i++)
         {
             DYMO_RoutingEntry* entry = RouteVector[i];
-            if ((entry->routeNextHopAddress != brokenEntry->routeNextHopAddress) || (entry->routeNextHopInterface != brokenEntry->routeNextHopInterface)) continue;
+            if (entry->routeNextHopInterface != brokenEntry->routeNextHopInterface) continue;
 
             ev << "Including in RERR route to " << entry->routeAddress << " via " << entry->routeNextHopAddress << endl;
 
@@ -967,7 +957,7 @@ void DYMO::updateRouteLifetimes(unsigned int targetAddr)
     entry->routeUsed.start(ROUTE_USED_TIMEOUT);
     entry->routeDelete.cancel();
 
-    dymo_routingTable->maintainAssociatedRoutingTable();
+    dymo_routingTable->updateTimeout(entry);
     ev << "lifetimes of route to destination node " << targetAddr << " are up to date "  << endl;
 
     checkAndSendQueuedPkts(entry->routeAddress.getInt(), entry->routePrefix, (entry->routeNextHopAddress).getInt());
@@ -1046,7 +1036,6 @@ void DYMO::handleRREQTimeout(DYMO_OutstandingRREQ& outstandingRREQ)
 
         std::list<IPDatagram*> datagrams;
         // drop packets bound for the expired RREQ's destination
-        dymo_routingTable->maintainAssociatedRoutingTable();
         queuedDataPackets->dropPacketsTo(outstandingRREQ.destAddr, 32, &datagrams);
         while (!datagrams.empty())
         {
@@ -1070,11 +1059,11 @@ bool DYMO::updateRoutesFromAddressBlock(const DYMO_AddressBlock& ab, bool isRREQ
     DYMO_RoutingEntry* entry = dymo_routingTable->getForAddress(IPAddress(ab.getAddress()));
     if (entry && !isRBlockBetter(entry, ab, isRREQ)) return false;
 
-    if (!entry)
+    bool isNewEntry = !entry;
+    if (isNewEntry)
     {
         ev << "adding routing entry for " << IPAddress(ab.getAddress()) << endl;
         entry = new DYMO_RoutingEntry(this);
-        dymo_routingTable->addRoute(entry);
     }
     else
     {
@@ -1094,7 +1083,12 @@ bool DYMO::updateRoutesFromAddressBlock(const DYMO_AddressBlock& ab, bool isRREQ
     entry->routeUsed.cancel();
     entry->routeDelete.cancel();
 
-    dymo_routingTable->maintainAssociatedRoutingTable();
+    if (isNewEntry)
+        dymo_routingTable->addRoute(entry);
+    else
+        dymo_routingTable->updateRoute(entry);
+    dymo_routingTable->updateTimeout(entry);
+    dymo_routingTable->maintainAssociatedRoutingEntryFor(entry);
 
     checkAndSendQueuedPkts(entry->routeAddress.getInt(), entry->routePrefix, nextHopAddress);
 
@@ -1144,7 +1138,6 @@ DYMO_RM* DYMO::updateRoutes(DYMO_RM * pkt)
 
 void DYMO::checkAndSendQueuedPkts(unsigned int destinationAddress, int prefix, unsigned int /*nextHopAddress*/)
 {
-    dymo_routingTable->maintainAssociatedRoutingTable();
     queuedDataPackets->dequeuePacketsTo(destinationAddress, prefix);
 
     // clean up outstandingRREQList: remove those with matching destAddr
@@ -1193,18 +1186,15 @@ void DYMO::packetFailed(IPDatagram *dgram)
     DYMO_RoutingEntry *entry = dymo_routingTable->getByAddress(dgram->getDestAddress());
     if (entry)
     {
-        IPAddress nextHop = entry->routeNextHopAddress;
-        for (int i = 0; i < dymo_routingTable->getNumRoutes(); i++)
+        std::vector<DYMO_RoutingEntry *> RouteVector = dymo_routingTable->getRoutesVia(entry->routeNextHopAddress);
+        for (unsigned int i = 0; i < RouteVector.size(); i++)
         {
-            DYMO_RoutingEntry *entry = dymo_routingTable->getRoute(i);
-            if (entry->routeNextHopAddress==nextHop)
-            {
-                entry->routeBroken = true;
-                //sendRERR(entry->routeAddress.getInt(),entry->routeSeqNum);
-            }
+            DYMO_RoutingEntry *entry = RouteVector[i];
+            entry->routeBroken = true;
+            dymo_routingTable->maintainAssociatedRoutingEntryFor(entry);
+            //sendRERR(entry->routeAddress.getInt(),entry->routeSeqNum);
         }
     }
-    dymo_routingTable->maintainAssociatedRoutingTable();
 }
 
 
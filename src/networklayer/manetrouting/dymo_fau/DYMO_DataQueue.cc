@@ -23,27 +23,28 @@
 #include "IPControlInfo.h"
 #include "IP.h"
 
-std::ostream& operator<<(std::ostream& os, const DYMO_QueuedData& o)
+// matches the destinations within destAddr/prefix
+struct DYMO_PrefixMatch
 {
-    os << "[ ";
-    os << "destAddr: " << o.destAddr;
-    os << " ]";
+    IPAddress destAddr;
+    int prefix;
+    DYMO_PrefixMatch(const IPAddress& destAddr, int prefix) : destAddr(destAddr), prefix(prefix) {}
+    bool operator()(const Uint128& dest) const {return dest.getIPAddress().prefixMatches(destAddr, prefix);}
+};
 
-    return os;
-}
-
-DYMO_DataQueue::DYMO_DataQueue(cSimpleModule *owner,int BUFFER_SIZE_PACKETS, int BUFFER_SIZE_BYTES) : dataQueueByteSize(0), BUFFER_SIZE_PACKETS(BUFFER_SIZE_PACKETS), BUFFER_SIZE_BYTES(BUFFER_SIZE_BYTES)
+DYMO_DataQueue::DYMO_DataQueue(cSimpleModule *owner,int BUFFER_SIZE_PACKETS, int BUFFER_SIZE_BYTES)
 {
     moduleOwner = owner;
+    dataQueue.setMaxPackets(BUFFER_SIZE_PACKETS);
+    dataQueue.setMaxBytes(BUFFER_SIZE_BYTES);
 }
 
 DYMO_DataQueue::~DYMO_DataQueue()
 {
-    while (!dataQueue.empty())
-    {
-        delete dataQueue.front().datagram;
-        dataQueue.pop_front();
-    }
+    std::vector<IPDatagram*> datagrams;
+    dataQueue.takeAll(datagrams);
+    for (unsigned int i = 0; i < datagrams.size(); i++)
+        delete datagrams[i];
 }
 
 const char* DYMO_DataQueue::getFullName() const
@@ -55,15 +56,14 @@ std::string DYMO_DataQueue::info() const
 {
     std::ostringstream ss;
 
-    int total = dataQueue.size();
+    int total = dataQueue.getNumPackets();
     ss << total << " queued datagrams: ";
 
+    std::vector<Uint128> dests;
+    dataQueue.getDestinations(dests);
     ss << "{" << std::endl;
-    for (std::list<DYMO_QueuedData>::const_iterator iter = dataQueue.begin(); iter != dataQueue.end(); iter++)
-    {
-        DYMO_QueuedData e = *iter;
-        ss << "  " << e << std::endl;
-    }
+    for (unsigned int i = 0; i < dests.size(); i++)
+        ss << "  [ destAddr: " << dests[i].getIPAddress() << " packets: " << dataQueue.getNumPacketsTo(dests[i]) << " ]" << std::endl;
     ss << "}";
 
     return ss.str();
@@ -80,51 +80,41 @@ void DYMO_DataQueue::queuePacket(const IPDatagram* datagram)
     IPAddress destAddr = datagram->getDestAddress();
 
     ev << "Queueing data packet to " << destAddr << endl;
-    dataQueue.push_back(DYMO_QueuedData(const_cast<IPDatagram *> (datagram), destAddr));
-    dataQueueByteSize += datagram->getByteLength();
 
     // if buffer is full, force dequeueing of old packets
-    while (((BUFFER_SIZE_PACKETS != -1) && ((int)dataQueue.size() > BUFFER_SIZE_PACKETS)) || ((BUFFER_SIZE_BYTES != -1) && (dataQueueByteSize > BUFFER_SIZE_BYTES)))
+    std::vector<IPDatagram*> evicted;
+    dataQueue.add(destAddr, const_cast<IPDatagram *> (datagram), datagram->getByteLength(), evicted);
+    for (unsigned int i = 0; i < evicted.size(); i++)
     {
-        DYMO_QueuedData qd = dataQueue.front();
-        dataQueue.pop_front();
-        dataQueueByteSize -= qd.datagram->getByteLength();
-        IPAddress destAddr = qd.destAddr;
-        delete qd.datagram;
-        ev << "Forced dropping of data packet to " << destAddr << endl;
+        ev << "Forced dropping of data packet to " << evicted[i]->getDestAddress() << endl;
+        delete evicted[i];
         //  ipLayer->reinjectDatagram(qd.datagram, IP::Hook::DROP);
     }
 }
 
 void DYMO_DataQueue::reinjectDatagramsTo(IPAddress destAddr, int prefix, Result verdict,std::list<IPDatagram*> *datagrams)
 {
-    bool tryAgain = true;
-    double delay = 0;
-    while (tryAgain)
+    std::vector<IPDatagram*> dequeued;
+    if (prefix == 32)
+    {
+        dataQueue.take(destAddr, dequeued);
+    }
+    else
+    {
+        // several destinations: keep the arrival order across them
+        dataQueue.takeIf(DYMO_PrefixMatch(destAddr, prefix), dequeued);
+    }
+
+    for (unsigned int i = 0; i < dequeued.size(); i++)
     {
-#define ARP_DELAY 0.001
-        tryAgain = false;
-        for (std::list<DYMO_QueuedData>::iterator iter = dataQueue.begin(); iter != dataQueue.end(); iter++)
-        {
-            DYMO_QueuedData qd = *iter;
-            if (qd.destAddr.prefixMatches(destAddr, prefix))
-            {
-                ev << "Dequeueing data packet to " << qd.destAddr << endl;
-                dataQueueByteSize -= qd.datagram->getByteLength();
-                dataQueue.erase(iter);
-                if (verdict==ACCEPT)
-                {
-                    moduleOwner->send(qd.datagram,"to_ip");
-                    delay += ARP_DELAY;
-                }
-                else if (verdict==DROP && datagrams != NULL)
-                    datagrams->push_back( qd.datagram );
-                else if (verdict==DROP)
-                    delete qd.datagram;
-                tryAgain = true;
-                break;
-            }
-        }
+        IPDatagram *datagram = dequeued[i];
+        ev << "Dequeueing data packet to " << datagram->getDestAddress() << endl;
+        if (verdict==ACCEPT)
+            moduleOwner->send(datagram,"to_ip");
+        else if (verdict==DROP && datagrams != NULL)
+            datagrams->push_back(datagram);
+        else if (verdict==DROP)
+            delete datagram;
     }
 }
 
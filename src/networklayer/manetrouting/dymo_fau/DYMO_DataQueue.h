@@ -32,23 +32,12 @@
 #include "RoutingTable.h"
 #include "RoutingTableAccess.h"
 #include "IP.h"
+#include "ManetPendingBuffer.h"
 
 class DYMO;
 enum Result {DROP, ACCEPT};
 
 
-class DYMO_QueuedData
-{
-  public:
-    DYMO_QueuedData(IPDatagram* dgram, IPAddress destAddr) : destAddr(destAddr) {datagram =dgram;}
-
-    IPDatagram* datagram;
-    IPAddress destAddr;
-
-  public:
-    friend std::ostream& operator<<(std::ostream& os, const DYMO_QueuedData& o);
-};
-
 /**
  * Stores datagrams awaiting route discovery
  */
@@ -74,11 +63,7 @@ class DYMO_DataQueue : public cObject
 
   protected:
     cSimpleModule *moduleOwner;
-    std::list<DYMO_QueuedData> dataQueue; /**< queued data packets */
-    long dataQueueByteSize; /**< total size of all messages currently in dataQueue */
-
-    int BUFFER_SIZE_PACKETS; /**< NED configuration parameter: maximum number of queued packets, -1 for no limit */
-    int BUFFER_SIZE_BYTES; /**< NED configuration parameter: maximum total size of queued packets, -1 for no limit */
+    ManetPendingBuffer<IPDatagram*> dataQueue; /**< queued data packets, by destination */
 
     void reinjectDatagramsTo(IPAddress destAddr, int prefix, Result verdict,std::list<IPDatagram*> *datagrams=NULL);
 
@@ -20,7 +20,7 @@
 #include "DYMO_RoutingEntry.h"
 #include "DYMO.h"
 
-DYMO_RoutingEntry::DYMO_RoutingEntry(DYMO* dymo) : routeAgeMin(dymo, "routeAgeMin"), routeAgeMax(dymo, "routeAgeMax"), routeNew(dymo, "routeNew"), routeUsed(dymo, "routeUsed"), routeDelete(dymo, "routeDelete"), routingEntry(0), dymo(dymo)
+DYMO_RoutingEntry::DYMO_RoutingEntry(DYMO* dymo) : routeAgeMin(NULL, "routeAgeMin"), routeAgeMax(NULL, "routeAgeMax"), routeNew(NULL, "routeNew"), routeUsed(NULL, "routeUsed"), routeDelete(NULL, "routeDelete"), routingEntry(0), dymo(dymo), tableIndex(-1), indexedPrefix(0), indexedTimeout(-1)
 {
 
 }
@@ -30,6 +30,18 @@ DYMO_RoutingEntry::~DYMO_RoutingEntry()
 
 }
 
+simtime_t DYMO_RoutingEntry::getNextTimeout() const
+{
+    const DYMO_Timer* timers[] = {&routeAgeMin, &routeAgeMax, &routeNew, &routeUsed, &routeDelete};
+    simtime_t next = -1;
+    for (unsigned int i = 0; i < sizeof(timers) / sizeof(timers[0]); i++)
+    {
+        simtime_t t = timers[i]->getExpiresAt();
+        if (t >= 0 && (next < 0 || t < next)) next = t;
+    }
+    return next;
+}
+
 std::ostream& operator<<(std::ostream& os, const DYMO_RoutingEntry& o)
 {
 
@@ -61,7 +61,8 @@ class DYMO_RoutingEntry
 
     /**
      * @name DYMO Timers
-     * Each set to the simulation time at which it is meant to be considered expired or -1 if it's not running
+     * Each set to the simulation time at which it is meant to be considered expired or -1 if it's not running.
+     * They schedule no messages of their own; DYMO_RoutingTable keeps one timeout for all entries.
      */
     /*@{*/
     DYMO_Timer routeAgeMin; /**< Minimum Delete Timeout. After updating a route table entry, it should be maintained for at least ROUTE_AGE_MIN */
@@ -73,9 +74,24 @@ class DYMO_RoutingEntry
 
     IPRoute* routingEntry; /**< Forwarding Route (entry in standard OMNeT++ routingTable) */
 
+    /** @returns the earliest expiry time of the running DYMO Timers, or -1 if none is running */
+    simtime_t getNextTimeout() const;
+
   protected:
     DYMO* dymo; /**< DYMO module */
 
+    /**
+     * @name Position of this entry in the indices of its DYMO_RoutingTable
+     */
+    /*@{*/
+    friend class DYMO_RoutingTable;
+    int tableIndex; /**< index in the table's route vector, -1 if not in a table */
+    IPAddress indexedAddress; /**< routeAddress the entry is filed under */
+    int indexedPrefix; /**< routePrefix the entry is filed under */
+    IPAddress indexedNextHop; /**< routeNextHopAddress the entry is filed under */
+    simtime_t indexedTimeout; /**< key in the table's timeout queue, -1 if not queued */
+    /*@}*/
+
   public:
     friend std::ostream& operator<<(std::ostream& os, const DYMO_RoutingEntry& e);
 };
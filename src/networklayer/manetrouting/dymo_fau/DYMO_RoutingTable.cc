@@ -29,7 +29,8 @@ DYMO_RoutingTable::DYMO_RoutingTable(cObject* host, const IPAddress& myAddr)
     // get our host module
     if (!host) throw std::runtime_error("No parent module found");
 
-    dymoProcess = host;
+    dymoProcess = check_and_cast<cSimpleModule*>(host);
+    timeoutMsg = new DYMO_Timeout("route timeout", 1 /* msg kind, to give the msg a green color */);
 
     // get our routing table
     // routingTable = IPAddressResolver().routingTableOf(host);
@@ -47,6 +48,7 @@ DYMO_RoutingTable::~DYMO_RoutingTable()
     	delete routeVector.back();
     	routeVector.pop_back();
     }
+    dymoProcess->cancelAndDelete(timeoutMsg);
 }
 
 const char* DYMO_RoutingTable::getFullName() const
@@ -114,7 +116,10 @@ DYMO_RoutingEntry* DYMO_RoutingTable::getRoute(int k)
 //=================================================================================================
 void DYMO_RoutingTable::addRoute(DYMO_RoutingEntry *entry)
 {
+    entry->tableIndex = routeVector.size();
     routeVector.push_back(entry);
+    indexRoute(entry);
+    updateTimeout(entry);
 }
 
 //=================================================================================================
@@ -131,22 +136,72 @@ void DYMO_RoutingTable::deleteRoute(DYMO_RoutingEntry *entry)
 //  }
 
     // update DYMO routingTable
-    std::vector<DYMO_RoutingEntry *>::iterator iter;
+    int k = entry->tableIndex;
+    if (k < 0 || k >= (int)routeVector.size() || routeVector[k] != entry)
+        throw std::runtime_error("unknown routing entry requested to be deleted");
+
+    // fill the gap with the last entry
+    routeVector[k] = routeVector.back();
+    routeVector[k]->tableIndex = k;
+    routeVector.pop_back();
+
+    unindexRoute(entry);
+    dequeueTimeout(entry);
+    scheduleTimeout();
+
     Uint128 nm = IPAddress::ALLONES_ADDRESS;
-    for (iter = routeVector.begin(); iter < routeVector.end(); iter++)
+    Uint128 dest (entry->routeAddress.getInt());
+    (dynamic_cast <DYMO*> (dymoProcess))->omnet_chg_rte (dest,dest,dest,nm,true);
+    //updateDisplayString();
+    delete entry;
+}
+
+//=================================================================================================
+/*
+ */
+//=================================================================================================
+void DYMO_RoutingTable::updateRoute(DYMO_RoutingEntry *entry)
+{
+    if (entry->routeAddress == entry->indexedAddress && entry->routePrefix == entry->indexedPrefix
+            && entry->routeNextHopAddress == entry->indexedNextHop)
+        return;
+    unindexRoute(entry);
+    indexRoute(entry);
+}
+
+//=================================================================================================
+/*
+ */
+//=================================================================================================
+void DYMO_RoutingTable::updateTimeout(DYMO_RoutingEntry *entry)
+{
+    simtime_t next = entry->getNextTimeout();
+    if (next == entry->indexedTimeout)
+        return;
+    dequeueTimeout(entry);
+    if (next >= 0)
     {
-        if (entry == *iter)
-        {
-            routeVector.erase(iter);
-            Uint128 dest (entry->routeAddress.getInt());
-            (dynamic_cast <DYMO*> (dymoProcess))->omnet_chg_rte (dest,dest,dest,nm,true);
-            //updateDisplayString();
-            delete entry;
-            return;
-        }
+        timeoutQueue.insert(std::make_pair(next, entry));
+        entry->indexedTimeout = next;
     }
+    scheduleTimeout();
+}
 
-    throw std::runtime_error("unknown routing entry requested to be deleted");
+//=================================================================================================
+/*
+ */
+//=================================================================================================
+DYMO_RoutingEntry* DYMO_RoutingTable::getExpiredRoute()
+{
+    if (timeoutQueue.empty() || timeoutQueue.begin()->first > simTime())
+    {
+        scheduleTimeout();
+        return 0;
+    }
+    DYMO_RoutingEntry* entry = timeoutQueue.begin()->second;
+    timeoutQueue.erase(timeoutQueue.begin());
+    entry->indexedTimeout = -1;
+    return entry;
 }
 
 //=================================================================================================
@@ -168,17 +223,16 @@ void DYMO_RoutingTable::maintainAssociatedRoutingTable()
 //=================================================================================================
 DYMO_RoutingEntry* DYMO_RoutingTable::getByAddress(IPAddress addr)
 {
+    RouteMap::iterator it = hostRoutes.find(addr);
+    if (it != hostRoutes.end())
+        return it->second;
 
-    std::vector<DYMO_RoutingEntry *>::iterator iter;
-
-    for (iter = routeVector.begin(); iter < routeVector.end(); iter++)
+    // network routes may be filed under an address with host bits set
+    for (PrefixRouteMap::iterator pit = networkRoutes.begin(); pit != networkRoutes.end(); ++pit)
     {
-        DYMO_RoutingEntry *entry = *iter;
-
-        if (entry->routeAddress == addr)
-        {
-            return entry;
-        }
+        it = pit->second.find(maskAddress(addr, pit->first));
+        if (it != pit->second.end() && it->second->routeAddress == addr)
+            return it->second;
     }
 
     return 0;
@@ -190,26 +244,21 @@ DYMO_RoutingEntry* DYMO_RoutingTable::getByAddress(IPAddress addr)
 //=================================================================================================
 DYMO_RoutingEntry* DYMO_RoutingTable::getForAddress(IPAddress addr)
 {
-    std::vector<DYMO_RoutingEntry *>::iterator iter;
+    RouteMap::iterator it = hostRoutes.find(addr);
+    if (it != hostRoutes.end())
+        return it->second;
 
-    int longestPrefix = 0;
-    DYMO_RoutingEntry* longestPrefixEntry = 0;
-    for (iter = routeVector.begin(); iter < routeVector.end(); iter++)
+    for (PrefixRouteMap::iterator pit = networkRoutes.begin(); pit != networkRoutes.end(); ++pit)
     {
-        DYMO_RoutingEntry *entry = *iter;
-
-        // skip if we already have a more specific match
-        if (!(entry->routePrefix > longestPrefix)) continue;
-
-        // skip if address is not in routeAddress/routePrefix block
-        if (!addr.prefixMatches(entry->routeAddress, entry->routePrefix)) continue;
+        // a zero-length prefix never matches
+        if (pit->first < 1) break;
 
-        // we have a match
-        longestPrefix = entry->routePrefix;
-        longestPrefixEntry = entry;
+        it = pit->second.find(maskAddress(addr, pit->first));
+        if (it != pit->second.end())
+            return it->second;
     }
 
-    return longestPrefixEntry;
+    return 0;
 }
 
 //=================================================================================================
@@ -221,6 +270,103 @@ DYMO_RoutingTable::RouteVector DYMO_RoutingTable::getRoutingTable()
     return routeVector;
 }
 
+//=================================================================================================
+/*
+ */
+//=================================================================================================
+DYMO_RoutingTable::RouteVector DYMO_RoutingTable::getRoutesVia(IPAddress nextHop)
+{
+    NextHopMap::iterator it = routesByNextHop.find(nextHop);
+    if (it == routesByNextHop.end())
+        return RouteVector();
+    return it->second;
+}
+
+IPAddress DYMO_RoutingTable::maskAddress(const IPAddress& addr, int prefix)
+{
+    if (prefix < 1) return IPAddress::UNSPECIFIED_ADDRESS;
+    if (prefix > 31) return addr;
+    return IPAddress(addr.getInt() & ~(0xFFFFFFFFu >> prefix));
+}
+
+void DYMO_RoutingTable::indexRoute(DYMO_RoutingEntry *entry)
+{
+    // should two entries share a key, lookups return the one filed first
+    if (entry->routePrefix > 31)
+        hostRoutes.insert(std::make_pair(entry->routeAddress, entry));
+    else
+        networkRoutes[entry->routePrefix].insert(std::make_pair(maskAddress(entry->routeAddress, entry->routePrefix), entry));
+    routesByNextHop[entry->routeNextHopAddress].push_back(entry);
+
+    entry->indexedAddress = entry->routeAddress;
+    entry->indexedPrefix = entry->routePrefix;
+    entry->indexedNextHop = entry->routeNextHopAddress;
+}
+
+void DYMO_RoutingTable::unindexRoute(DYMO_RoutingEntry *entry)
+{
+    if (entry->indexedPrefix > 31)
+    {
+        RouteMap::iterator it = hostRoutes.find(entry->indexedAddress);
+        if (it != hostRoutes.end() && it->second == entry)
+            hostRoutes.erase(it);
+    }
+    else
+    {
+        PrefixRouteMap::iterator pit = networkRoutes.find(entry->indexedPrefix);
+        if (pit != networkRoutes.end())
+        {
+            RouteMap::iterator it = pit->second.find(maskAddress(entry->indexedAddress, entry->indexedPrefix));
+            if (it != pit->second.end() && it->second == entry)
+                pit->second.erase(it);
+            if (pit->second.empty())
+                networkRoutes.erase(pit);
+        }
+    }
+
+    NextHopMap::iterator nit = routesByNextHop.find(entry->indexedNextHop);
+    if (nit != routesByNextHop.end())
+    {
+        RouteVector& routes = nit->second;
+        routes.erase(std::find(routes.begin(), routes.end(), entry));
+        if (routes.empty())
+            routesByNextHop.erase(nit);
+    }
+}
+
+void DYMO_RoutingTable::dequeueTimeout(DYMO_RoutingEntry *entry)
+{
+    if (entry->indexedTimeout < 0)
+        return;
+    std::pair<TimeoutQueue::iterator, TimeoutQueue::iterator> range = timeoutQueue.equal_range(entry->indexedTimeout);
+    for (TimeoutQueue::iterator it = range.first; it != range.second; ++it)
+    {
+        if (it->second == entry)
+        {
+            timeoutQueue.erase(it);
+            break;
+        }
+    }
+    entry->indexedTimeout = -1;
+}
+
+void DYMO_RoutingTable::scheduleTimeout()
+{
+    if (timeoutQueue.empty())
+    {
+        dymoProcess->cancelEvent(timeoutMsg);
+        return;
+    }
+    simtime_t next = timeoutQueue.begin()->first;
+    if (timeoutMsg->isScheduled())
+    {
+        if (timeoutMsg->getArrivalTime() == next)
+            return;
+        dymoProcess->cancelEvent(timeoutMsg);
+    }
+    dymoProcess->scheduleAt(next, timeoutMsg);
+}
+
 void DYMO_RoutingTable::maintainAssociatedRoutingEntryFor(DYMO_RoutingEntry* entry)
 {
     Uint128 dest (entry->routeAddress.getInt());
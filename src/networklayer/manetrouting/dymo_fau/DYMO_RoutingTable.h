@@ -22,7 +22,10 @@
 
 #include <omnetpp.h>
 #include <vector>
+#include <map>
+#include <functional>
 #include "INETDefs.h"
+#include "INETHashMap.h"
 
 #include "NotificationBoard.h"
 
@@ -32,6 +35,16 @@
 
 /**
   * class describes the functionality of the routing table
+  *
+  * Host routes are found with one hash lookup; network routes are kept in
+  * one hash table per prefix length in use, probed from the longest one.
+  * Routes are also indexed by next hop, for the link break and RERR
+  * handling. The DYMO Timers of all entries share one DYMO_Timeout message,
+  * scheduled for the entry that expires first.
+  *
+  * DYMO changes entries in place: after setting routeAddress, routePrefix or
+  * routeNextHopAddress of an entry it has to call updateRoute(), and after
+  * starting or cancelling one of its timers updateTimeout().
 **/
 class DYMO_RoutingTable : public cObject
 {
@@ -60,23 +73,47 @@ class DYMO_RoutingTable : public cObject
     void addRoute(DYMO_RoutingEntry *entry);
     /** @deletes an entry from the table **/
     void deleteRoute (DYMO_RoutingEntry *entry);
+    /** @files an entry anew after its address, prefix or next hop changed **/
+    void updateRoute(DYMO_RoutingEntry *entry);
+    /** @requeues an entry after one of its timers was started or cancelled **/
+    void updateTimeout(DYMO_RoutingEntry *entry);
+    /** @takes an entry with an expired timer off the timeout queue, or gives back 0 if there is none **/
+    DYMO_RoutingEntry* getExpiredRoute();
     /** @removes invalid routes from the network layer routing table **/
     void maintainAssociatedRoutingTable ();
+    /**
+     * add or delete network layer routing table entry for given DYMO routing table entry, based on whether it's valid
+     */
+    void maintainAssociatedRoutingEntryFor(DYMO_RoutingEntry* entry);
     /** @searchs an entry (exact match) and gives back a pointer to it, or 0 if none is found **/
     DYMO_RoutingEntry* getByAddress(IPAddress addr);
     /** @searchs an entry (longest-prefix match) and gives back a pointer to it, or 0 if none is found **/
     DYMO_RoutingEntry* getForAddress(IPAddress addr);
     /** @returns the routing table **/
     std::vector<DYMO_RoutingEntry *> getRoutingTable();
+    /** @returns the entries whose next hop is the given address **/
+    std::vector<DYMO_RoutingEntry *> getRoutesVia(IPAddress nextHop);
 
   private:
     typedef std::vector<DYMO_RoutingEntry *> RouteVector;
+    typedef std::tr1::unordered_map<IPAddress, DYMO_RoutingEntry *, IPAddressHash> RouteMap;
+    typedef std::map<int, RouteMap, std::greater<int> > PrefixRouteMap; // longest prefix first
+    typedef std::tr1::unordered_map<IPAddress, RouteVector, IPAddressHash> NextHopMap;
+    typedef std::multimap<simtime_t, DYMO_RoutingEntry *> TimeoutQueue;
+
     RouteVector routeVector;
-    cObject * dymoProcess;
-    /**
-     * add or delete network layer routing table entry for given DYMO routing table entry, based on whether it's valid
-     */
-    void maintainAssociatedRoutingEntryFor(DYMO_RoutingEntry* entry);
+    RouteMap hostRoutes; // prefix 32, keyed by address
+    PrefixRouteMap networkRoutes; // prefix length -> masked address -> entry
+    NextHopMap routesByNextHop;
+    TimeoutQueue timeoutQueue; // by DYMO_RoutingEntry::getNextTimeout()
+    cSimpleModule * dymoProcess;
+    cMessage * timeoutMsg;
+
+    static IPAddress maskAddress(const IPAddress& addr, int prefix);
+    void indexRoute(DYMO_RoutingEntry *entry);
+    void unindexRoute(DYMO_RoutingEntry *entry);
+    void dequeueTimeout(DYMO_RoutingEntry *entry);
+    void scheduleTimeout();
 
   public:
     friend std::ostream& operator<<(std::ostream& os, const DYMO_RoutingTable& o);
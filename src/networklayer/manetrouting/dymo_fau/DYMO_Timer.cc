@@ -23,14 +23,14 @@
 DYMO_Timer::DYMO_Timer(cSimpleModule* parent, std::string name, simtime_t interval) : parent(parent), interval(interval), active(false)
 {
     this->name = strdup(name.c_str());
-    message = new DYMO_Timeout(this->name, 1 /* msg kind, to give the msg a green color */);
+    message = parent ? new DYMO_Timeout(this->name, 1 /* msg kind, to give the msg a green color */) : NULL;
 }
 
 DYMO_Timer::~DYMO_Timer()
 {
     //cancel();
     //delete message;
-    parent->cancelAndDelete(message);
+    if (parent) parent->cancelAndDelete(message);
     free(this->name);
 }
 
@@ -68,7 +68,7 @@ bool DYMO_Timer::isExpired()
 {
     if (active && (expiresAt <= simTime()))
     {
-        parent->cancelEvent(message);
+        if (message) parent->cancelEvent(message);
         active = false;
         return true;
     }
@@ -79,15 +79,15 @@ void DYMO_Timer::start(simtime_t interval)
 {
     if (interval != 0) this->interval = interval;
     if (this->interval == 0) throw std::runtime_error("Tried starting DYMO_Timer without or with zero-length interval");
-    if (active) parent->cancelEvent(message);
+    if (active && message) parent->cancelEvent(message);
     expiresAt = simTime() + this->interval;
     active = true;
-    parent->scheduleAt(expiresAt, message);
+    if (message) parent->scheduleAt(expiresAt, message);
 }
 
 void DYMO_Timer::cancel()
 {
-    if (active) parent->cancelEvent(message);
+    if (active && message) parent->cancelEvent(message);
     active = false;
 }
 
@@ -101,6 +101,11 @@ simtime_t DYMO_Timer::getInterval() const
     return interval;
 }
 
+simtime_t DYMO_Timer::getExpiresAt() const
+{
+    return active ? expiresAt : -1;
+}
+
 std::ostream& operator<< (std::ostream& os, const DYMO_Timer& o)
 {
     os << o.info();
@@ -27,12 +27,13 @@
 // simple, OMNeT++-aware timer class.
 // Starting a DYMO_Timer will schedule a DYMO_Timeout cMessage to be sent to the parent when
 // the timer exires. Warning: This cMessage is recycled for every iteration - do not delete!
+// Timers without a parent schedule nothing; their owner polls them (see DYMO_RoutingTable).
 //===========================================================================================
 class DYMO_Timer : public cObject
 {
   public:
     /**
-     * @param parent specifies the cSimpleModule that will receive a DYMO_Timeout message when this timer expires
+     * @param parent specifies the cSimpleModule that will receive a DYMO_Timeout message when this timer expires, or NULL if none should be scheduled
      * @param name helps differentiate DYMO_Timer instances
      * @param interval sets the default interval after which to expire the DYMO_Timer
      */
@@ -67,11 +68,14 @@ class DYMO_Timer : public cObject
     /** @brief returns the last set interval of this timer */
     simtime_t getInterval() const;
 
+    /** @brief returns the point in simulation time at which this timer expires, or -1 if it is not active */
+    simtime_t getExpiresAt() const;
+
   protected:
     cSimpleModule* parent; /**< cSimpleModule that will receive cMessage instances that indicate timeouts */
     char* name; /**< descriptive name */
     simtime_t interval; /**< last set interval after which to expire this DYMO_Timer */
-    DYMO_Timeout* message; /**< cMessage to be scheduled to remind simulation core of timeout */
+    DYMO_Timeout* message; /**< cMessage to be scheduled to remind simulation core of timeout, NULL if there is no parent */
     simtime_t expiresAt; /**< point in simulation time from where on this DYMO_Timer will be considered expired */
     bool active; /**< false if this DYMO_Timer is not currently active */
 
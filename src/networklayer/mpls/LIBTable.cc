@@ -17,13 +17,17 @@
 #include "LIBTable.h"
 #include "XMLUtils.h"
 #include "RoutingTableAccess.h"
+#include "InterfaceTableAccess.h"
 
 Define_Module(LIBTable);
 
 void LIBTable::initialize(int stage)
 {
     if (stage==0)
+    {
         maxLabel = 0;
+        ift = NULL;
+    }
 
     // we have to wait until routerId gets assigned in stage 3
     if (stage==4)
@@ -48,23 +52,77 @@ void LIBTable::handleMessage(cMessage *)
 bool LIBTable::resolveLabel(std::string inInterface, int inLabel,
         LabelOpVector& outLabel, std::string& outInterface, int& color)
 {
-    bool any = (inInterface.length() == 0);
+    int inInterfaceId = -1;
+    if (inInterface.length() != 0)
+    {
+        if (!ift)
+            ift = InterfaceTableAccess().get();
+        InterfaceEntry *ie = ift->getInterfaceByName(inInterface.c_str());
+        if (!ie)
+            return false;
+        inInterfaceId = ie->getInterfaceId();
+    }
 
-    for (unsigned int i = 0; i < lib.size(); i++)
+    const LIBEntry *entry = lookupLabel(inInterfaceId, inLabel);
+    if (!entry)
+        return false;
+
+    outLabel = entry->outLabel;
+    outInterface = entry->outInterface;
+    color = entry->color;
+    return true;
+}
+
+const LIBTable::LIBEntry *LIBTable::lookupLabel(int inInterfaceId, int inLabel) const
+{
+    if (inLabel < 0 || inLabel >= (int)labelIndex.size())
+        return NULL;
+
+    int pos = labelIndex[inLabel];
+    if (pos >= 0)
     {
-        if (!any && lib[i].inInterface != inInterface)
-            continue;
+        const LIBEntry& entry = lib[pos];
+        return (inInterfaceId == -1 || entry.inInterfaceId == inInterfaceId) ? &entry : NULL;
+    }
+    if (pos == NO_ENTRY)
+        return NULL;
 
-        if (lib[i].inLabel != inLabel)
-            continue;
+    // label configured on several interfaces: first matching entry wins
+    for (unsigned int i = 0; i < lib.size(); i++)
+        if (lib[i].inLabel == inLabel && (inInterfaceId == -1 || lib[i].inInterfaceId == inInterfaceId))
+            return &lib[i];
+    return NULL;
+}
 
-        outLabel = lib[i].outLabel;
-        outInterface = lib[i].outInterface;
-        color = lib[i].color;
+void LIBTable::resolveInterfaceIds(LIBEntry& entry)
+{
+    if (!ift)
+        ift = InterfaceTableAccess().get();
+    InterfaceEntry *ie = entry.inInterface.empty() ? NULL : ift->getInterfaceByName(entry.inInterface.c_str());
+    entry.inInterfaceId = ie ? ie->getInterfaceId() : -1;
+    ie = entry.outInterface.empty() ? NULL : ift->getInterfaceByName(entry.outInterface.c_str());
+    entry.outInterfaceId = ie ? ie->getInterfaceId() : -1;
+}
 
-        return true;
+void LIBTable::addEntry(LIBEntry& entry)
+{
+    resolveInterfaceIds(entry);
+    lib.push_back(entry);
+
+    if (entry.inLabel >= (int)labelIndex.size())
+        labelIndex.resize(entry.inLabel + 1, NO_ENTRY);
+    int& pos = labelIndex[entry.inLabel];
+    pos = (pos == NO_ENTRY) ? (int)lib.size() - 1 : SEVERAL_ENTRIES;
+}
+
+void LIBTable::rebuildLabelIndex()
+{
+    labelIndex.assign(labelIndex.size(), NO_ENTRY);
+    for (unsigned int i = 0; i < lib.size(); i++)
+    {
+        int& pos = labelIndex[lib[i].inLabel];
+        pos = (pos == NO_ENTRY) ? (int)i : SEVERAL_ENTRIES;
     }
-    return false;
 }
 
 int LIBTable::installLibEntry(int inLabel, std::string inInterface, const LabelOpVector& outLabel,
@@ -78,7 +136,7 @@ int LIBTable::installLibEntry(int inLabel, std::string inInterface, const LabelO
         newItem.outLabel = outLabel;
         newItem.outInterface = outInterface;
         newItem.color = color;
-        lib.push_back(newItem);
+        addEntry(newItem);
         return newItem.inLabel;
     }
     else
@@ -92,6 +150,7 @@ int LIBTable::installLibEntry(int inLabel, std::string inInterface, const LabelO
             lib[i].outLabel = outLabel;
             lib[i].outInterface = outInterface;
             lib[i].color = color;
+            resolveInterfaceIds(lib[i]);
             return inLabel;
         }
         ASSERT(false);
@@ -107,6 +166,7 @@ void LIBTable::removeLibEntry(int inLabel)
             continue;
 
         lib.erase(lib.begin() + i);
+        rebuildLabelIndex();
         return;
     }
     ASSERT(false);
@@ -164,10 +224,10 @@ void LIBTable::readTableFromXML(const cXMLElement* libtable)
             newItem.outLabel.push_back(l);
         }
 
-        lib.push_back(newItem);
-
         ASSERT(newItem.inLabel > 0);
 
+        addEntry(newItem);
+
         if (newItem.inLabel > maxLabel)
             maxLabel = newItem.inLabel;
     }
@@ -23,6 +23,8 @@
 #include "IPAddress.h"
 #include "IPDatagram.h"
 
+class IInterfaceTable;
+
 // label operations
 #define PUSH_OPER              0
 #define SWAP_OPER              1
@@ -55,6 +57,10 @@ class INET_API LIBTable: public cSimpleModule
 
             // FIXME colors in nam, temporary solution
             int color;
+
+            // interface ids of inInterface/outInterface, -1 if empty or unknown
+            int inInterfaceId;
+            int outInterfaceId;
         };
 
     protected:
@@ -62,6 +68,15 @@ class INET_API LIBTable: public cSimpleModule
         int maxLabel;
         std::vector<LIBEntry> lib;
 
+        // labels are allocated from a single (per-platform) label space, so
+        // lib can be indexed by label: labelIndex[label] is the position of
+        // the entry in lib, NO_ENTRY, or SEVERAL_ENTRIES if the same label is
+        // configured on several incoming interfaces (then lib is searched)
+        enum {NO_ENTRY = -1, SEVERAL_ENTRIES = -2};
+        std::vector<int> labelIndex;
+
+        IInterfaceTable *ift;
+
     protected:
         virtual void initialize(int stage);
         virtual int numInitStages() const  {return 5;}
@@ -70,11 +85,24 @@ class INET_API LIBTable: public cSimpleModule
         // static configuration
         virtual void readTableFromXML(const cXMLElement* libtable);
 
+        // fills in the interface ids and adds the entry to lib and labelIndex
+        virtual void addEntry(LIBEntry& entry);
+        virtual void resolveInterfaceIds(LIBEntry& entry);
+        virtual void rebuildLabelIndex();
+
     public:
         // label management
         virtual bool resolveLabel(std::string inInterface, int inLabel,
                           LabelOpVector& outLabel, std::string& outInterface, int& color);
 
+        /**
+         * Returns the entry for the given incoming label and interface id
+         * (-1 means any interface), or NULL. Constant time; this is what
+         * MPLS uses per packet. The pointer is only valid until the table
+         * is next modified.
+         */
+        virtual const LIBEntry *lookupLabel(int inInterfaceId, int inLabel) const;
+
         virtual int installLibEntry(int inLabel, std::string inInterface, const LabelOpVector& outLabel,
                             std::string outInterface, int color);
 
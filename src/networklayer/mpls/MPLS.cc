@@ -92,11 +92,13 @@ void MPLS::processPacketFromL3(cMessage * msg)
     if (ipdatagram->getTransportProtocol() == IP_PROT_TCP)
     {
 #if OMNETPP_VERSION > 0x0400
-        TCPSegment *seg = check_and_cast<TCPSegment*>(ipdatagram->getEncapsulatedPacket());
+        cPacket *transportPacket = ipdatagram->getEncapsulatedPacket();
 #else
-        TCPSegment *seg = check_and_cast<TCPSegment*>(ipdatagram->getEncapsulatedMsg());
+        cPacket *transportPacket = ipdatagram->getEncapsulatedMsg();
 #endif
-        if (seg->getDestPort() == LDP_PORT || seg->getSrcPort() == LDP_PORT)
+        // non-first fragments carry no TCP header
+        TCPSegment *seg = transportPacket ? check_and_cast<TCPSegment*>(transportPacket) : NULL;
+        if (seg && (seg->getDestPort() == LDP_PORT || seg->getSrcPort() == LDP_PORT))
         {
             ASSERT(!ipdatagram->hasPar("color"));
             ipdatagram->addPar("color") = LDP_TRAFFIC;
@@ -227,11 +229,10 @@ void MPLS::processMPLSPacketFromL2(MPLSPacket *mplsPacket)
 {
     int gateIndex = mplsPacket->getArrivalGate()->getIndex();
     InterfaceEntry *ie = ift->getInterfaceByNetworkLayerGateIndex(gateIndex);
-    std::string senderInterface = ie->getName();
     ASSERT(mplsPacket->hasLabel());
     int oldLabel = mplsPacket->getTopLabel();
 
-    EV << "Received " << mplsPacket << " from L2, label=" << oldLabel << " inInterface=" << senderInterface << endl;
+    EV << "Received " << mplsPacket << " from L2, label=" << oldLabel << " inInterface=" << ie->getName() << endl;
 
     if (oldLabel==-1)
     {
@@ -245,12 +246,9 @@ void MPLS::processMPLSPacketFromL2(MPLSPacket *mplsPacket)
         return;
     }
 
-    LabelOpVector outLabel;
-    std::string outInterface;
-    int color;
-
-    bool found = lt->resolveLabel(senderInterface, oldLabel, outLabel, outInterface, color);
-    if (!found)
+    // O(1) lookup by incoming interface id and label; no copies
+    const LIBTable::LIBEntry *entry = lt->lookupLabel(ie->getInterfaceId(), oldLabel);
+    if (!entry)
     {
         EV << "discarding packet, incoming label not resolved" << endl;
 
@@ -258,23 +256,26 @@ void MPLS::processMPLSPacketFromL2(MPLSPacket *mplsPacket)
         return;
     }
 
-    int outgoingPort = ift->getInterfaceByName(outInterface.c_str())->getNetworkLayerGateIndex();
+    InterfaceEntry *outIe = ift->getInterfaceById(entry->outInterfaceId);
+    if (!outIe)
+        error("LIB entry for label %d: unknown outInterface '%s'", oldLabel, entry->outInterface.c_str());
+    int outgoingPort = outIe->getNetworkLayerGateIndex();
 
-    doStackOps(mplsPacket, outLabel);
+    doStackOps(mplsPacket, entry->outLabel);
 
     if (mplsPacket->hasLabel())
     {
         // forward labeled packet
 
-        EV << "forwarding packet to " << outInterface << endl;
+        EV << "forwarding packet to " << entry->outInterface << endl;
 
         if (mplsPacket->hasPar("color"))
         {
-            mplsPacket->par("color") = color;
+            mplsPacket->par("color") = entry->color;
         }
         else
         {
-            mplsPacket->addPar("color") = color;
+            mplsPacket->addPar("color") = entry->color;
         }
 
         //ASSERT(labelIf[outgoingPort]);
@@ -0,0 +1,114 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#include <omnetpp.h>
+#include "WF2QScheduler.h"
+
+
+WF2QScheduler::WF2QScheduler()
+{
+    totalWeight = 0;
+    virtualTime = 0;
+    busyPeriod = 0;
+    numBacklogged = 0;
+}
+
+void WF2QScheduler::setNumFlows(int n)
+{
+    ASSERT(numBacklogged==0);
+    flows.assign(n, FlowData());
+    totalWeight = n;
+}
+
+void WF2QScheduler::setWeight(int flow, double weight)
+{
+    if (weight<=0)
+        opp_error("WF2QScheduler: weight of flow %d must be positive", flow);
+    totalWeight += weight - flows[flow].weight;
+    flows[flow].weight = weight;
+}
+
+void WF2QScheduler::schedule(int flow, double headBits)
+{
+    FlowData& f = flows[flow];
+    f.headBits = headBits;
+    f.finishTag = f.startTag + headBits / f.weight;
+    if (f.startTag <= virtualTime)
+        eligible.push(TaggedFlow(f.finishTag, flow));
+    else
+        ineligible.push(TaggedFlow(f.startTag, flow));
+}
+
+void WF2QScheduler::flowBacklogged(int flow, double headBits)
+{
+    FlowData& f = flows[flow];
+    ASSERT(!f.backlogged);
+
+    // a new busy period restarts the virtual time; tags left over from
+    // the previous one are recognized by their busy period, so they need
+    // not be cleared one by one
+    if (numBacklogged==0)
+    {
+        busyPeriod++;
+        virtualTime = 0;
+    }
+    if (f.busyPeriod!=busyPeriod)
+    {
+        f.busyPeriod = busyPeriod;
+        f.finishTag = 0;
+    }
+
+    f.backlogged = true;
+    numBacklogged++;
+    f.startTag = f.finishTag > virtualTime ? f.finishTag : virtualTime;
+    schedule(flow, headBits);
+}
+
+int WF2QScheduler::selectFlow()
+{
+    if (numBacklogged==0)
+        return -1;
+
+    // V = max(V, min start tag): there is always an eligible flow
+    if (eligible.empty() && ineligible.top().first > virtualTime)
+        virtualTime = ineligible.top().first;
+    while (!ineligible.empty() && ineligible.top().first <= virtualTime)
+    {
+        int flow = ineligible.top().second;
+        ineligible.pop();
+        eligible.push(TaggedFlow(flows[flow].finishTag, flow));
+    }
+
+    int flow = eligible.top().second;
+    eligible.pop();
+
+    FlowData& f = flows[flow];
+    f.backlogged = false;
+    numBacklogged--;
+    virtualTime += f.headBits / totalWeight;
+    return flow;
+}
+
+void WF2QScheduler::flowContinued(int flow, double headBits)
+{
+    FlowData& f = flows[flow];
+    ASSERT(!f.backlogged);
+    f.backlogged = true;
+    numBacklogged++;
+    f.startTag = f.finishTag;
+    schedule(flow, headBits);
+}
+
@@ -0,0 +1,100 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+
+#ifndef __INET_WF2QSCHEDULER_H
+#define __INET_WF2QSCHEDULER_H
+
+#include <vector>
+#include <queue>
+#include <functional>
+#include "INETDefs.h"
+
+/**
+ * Worst-case fair weighted fair queueing (WF2Q+, Bennett and Zhang) over
+ * a fixed set of flows. The scheduler only keeps the virtual start and
+ * finish tags of the head-of-line packets; the packets themselves are
+ * stored by the user, who reports the length of each new head packet.
+ *
+ * The system virtual time advances with the work served, so no state
+ * has to be updated on packet arrivals or when time passes. Backlogged
+ * flows are kept in two heaps: the eligible ones (start tag not after
+ * the virtual time) ordered by finish tag, the others by start tag.
+ * Arrivals and departures are therefore O(log n) in the number of
+ * backlogged flows.
+ */
+class INET_API WF2QScheduler
+{
+  protected:
+    struct FlowData
+    {
+        double weight;
+        double startTag;
+        double finishTag;
+        double headBits;
+        unsigned long busyPeriod; // finishTag is stale unless it is the current one
+        bool backlogged;
+
+        FlowData() : weight(1), startTag(0), finishTag(0), headBits(0), busyPeriod(0), backlogged(false) {}
+    };
+
+    typedef std::pair<double,int> TaggedFlow;  // (tag, flow index)
+    typedef std::priority_queue<TaggedFlow, std::vector<TaggedFlow>, std::greater<TaggedFlow> > FlowHeap;
+
+    std::vector<FlowData> flows;
+    double totalWeight;
+    double virtualTime;
+    unsigned long busyPeriod;
+    int numBacklogged;
+    FlowHeap eligible;    // by finish tag
+    FlowHeap ineligible;  // by start tag
+
+    void schedule(int flow, double headBits);
+
+  public:
+    WF2QScheduler();
+
+    /** Sets the number of flows; all of them get weight 1 */
+    void setNumFlows(int n);
+    int getNumFlows() const {return flows.size();}
+
+    /**
+     * Sets the share of a flow; the link is shared in proportion to the
+     * weights of the backlogged flows. Affects the packets that become
+     * head-of-line afterwards.
+     */
+    void setWeight(int flow, double weight);
+    double getWeight(int flow) const {return flows[flow].weight;}
+
+    /** A packet of headBits bits arrived to the flow, which was empty before */
+    void flowBacklogged(int flow, double headBits);
+
+    /**
+     * Selects the flow whose head-of-line packet is to be sent next, and
+     * charges that packet to the virtual time. Returns -1 if no flow is
+     * backlogged. The flow has to be handed back with flowContinued() if
+     * it has more packets; otherwise it is considered empty.
+     */
+    int selectFlow();
+
+    /** After selectFlow(): the flow still has packets, the next one has headBits bits */
+    void flowContinued(int flow, double headBits);
+
+    int getNumBacklogged() const {return numBacklogged;}
+    double getVirtualTime() const {return virtualTime;}
+};
+
+#endif
+
@@ -31,12 +31,15 @@ void WeightedFairQueue::initialize()
 
     classifier = check_and_cast<IQoSClassifier*>(createOne(classifierClass));
 
+    outGate = gate("out");
+
     const char *vstr = par("queueWeight").stringValue();
     std::vector<double> queueWeight = cStringTokenizer(vstr).asDoubleVector();
     numQueues = classifier->getNumQueues();
     if (numQueues<(int)queueWeight.size())
         numQueues = queueWeight.size();
     useRed = par("UseRed");
+    scheduler.setNumFlows(numQueues);
     for (int i=0; i<numQueues; i++)
     {
         SubQueueData queueData;
@@ -45,7 +48,6 @@ void WeightedFairQueue::initialize()
         cQueue queue(buf);
         subqueueData.push_back(queueData);
         queueArray.push_back(queue);
-        subqueueData[i].queueWeight = 1;
         subqueueData[i].wq= par("wq");    // queue weight
         subqueueData[i].minth= par("minth"); // minimum threshold for avg queue length
         subqueueData[i].maxth= par("maxth"); // maximum threshold for avg queue length
@@ -55,7 +57,7 @@ void WeightedFairQueue::initialize()
 
     for (unsigned int i=0; i<queueWeight.size(); i++)
     {
-        subqueueData[i].queueWeight = queueWeight[i];
+        scheduler.setWeight(i, queueWeight[i]);
     }
 }
 
@@ -109,7 +111,7 @@ bool WeightedFairQueue::RedTest(cMessage *msg,int queueIndex)
         double pa = pb / (1-(*count)*pb);
         if (dblrand() < pa)
         {
-            EV << "Random early packet drop (avg queue len=" << avg << ", pa=" << pa << ")\n";
+            EV << "Random early packet drop (avg queue len=" << *avg << ", pa=" << pa << ")\n";
             mark = true;
             (*count) = 0;
             (*numEarlyDrops)++;
@@ -117,7 +119,7 @@ bool WeightedFairQueue::RedTest(cMessage *msg,int queueIndex)
     }
     else if (*maxth <= *avg)
     {
-        EV << "Avg queue len " << avg << " >= maxth, dropping packet.\n";
+        EV << "Avg queue len " << *avg << " >= maxth, dropping packet.\n";
         mark = true;
         (*count) = 0;
     }
@@ -157,64 +159,25 @@ bool WeightedFairQueue::enqueue(cMessage *msg)
     else
     {
         queueArray[queueIndex].insert(msg);
-        if (GPS_idle)
-        {
-            last_vt_update=SIMTIME_DBL(simTime());
-            virt_time=0;
-            GPS_idle=false;
-        }
-        else
-        {
-            virt_time=virt_time+(SIMTIME_DBL(simTime())-last_vt_update)/sum;
-            last_vt_update=SIMTIME_DBL(simTime());
-        }
-        double pkleng =(double)PK(msg)->getBitLength();
-        subqueueData[queueIndex].finish_t = (subqueueData[queueIndex].finish_t > virt_time ?
-                                             subqueueData[queueIndex].finish_t:virt_time)+
-                                            pkleng /(subqueueData[queueIndex].queueWeight*bandwidth);
-        subqueueData[queueIndex].time.push(subqueueData[queueIndex].finish_t);
-        if ((subqueueData[queueIndex].B++)==0)
-            sum=sum+(double)subqueueData[queueIndex].queueWeight;
-        if ( fabs(sum) < safe_limit )
-            sum=0;
+        if (queueArray[queueIndex].length()==1)
+            scheduler.flowBacklogged(queueIndex, PK(msg)->getBitLength());
         return false;
     }
 }
 
 cMessage *WeightedFairQueue::dequeue()
 {
-    int selectQueue=-1;
-    double endTime =1e20;
-    for (int i=0; i<numQueues; i++)
-    {
-        if (!queueArray[i].empty())
-        {
-            double time = subqueueData[i].time.front();
-            if (time<endTime)
-            {
-                selectQueue=i;
-                endTime=time;
-            }
-        }
-    }
-    if (selectQueue!=-1)
-    {
-        subqueueData[selectQueue].time.pop();
-        virt_time=virt_time+(SIMTIME_DBL(simTime())-last_vt_update)/sum;
-        last_vt_update=SIMTIME_DBL(simTime());
-        //update sum
-        if ((--subqueueData[selectQueue].B)==0)
-            sum=sum-(double)subqueueData[selectQueue].queueWeight;
-        if ( fabs(sum) < safe_limit )
-            sum=0;
-        if (sum==0)
-        {
-            GPS_idle=true;
-            for (int i=0; i <numQueues; i++) subqueueData[i].finish_t=0;
-        }
-        return (cMessage *)queueArray[selectQueue].pop();
-    }
-    return NULL;
+    int selectQueue = scheduler.selectFlow();
+    if (selectQueue==-1)
+        return NULL;
+
+    cQueue& queue = queueArray[selectQueue];
+    cMessage *msg = (cMessage *)queue.pop();
+    if (!queue.empty())
+        scheduler.flowContinued(selectQueue, PK(queue.front())->getBitLength());
+    else
+        subqueueData[selectQueue].q_time = simTime();  // RED: start of the idle time
+    return msg;
 }
 
 void WeightedFairQueue::sendOut(cMessage *msg)
@@ -25,25 +25,23 @@
 #define __INET_WEIGHTED_FAIR_QUEUE_H
 #include <omnetpp.h>
 #include <vector>
-#include <queue>
 #include "PassiveQueueBase.h"
 #include "IQoSClassifier.h"
+#include "WF2QScheduler.h"
 
 
+/**
+ * Weighted fair queueing over the classes of an IQoSClassifier, with
+ * optional RED on each class. Scheduling is done by WF2QScheduler, so
+ * the cost per packet is logarithmic in the number of backlogged classes.
+ * See NED for more info.
+ */
 class INET_API WeightedFairQueue : public PassiveQueueBase
 {
   protected:
     class SubQueueData
     {
       public:
-        double finish_t;// for WFQ
-        double queueMaxRate;
-        double queueWeight;
-        unsigned int B;            // set of active queues in the GPS reference system
-        // B[]!=0 queue is active, ==0 queue is inactive
-
-        std::queue <double> time;
-
         double wq;    // queue weight
         double minth; // minimum threshold for avg queue length
         double maxth; // maximum threshold for avg queue length
@@ -58,10 +56,6 @@ class INET_API WeightedFairQueue : public PassiveQueueBase
 
         SubQueueData()
         {
-            finish_t=0;
-            queueMaxRate=0;
-            queueWeight=0;
-            B=0;
             avg =0;
             q_time=0; // start of the queue idle time
             count=0;        // packets since last marked packet
@@ -78,12 +72,9 @@ class INET_API WeightedFairQueue : public PassiveQueueBase
     IQoSClassifier *classifier;
     cGate *outGate;
     bool useRed;
+    WF2QScheduler scheduler;
 
-//  cSubQueue *diffserv_queue;
     double bandwidth; // total link bandwidth
-    double  virt_time, last_vt_update, sum ;
-    bool GPS_idle;
-    double safe_limit;
 
     bool RedTest(cMessage *msg,int queueIndex);
 
@@ -91,10 +82,7 @@ class INET_API WeightedFairQueue : public PassiveQueueBase
     WeightedFairQueue ()
     {
         bandwidth=1e6;
-        virt_time = last_vt_update = sum = 0;
-        GPS_idle = true;
         numQueues=0;
-        safe_limit = 0.001;
     }
     // Omnet methods
     ~WeightedFairQueue()
@@ -112,6 +100,8 @@ class INET_API WeightedFairQueue : public PassiveQueueBase
         }
     }
 
+    // the link is shared in proportion to the weights, so the bandwidth
+    // is not needed for scheduling; it is kept for the users of the queue
     virtual void setBandwidth(double val)
     {
         bandwidth = val;
@@ -126,15 +116,13 @@ class INET_API WeightedFairQueue : public PassiveQueueBase
     {
         if (i>=numQueues)
             opp_error ("nun queue error");
-        subqueueData[i].queueWeight=val;
-
-
+        scheduler.setWeight(i, val);
     }
     virtual double getQueueWeight(int i)
     {
         if (i>=numQueues)
             opp_error ("nun queue error");
-        return subqueueData[i].queueWeight;
+        return scheduler.getWeight(i);
 
     }
   protected:
@@ -40,11 +40,15 @@ Define_Module(RSVP);
 
 RSVP::RSVP()
 {
+    psbRefreshTimer = NULL;
+    rsbRefreshTimer = NULL;
 }
 
 RSVP::~RSVP()
 {
     // TODO cancelAndDelete timers in all data structures
+    cancelAndDelete(psbRefreshTimer);
+    cancelAndDelete(rsbRefreshTimer);
 }
 
 void RSVP::initialize(int stage)
@@ -69,6 +73,17 @@ void RSVP::initialize(int stage)
 
         retryInterval = 1.0;
 
+        bundleRefreshes = par("bundleRefreshes").boolValue();
+        bundling = false;
+
+        psbRefreshTimer = new PsbTimerMsg("psb refresh");
+        rsbRefreshTimer = new RsbRefreshTimerMsg("rsb refresh");
+        nextPsbRefresh = nextRsbRefresh = 0;
+
+        numRefreshMsgs = numRefreshPackets = 0;
+        WATCH(numRefreshMsgs);
+        WATCH(numRefreshPackets);
+
         // setup hello
         setupHello();
 
@@ -77,6 +92,14 @@ void RSVP::initialize(int stage)
     }
 }
 
+void RSVP::finish()
+{
+    recordScalar("PSBs", PSBList.size());
+    recordScalar("RSBs", RSBList.size());
+    recordScalar("refresh messages", numRefreshMsgs);
+    recordScalar("refresh packets", numRefreshPackets);
+}
+
 int RSVP::getInLabel(const SessionObj_t& session, const SenderTemplateObj_t& sender)
 {
     unsigned int index;
@@ -119,7 +142,7 @@ void RSVP::createPath(const SessionObj_t& session, const SenderTemplateObj_t& se
     if (psb)
     {
         // PSB successfully created, send path message downstream
-        scheduleRefreshTimer(psb, 0.0);
+        triggerRefresh(psb);
     }
     else
     {
@@ -304,6 +327,7 @@ void RSVP::readTrafficSessionFromXML(const cXMLElement *session)
         EV << "adding new session into database" << endl;
 
         traffic.push_back(newSession);
+        sessionIndex[newSession.sobj] = traffic.size() - 1;
     }
 }
 
@@ -469,11 +493,37 @@ void RSVP::processHELLO_TIMER(HelloTimerMsg* msg)
 
 void RSVP::processPSB_TIMER(PsbTimerMsg *msg)
 {
-    PathStateBlock_t *psb = findPsbById(msg->getId());
-    ASSERT(psb);
+    ASSERT(msg == psbRefreshTimer);
+
+    std::set<int> triggered;
+    triggered.swap(triggeredPsbs);
 
-    refreshPath(psb);
-    scheduleRefreshTimer(psb, PSB_REFRESH_INTERVAL);
+    bundling = bundleRefreshes;
+
+    if (simTime() >= nextPsbRefresh)
+    {
+        // periodic round, covers the triggered PSBs too
+        EV << "refreshing all paths" << endl;
+
+        for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); it++)
+        {
+            if (it->OutInterface.isUnspecified() || !tedmod->isLocalAddress(it->OutInterface))
+                continue;
+
+            refreshPath(&(*it));
+        }
+        nextPsbRefresh = simTime() + PSB_REFRESH_INTERVAL;
+    }
+    else
+    {
+        for (std::set<int>::iterator it = triggered.begin(); it != triggered.end(); it++)
+            refreshPath(findPsbById(*it));
+    }
+
+    flushBundles();
+
+    if (!PSBList.empty())
+        scheduleAt(nextPsbRefresh, msg);
 }
 
 void RSVP::processPSB_TIMEOUT(PsbTimeoutMsg* msg)
@@ -495,18 +545,46 @@ void RSVP::processPSB_TIMEOUT(PsbTimeoutMsg* msg)
 
 void RSVP::processRSB_REFRESH_TIMER(RsbRefreshTimerMsg *msg)
 {
-    ResvStateBlock_t *rsb = findRsbById(msg->getId());
-    if (rsb->commitTimerMsg->isScheduled())
+    ASSERT(msg == rsbRefreshTimer);
+
+    std::set<int> triggered;
+    triggered.swap(triggeredRsbs);
+
+    bundling = bundleRefreshes;
+
+    if (simTime() >= nextRsbRefresh)
     {
-        // reschedule after commit
-        scheduleRefreshTimer(rsb, 0.0);
+        // periodic round, covers the triggered RSBs too
+        EV << "refreshing all reservations" << endl;
+
+        for (RSBVector::iterator it = RSBList.begin(); it != RSBList.end(); it++)
+            refreshResvOrDefer(&(*it));
+
+        nextRsbRefresh = simTime() + RSB_REFRESH_INTERVAL;
     }
     else
     {
-        refreshResv(rsb);
+        for (std::set<int>::iterator it = triggered.begin(); it != triggered.end(); it++)
+            refreshResvOrDefer(findRsbById(*it));
+    }
+
+    flushBundles();
 
-        scheduleRefreshTimer(rsb, RSB_REFRESH_INTERVAL);
+    if (!triggeredRsbs.empty())
+        scheduleAt(simTime(), msg);
+    else if (!RSBList.empty())
+        scheduleAt(nextRsbRefresh, msg);
+}
+
+void RSVP::refreshResvOrDefer(ResvStateBlock_t *rsbEle)
+{
+    if (rsbEle->commitTimerMsg->isScheduled())
+    {
+        // reschedule after commit
+        triggeredRsbs.insert(rsbEle->id);
     }
+    else
+        refreshResv(rsbEle);
 }
 
 void RSVP::processRSB_COMMIT_TIMER(RsbCommitTimerMsg *msg)
@@ -539,15 +617,13 @@ bool RSVP::doCACCheck(const SessionObj_t& session, const SenderTspecObj_t& tspec
 
     double sharedBW = 0.0;
 
-    for (RSBVector::iterator it = RSBList.begin(); it != RSBList.end(); it++)
+    std::pair<RsbIndex::iterator, RsbIndex::iterator> range = rsbBySession.equal_range(session);
+    for (RsbIndex::iterator it = range.first; it != range.second; it++)
     {
-        if (it->Session_Object != session)
+        if (it->second->Flowspec_Object.req_bandwidth <= sharedBW)
             continue;
 
-        if (it->Flowspec_Object.req_bandwidth <= sharedBW)
-            continue;
-
-        sharedBW = it->Flowspec_Object.req_bandwidth;
+        sharedBW = it->second->Flowspec_Object.req_bandwidth;
     }
 
     EV << "CACCheck: link=" << OI <<
@@ -591,7 +667,7 @@ void RSVP::refreshPath(PathStateBlock_t *psbEle)
 
     ASSERT(ERO.size() == 0 ||ERO[0].node.equals(nextHop) || ERO[0].L);
 
-    sendToIP(pm, nextHop);
+    sendRefreshToIP(pm, nextHop);
 }
 
 void RSVP::refreshResv(ResvStateBlock_t *rsbEle)
@@ -600,26 +676,21 @@ void RSVP::refreshResv(ResvStateBlock_t *rsbEle)
 
     IPAddressVector phops;
 
-    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); it++)
+    for (unsigned int i = 0; i < rsbEle->FlowDescriptor.size(); i++)
     {
-        if (it->OutInterface != rsbEle->OI)
+        PathStateBlock_t *psb = findPSB(rsbEle->Session_Object, rsbEle->FlowDescriptor[i].Filter_Spec_Object);
+        if (!psb || psb->OutInterface != rsbEle->OI)
             continue;
 
-        for (int i = 0; i < (int)rsbEle->FlowDescriptor.size(); i++)
-        {
-            if ((FilterSpecObj_t&)it->Sender_Template_Object != rsbEle->FlowDescriptor[i].Filter_Spec_Object)
-                continue;
-
-            if (tedmod->isLocalAddress(it->Previous_Hop_Address))
-                continue; // IR nothing to refresh
-
-            if (!find(phops, it->Previous_Hop_Address))
-                phops.push_back(it->Previous_Hop_Address);
-        }
+        if (tedmod->isLocalAddress(psb->Previous_Hop_Address))
+            continue; // IR nothing to refresh
 
-        for (IPAddressVector::iterator it = phops.begin(); it != phops.end(); it++)
-            refreshResv(rsbEle, *it);
+        if (!find(phops, psb->Previous_Hop_Address))
+            phops.push_back(psb->Previous_Hop_Address);
     }
+
+    for (IPAddressVector::iterator it = phops.begin(); it != phops.end(); it++)
+        refreshResv(rsbEle, *it);
 }
 
 void RSVP::refreshResv(ResvStateBlock_t *rsbEle, IPAddress PHOP)
@@ -637,34 +708,24 @@ void RSVP::refreshResv(ResvStateBlock_t *rsbEle, IPAddress PHOP)
     hop.Next_Hop_Address = PHOP;
     msg->setHop(hop);
 
-    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); it++)
+    ASSERT(rsbEle->inLabelVector.size() == rsbEle->FlowDescriptor.size());
+
+    for (unsigned int c = 0; c < rsbEle->FlowDescriptor.size(); c++)
     {
-        if (it->Previous_Hop_Address != PHOP)
+        PathStateBlock_t *psb = findPSB(rsbEle->Session_Object, rsbEle->FlowDescriptor[c].Filter_Spec_Object);
+        if (!psb || psb->Previous_Hop_Address != PHOP)
             continue;
 
-        //if (it->LIH != LIH)
+        //if (psb->LIH != LIH)
         //  continue;
 
-        if (it->Session_Object != rsbEle->Session_Object)
-            continue;
-
-        for (unsigned int c = 0; c < rsbEle->FlowDescriptor.size(); c++)
-        {
-            if ((FilterSpecObj_t&)it->Sender_Template_Object != rsbEle->FlowDescriptor[c].Filter_Spec_Object)
-                continue;
-
-            ASSERT(rsbEle->inLabelVector.size() == rsbEle->FlowDescriptor.size());
-
-            FlowDescriptor_t flow;
-            flow.Filter_Spec_Object = (FilterSpecObj_t&)it->Sender_Template_Object;
-            flow.Flowspec_Object = (FlowSpecObj_t&)it->Sender_Tspec_Object;
-            flow.RRO = rsbEle->FlowDescriptor[c].RRO;
-            flow.RRO.push_back(routerId);
-            flow.label = rsbEle->inLabelVector[c];
-            flows.push_back(flow);
-
-            break;
-        }
+        FlowDescriptor_t flow;
+        flow.Filter_Spec_Object = (FilterSpecObj_t&)psb->Sender_Template_Object;
+        flow.Flowspec_Object = (FlowSpecObj_t&)psb->Sender_Tspec_Object;
+        flow.RRO = rsbEle->FlowDescriptor[c].RRO;
+        flow.RRO.push_back(routerId);
+        flow.label = rsbEle->inLabelVector[c];
+        flows.push_back(flow);
     }
 
     msg->setFlowDescriptor(flows);
@@ -680,7 +741,7 @@ void RSVP::refreshResv(ResvStateBlock_t *rsbEle, IPAddress PHOP)
 
     msg->setByteLength(length);
 
-    sendToIP(msg, PHOP);
+    sendRefreshToIP(msg, PHOP);
 }
 
 void RSVP::preempt(IPAddress OI, int priority, double bandwidth)
@@ -928,12 +989,12 @@ void RSVP::commitResv(ResvStateBlock_t *rsb)
         }
 
         // schedule commit of merging backups too...
-        for (unsigned int j = 0; j < RSBList.size(); j++)
+        for (RSBVector::iterator it = RSBList.begin(); it != RSBList.end(); it++)
         {
-            if (RSBList[j].OI != lspid)
+            if (it->OI != lspid)
                 continue;
 
-            scheduleCommitTimer(&RSBList[j]);
+            scheduleCommitTimer(&(*it));
         }
     }
 }
@@ -947,9 +1008,6 @@ RSVP::ResvStateBlock_t* RSVP::createRSB(RSVPResvMsg *msg)
     rsbEle.timeoutMsg = new RsbTimeoutMsg("rsb timeout");
     rsbEle.timeoutMsg->setId(rsbEle.id);
 
-    rsbEle.refreshTimerMsg = new RsbRefreshTimerMsg("rsb timer");
-    rsbEle.refreshTimerMsg->setId(rsbEle.id);
-
     rsbEle.commitTimerMsg = new RsbCommitTimerMsg("rsb commit");
     rsbEle.commitTimerMsg->setId(rsbEle.id);
 
@@ -967,7 +1025,9 @@ RSVP::ResvStateBlock_t* RSVP::createRSB(RSVPResvMsg *msg)
     }
 
     RSBList.push_back(rsbEle);
-    ResvStateBlock_t *rsb = &(*(RSBList.end() - 1));
+    ResvStateBlock_t *rsb = &RSBList.back();
+    rsbById[rsb->id] = --RSBList.end();
+    rsbBySession.insert(std::make_pair(rsb->Session_Object, rsb));
 
     EV << "created new RSB " << rsb->id << endl;
 
@@ -1015,7 +1075,7 @@ void RSVP::updateRSB(ResvStateBlock_t* rsb, RSVPResvMsg *msg)
             // resv is new and must be forwarded
 
             scheduleCommitTimer(rsb);
-            scheduleRefreshTimer(rsb, 0.0);
+            triggerRefresh(rsb);
         }
     }
 }
@@ -1047,11 +1107,9 @@ void RSVP::removeRSB(ResvStateBlock_t *rsb)
 
     EV << "removing empty RSB " << rsb->id << endl;
 
-    cancelEvent(rsb->refreshTimerMsg);
     cancelEvent(rsb->commitTimerMsg);
     cancelEvent(rsb->timeoutMsg);
 
-    delete rsb->refreshTimerMsg;
     delete rsb->commitTimerMsg;
     delete rsb->timeoutMsg;
 
@@ -1061,15 +1119,22 @@ void RSVP::removeRSB(ResvStateBlock_t *rsb)
         allocateResource(rsb->OI, rsb->Session_Object, -rsb->Flowspec_Object.req_bandwidth);
     }
 
-    for (RSBVector::iterator it = RSBList.begin(); it != RSBList.end(); it++)
+    triggeredRsbs.erase(rsb->id);
+
+    std::pair<RsbIndex::iterator, RsbIndex::iterator> range = rsbBySession.equal_range(rsb->Session_Object);
+    for (RsbIndex::iterator it = range.first; it != range.second; it++)
     {
-        if (it->id != rsb->id)
+        if (it->second != rsb)
             continue;
 
-        RSBList.erase(it);
-        return;
+        rsbBySession.erase(it);
+        break;
     }
-    ASSERT(false);
+
+    RsbIdIndex::iterator it = rsbById.find(rsb->id);
+    ASSERT(it != rsbById.end());
+    RSBList.erase(it->second);
+    rsbById.erase(it);
 }
 
 void RSVP::removePSB(PathStateBlock_t *psb)
@@ -1093,21 +1158,17 @@ void RSVP::removePSB(PathStateBlock_t *psb)
 
     // proceed with actual removal *********************************************
 
-    cancelEvent(psb->timerMsg);
     cancelEvent(psb->timeoutMsg);
 
-    delete psb->timerMsg;
     delete psb->timeoutMsg;
 
-    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); it++)
-    {
-        if (it->id != psb->id)
-            continue;
+    triggeredPsbs.erase(psb->id);
+    psbByKey.erase(StateKey(psb->Session_Object, psb->Sender_Template_Object));
 
-        PSBList.erase(it);
-        return;
-    }
-    ASSERT(false);
+    PsbIdIndex::iterator it = psbById.find(psb->id);
+    ASSERT(it != psbById.end());
+    PSBList.erase(it->second);
+    psbById.erase(it);
 }
 
 bool RSVP::evalNextHopInterface(IPAddress destAddr, const EroVector& ERO, IPAddress& OI)
@@ -1208,9 +1269,6 @@ RSVP::PathStateBlock_t* RSVP::createPSB(RSVPPathMsg *msg)
     psbEle.timeoutMsg = new PsbTimeoutMsg("psb timeout");
     psbEle.timeoutMsg->setId(psbEle.id);
 
-    psbEle.timerMsg = new PsbTimerMsg("psb timer");
-    psbEle.timerMsg->setId(psbEle.id);
-
     psbEle.Session_Object = msg->getSession();
     psbEle.Sender_Template_Object = msg->getSenderTemplate();
     psbEle.Sender_Tspec_Object = msg->getSenderTspec();
@@ -1225,7 +1283,9 @@ RSVP::PathStateBlock_t* RSVP::createPSB(RSVPPathMsg *msg)
     psbEle.handler = -1;
 
     PSBList.push_back(psbEle);
-    PathStateBlock_t *cPSB = &(*(PSBList.end() - 1));
+    PathStateBlock_t *cPSB = &PSBList.back();
+    psbById[cPSB->id] = --PSBList.end();
+    psbByKey[StateKey(cPSB->Session_Object, cPSB->Sender_Template_Object)] = cPSB;
 
     EV << "created new PSB " << cPSB->id << endl;
 
@@ -1258,9 +1318,6 @@ RSVP::PathStateBlock_t* RSVP::createIngressPSB(const traffic_session_t& session,
     psbEle.timeoutMsg = new PsbTimeoutMsg("psb timeout");
     psbEle.timeoutMsg->setId(psbEle.id);
 
-    psbEle.timerMsg = new PsbTimerMsg("psb timer");
-    psbEle.timerMsg->setId(psbEle.id);
-
     psbEle.Session_Object = session.sobj;
     psbEle.Sender_Template_Object = path.sender;
     psbEle.Sender_Tspec_Object = path.tspec;
@@ -1274,7 +1331,9 @@ RSVP::PathStateBlock_t* RSVP::createIngressPSB(const traffic_session_t& session,
     psbEle.handler = path.owner;
 
     PSBList.push_back(psbEle);
-    PathStateBlock_t *cPSB = &(*(PSBList.end() - 1));
+    PathStateBlock_t *cPSB = &PSBList.back();
+    psbById[cPSB->id] = --PSBList.end();
+    psbByKey[StateKey(cPSB->Session_Object, cPSB->Sender_Template_Object)] = cPSB;
 
     return cPSB;
 }
@@ -1289,9 +1348,6 @@ RSVP::ResvStateBlock_t* RSVP::createEgressRSB(PathStateBlock_t *psb)
     rsbEle.timeoutMsg = new RsbTimeoutMsg("rsb timeout");
     rsbEle.timeoutMsg->setId(rsbEle.id);
 
-    rsbEle.refreshTimerMsg = new RsbRefreshTimerMsg("rsb timer");
-    rsbEle.refreshTimerMsg->setId(rsbEle.id);
-
     rsbEle.commitTimerMsg = new RsbCommitTimerMsg("rsb commit");
     rsbEle.commitTimerMsg->setId(rsbEle.id);
 
@@ -1309,7 +1365,9 @@ RSVP::ResvStateBlock_t* RSVP::createEgressRSB(PathStateBlock_t *psb)
     rsbEle.inLabelVector.push_back(-1);
 
     RSBList.push_back(rsbEle);
-    ResvStateBlock_t *rsb = &(*(RSBList.end() - 1));
+    ResvStateBlock_t *rsb = &RSBList.back();
+    rsbById[rsb->id] = --RSBList.end();
+    rsbBySession.insert(std::make_pair(rsb->Session_Object, rsb));
 
     EV << "created new (egress) RSB " << rsb->id << endl;
 
@@ -1360,11 +1418,26 @@ void RSVP::processRSVPMessage(RSVPMessage *msg)
             processPathErrMsg(check_and_cast<RSVPPathError*>(msg));
             break;
 
+        case BUNDLE_MESSAGE:
+            processBundleMsg(check_and_cast<RSVPBundleMsg*>(msg));
+            break;
+
         default:
             ASSERT(false);
     }
 }
 
+void RSVP::processBundleMsg(RSVPBundleMsg* msg)
+{
+    EV << "Received BUNDLE with " << msg->getNumMessages() << " messages" << endl;
+
+    std::vector<RSVPMessage*> msgs = msg->removeMessages();
+    delete msg;
+
+    for (unsigned int i = 0; i < msgs.size(); i++)
+        processRSVPMessage(msgs[i]);
+}
+
 void RSVP::processHelloMsg(RSVPHelloMsg* msg)
 {
     EV << "Received RSVP_HELLO" << endl;
@@ -1526,10 +1599,13 @@ void RSVP::processPathTearMsg(RSVPPathTear *msg)
 
     bool modified = false;
 
-    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); it++)
+    for (PSBVector::iterator it = PSBList.begin(); it != PSBList.end(); )
     {
         if (it->OutInterface.getInt() != lspid)
+        {
+            it++;
             continue;
+        }
 
         // merging backup exists
 
@@ -1542,8 +1618,7 @@ void RSVP::processPathTearMsg(RSVPPathTear *msg)
 
         EV << "merging backup must be removed too" << endl;
 
-        removePSB(&(*it));
-        --it;
+        removePSB(&(*it++));
 
         modified = true;
     }
@@ -1598,7 +1673,7 @@ void RSVP::processPathMsg(RSVPPathMsg *msg)
             delete msg;
             return;
         }
-        scheduleRefreshTimer(psb, 0.0);
+        triggerRefresh(psb);
 
         if (tedmod->isLocalAddress(psb->OutInterface))
         {
@@ -1628,7 +1703,7 @@ void RSVP::processPathMsg(RSVPPathMsg *msg)
     }
 
     if (rsb)
-        scheduleRefreshTimer(rsb, 0.0);
+        triggerRefresh(rsb);
 
     delete msg;
 }
@@ -1666,18 +1741,16 @@ void RSVP::processResvMsg(RSVPResvMsg *msg)
     // find matching RSB *******************************************************
 
     ResvStateBlock_t *rsb = NULL;
-    for (RSBVector::iterator it = RSBList.begin(); it != RSBList.end(); it++)
+    std::pair<RsbIndex::iterator, RsbIndex::iterator> range = rsbBySession.equal_range(msg->getSession());
+    for (RsbIndex::iterator it = range.first; it != range.second; it++)
     {
-        if (!(msg->isInSession(&it->Session_Object)))
-            continue;
-
-        if (it->Next_Hop_Address != msg->getNHOP())
+        if (it->second->Next_Hop_Address != msg->getNHOP())
             continue;
 
-        if (it->OI != msg->getLIH())
+        if (it->second->OI != msg->getLIH())
             continue;
 
-        rsb = &(*it);
+        rsb = it->second;
         break;
     }
 
@@ -1688,7 +1761,7 @@ void RSVP::processResvMsg(RSVPResvMsg *msg)
         scheduleCommitTimer(rsb);
 
         // reservation is new, propagate upstream immediately
-        scheduleRefreshTimer(rsb, 0.0);
+        triggerRefresh(rsb);
     }
     else
         updateRSB(rsb, msg);
@@ -1717,7 +1790,7 @@ void RSVP::recoveryEvent(IPAddress peer)
         if (it->OutInterface != tedmod->ted[index].local)
             continue;
 
-        scheduleRefreshTimer(&(*it), 0.0);
+        triggerRefresh(&(*it));
     }
 }
 
@@ -1839,16 +1912,18 @@ void RSVP::processPATH_NOTIFY(PathNotifyMsg* msg)
 
 std::vector<RSVP::traffic_session_t>::iterator RSVP::findSession(const SessionObj_t& session)
 {
-    std::vector<traffic_session_t>::iterator it;
-    for (it = traffic.begin(); it != traffic.end(); it++)
-    {
-        if (it->sobj != session)
-            continue;
+    SessionIndex::iterator it = sessionIndex.find(session);
+    if (it == sessionIndex.end())
+        return traffic.end();
 
-        break;
-    }
+    return traffic.begin() + it->second;
+}
 
-    return it;
+void RSVP::rebuildSessionIndex()
+{
+    sessionIndex.clear();
+    for (unsigned int i = 0; i < traffic.size(); i++)
+        sessionIndex[traffic[i].sobj] = i;
 }
 
 void RSVP::addSession(const cXMLElement& node)
@@ -1931,6 +2006,7 @@ void RSVP::delSession(const cXMLElement& node)
     if (!paths)
     {
         traffic.erase(sit);
+        rebuildSessionIndex();
     }
 }
 
@@ -2003,6 +2079,47 @@ void RSVP::sendToIP(cMessage *msg, IPAddress destAddr)
     send(msg, "ipOut");
 }
 
+void RSVP::sendRefreshToIP(RSVPMessage *msg, IPAddress destAddr)
+{
+    numRefreshMsgs++;
+
+    if (!bundling)
+    {
+        numRefreshPackets++;
+        sendToIP(msg, destAddr);
+        return;
+    }
+
+    RSVPBundleMsg *&bundle = pendingBundles[destAddr];
+    if (!bundle)
+        bundle = new RSVPBundleMsg("    Bundle");
+
+    bundle->addMessage(msg);
+}
+
+void RSVP::flushBundles()
+{
+    for (BundleMap::iterator it = pendingBundles.begin(); it != pendingBundles.end(); it++)
+    {
+        RSVPBundleMsg *bundle = it->second;
+
+        numRefreshPackets++;
+
+        if (bundle->getNumMessages() == 1)
+        {
+            // nothing to share the packet with, send the message alone
+            RSVPMessage *msg = bundle->removeMessages().front();
+            delete bundle;
+            sendToIP(msg, it->first);
+        }
+        else
+            sendToIP(bundle, it->first);
+    }
+    pendingBundles.clear();
+
+    bundling = false;
+}
+
 void RSVP::scheduleTimeout(PathStateBlock_t *psbEle)
 {
     ASSERT(psbEle);
@@ -2013,7 +2130,7 @@ void RSVP::scheduleTimeout(PathStateBlock_t *psbEle)
     scheduleAt(simTime() + PSB_TIMEOUT_INTERVAL, psbEle->timeoutMsg);
 }
 
-void RSVP::scheduleRefreshTimer(PathStateBlock_t *psbEle, simtime_t delay)
+void RSVP::triggerRefresh(PathStateBlock_t *psbEle)
 {
     ASSERT(psbEle);
 
@@ -2023,12 +2140,10 @@ void RSVP::scheduleRefreshTimer(PathStateBlock_t *psbEle, simtime_t delay)
     if (!tedmod->isLocalAddress(psbEle->OutInterface))
         return;
 
-    if (psbEle->timerMsg->isScheduled())
-        cancelEvent(psbEle->timerMsg);
+    EV << "scheduling PSB " << psbEle->id << " refresh " << simTime() << endl;
 
-    EV << "scheduling PSB " << psbEle->id << " refresh " << (simTime() + delay) << endl;
-
-    scheduleAt(simTime() + delay, psbEle->timerMsg);
+    triggeredPsbs.insert(psbEle->id);
+    scheduleRefreshTimer(psbRefreshTimer, simTime());
 }
 
 void RSVP::scheduleTimeout(ResvStateBlock_t *rsbEle)
@@ -2041,14 +2156,25 @@ void RSVP::scheduleTimeout(ResvStateBlock_t *rsbEle)
     scheduleAt(simTime() + RSB_TIMEOUT_INTERVAL, rsbEle->timeoutMsg);
 }
 
-void RSVP::scheduleRefreshTimer(ResvStateBlock_t *rsbEle, simtime_t delay)
+void RSVP::triggerRefresh(ResvStateBlock_t *rsbEle)
 {
     ASSERT(rsbEle);
 
-    if (rsbEle->refreshTimerMsg->isScheduled())
-        cancelEvent(rsbEle->refreshTimerMsg);
+    triggeredRsbs.insert(rsbEle->id);
+    scheduleRefreshTimer(rsbRefreshTimer, simTime());
+}
 
-    scheduleAt(simTime() + delay, rsbEle->refreshTimerMsg);
+void RSVP::scheduleRefreshTimer(cMessage *timer, simtime_t t)
+{
+    if (timer->isScheduled())
+    {
+        if (timer->getArrivalTime() <= t)
+            return;
+
+        cancelEvent(timer);
+    }
+
+    scheduleAt(t, timer);
 }
 
 void RSVP::scheduleCommitTimer(ResvStateBlock_t *rsbEle)
@@ -2063,16 +2189,15 @@ void RSVP::scheduleCommitTimer(ResvStateBlock_t *rsbEle)
 
 RSVP::ResvStateBlock_t* RSVP::findRSB(const SessionObj_t& session, const SenderTemplateObj_t& sender, unsigned int& index)
 {
-    RSBVector::iterator it;
+    std::pair<RsbIndex::iterator, RsbIndex::iterator> range = rsbBySession.equal_range(session);
 
-    for (it = RSBList.begin(); it != RSBList.end(); it++)
+    for (RsbIndex::iterator it = range.first; it != range.second; it++)
     {
-        if (it->Session_Object != session)
-            continue;
+        ResvStateBlock_t *rsb = it->second;
 
         FlowDescriptorVector::iterator fit;
         index = 0;
-        for (fit = it->FlowDescriptor.begin(); fit != it->FlowDescriptor.end(); fit++)
+        for (fit = rsb->FlowDescriptor.begin(); fit != rsb->FlowDescriptor.end(); fit++)
         {
             if ((SenderTemplateObj_t&)fit->Filter_Spec_Object != sender)
             {
@@ -2080,7 +2205,7 @@ RSVP::ResvStateBlock_t* RSVP::findRSB(const SessionObj_t& session, const SenderT
                 continue;
             }
 
-            return &(*it);
+            return rsb;
         }
 
         // don't break here, may be in different (if outInterface is different)
@@ -2090,46 +2215,36 @@ RSVP::ResvStateBlock_t* RSVP::findRSB(const SessionObj_t& session, const SenderT
 
 RSVP::PathStateBlock_t* RSVP::findPSB(const SessionObj_t& session, const SenderTemplateObj_t& sender)
 {
-    PSBVector::iterator it;
-    for (it = PSBList.begin(); it != PSBList.end(); it++)
-    {
-        if (it->Session_Object != session)
-            continue;
-
-        if (it->Sender_Template_Object != sender)
-            continue;
-
-        return &(*it);
-    }
+    PsbIndex::iterator it = psbByKey.find(StateKey(session, sender));
+    if (it == psbByKey.end())
+        return NULL;
 
-    return NULL;
+    return it->second;
 }
 
 RSVP::PathStateBlock_t* RSVP::findPsbById(int id)
 {
-    for (unsigned int i = 0; i < PSBList.size(); i++)
+    PsbIdIndex::iterator it = psbById.find(id);
+    if (it == psbById.end())
     {
-        if (PSBList[i].id != id)
-            continue;
-
-        return &PSBList[i];
+        ASSERT(false);
+        return NULL; // prevent warning
     }
-    ASSERT(false);
-    return NULL; // prevent warning
+
+    return &(*it->second);
 }
 
 
 RSVP::ResvStateBlock_t* RSVP::findRsbById(int id)
 {
-    for (unsigned int i = 0; i < RSBList.size(); i++)
+    RsbIdIndex::iterator it = rsbById.find(id);
+    if (it == rsbById.end())
     {
-        if (RSBList[i].id != id)
-            continue;
-
-        return &RSBList[i];
+        ASSERT(false);
+        return NULL; // prevent warning
     }
-    ASSERT(false);
-    return NULL; // prevent warning
+
+    return &(*it->second);
 }
 
 RSVP::HelloState_t* RSVP::findHello(IPAddress peer)
@@ -16,13 +16,18 @@
 #define __INET_RSVP_H
 
 #include <vector>
+#include <list>
+#include <map>
+#include <set>
 #include <omnetpp.h>
 
+#include "INETHashMap.h"
 #include "IScriptable.h"
 #include "IntServ.h"
 #include "RSVPPathMsg.h"
 #include "RSVPResvMsg.h"
 #include "RSVPHelloMsg.h"
+#include "RSVPBundleMsg.h"
 #include "SignallingMsg_m.h"
 #include "IRSVPClassifier.h"
 #include "NotificationBoard.h"
@@ -63,6 +68,30 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
 
     std::vector<traffic_session_t> traffic;
 
+    /**
+     * Hash functions for the objects that identify RSVP state; they only
+     * cover the fields the operator==s below compare.
+     */
+    struct SessionHash
+    {
+        size_t operator()(const SessionObj_t& s) const {
+            return inet_hashmix(s.DestAddress.getInt() ^ inet_hashmix(s.Extended_Tunnel_Id) ^ (uint32)s.Tunnel_Id);
+        }
+    };
+
+    typedef std::pair<SessionObj_t, SenderTemplateObj_t> StateKey;
+
+    struct StateKeyHash
+    {
+        size_t operator()(const StateKey& k) const {
+            return SessionHash()(k.first) ^ inet_hashmix(k.second.SrcAddress.getInt() + (uint32)k.second.Lsp_Id);
+        }
+    };
+
+    // traffic session -> index into traffic
+    typedef std::tr1::unordered_map<SessionObj_t, int, SessionHash> SessionIndex;
+    SessionIndex sessionIndex;
+
     /**
      * Path State Block (PSB) structure
      */
@@ -95,15 +124,15 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
         // XXX nam colors
         int color;
 
-        // timer/timeout routines
-        PsbTimerMsg *timerMsg;
+        // timeout routine; refreshes are driven by psbRefreshTimer
         PsbTimeoutMsg *timeoutMsg;
 
         // handler module
         int handler;
     };
 
-    typedef std::vector<PathStateBlock_t> PSBVector;
+    // a list so that the indices below may keep pointers into it
+    typedef std::list<PathStateBlock_t> PSBVector;
 
     /**
      * Reservation State Block (RSB) structure
@@ -134,13 +163,12 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
         // RSB unique identifier
         int id;
 
-        // timer/timeout routines
-        RsbRefreshTimerMsg *refreshTimerMsg;
+        // timer/timeout routines; refreshes are driven by rsbRefreshTimer
         RsbCommitTimerMsg *commitTimerMsg;
         RsbTimeoutMsg *timeoutMsg;
     };
 
-    typedef std::vector<ResvStateBlock_t> RSBVector;
+    typedef std::list<ResvStateBlock_t> RSBVector;
 
     /**
      * RSVP Hello State structure
@@ -189,6 +217,36 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
     RSBVector RSBList;
     HelloVector HelloList;
 
+    typedef std::tr1::unordered_map<int, PSBVector::iterator> PsbIdIndex;
+    typedef std::tr1::unordered_map<int, RSBVector::iterator> RsbIdIndex;
+    typedef std::tr1::unordered_map<StateKey, PathStateBlock_t*, StateKeyHash> PsbIndex;
+    typedef std::tr1::unordered_multimap<SessionObj_t, ResvStateBlock_t*, SessionHash> RsbIndex;
+
+    PsbIdIndex psbById;
+    RsbIdIndex rsbById;
+    PsbIndex psbByKey;      // (session, sender) -> PSB
+    RsbIndex rsbBySession;  // session -> RSBs, one per outgoing interface
+
+    // Refresh reduction (RFC 2961): a single timer per state kind sends
+    // both the triggered refreshes and the periodic ones, which are done
+    // for all state blocks in one round. Refreshes sent in the same event
+    // to the same neighbour are packed into one Bundle message.
+    bool bundleRefreshes;
+    PsbTimerMsg *psbRefreshTimer;
+    RsbRefreshTimerMsg *rsbRefreshTimer;
+    simtime_t nextPsbRefresh;
+    simtime_t nextRsbRefresh;
+    std::set<int> triggeredPsbs;
+    std::set<int> triggeredRsbs;
+
+    bool bundling;
+    typedef std::map<IPAddress, RSVPBundleMsg*> BundleMap;
+    BundleMap pendingBundles;
+
+    // statistics
+    long numRefreshMsgs;    // Path and Resv refreshes sent
+    long numRefreshPackets; // packets they were sent in
+
   protected:
     virtual void processSignallingMessage(SignallingMsg *msg);
     virtual void processPSB_TIMER(PsbTimerMsg *msg);
@@ -205,6 +263,7 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
     virtual void processResvMsg(RSVPResvMsg* msg);
     virtual void processPathTearMsg(RSVPPathTear* msg);
     virtual void processPathErrMsg(RSVPPathError* msg);
+    virtual void processBundleMsg(RSVPBundleMsg* msg);
 
     virtual PathStateBlock_t* createPSB(RSVPPathMsg *msg);
     virtual PathStateBlock_t* createIngressPSB(const traffic_session_t& session, const traffic_path_t& path);
@@ -218,11 +277,13 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
     virtual void refreshPath(PathStateBlock_t *psbEle);
     virtual void refreshResv(ResvStateBlock_t *rsbEle);
     virtual void refreshResv(ResvStateBlock_t *rsbEle, IPAddress PHOP);
+    virtual void refreshResvOrDefer(ResvStateBlock_t *rsbEle);
     virtual void commitResv(ResvStateBlock_t *rsb);
 
-    virtual void scheduleRefreshTimer(PathStateBlock_t *psbEle, simtime_t delay);
+    virtual void triggerRefresh(PathStateBlock_t *psbEle);
     virtual void scheduleTimeout(PathStateBlock_t *psbEle);
-    virtual void scheduleRefreshTimer(ResvStateBlock_t *rsbEle, simtime_t delay);
+    virtual void triggerRefresh(ResvStateBlock_t *rsbEle);
+    virtual void scheduleRefreshTimer(cMessage *timer, simtime_t t);
     virtual void scheduleCommitTimer(ResvStateBlock_t *rsbEle);
     virtual void scheduleTimeout(ResvStateBlock_t *rsbEle);
 
@@ -242,6 +303,8 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
     virtual void announceLinkChange(int tedlinkindex);
 
     virtual void sendToIP(cMessage *msg, IPAddress destAddr);
+    virtual void sendRefreshToIP(RSVPMessage *msg, IPAddress destAddr);
+    virtual void flushBundles();
 
     virtual bool evalNextHopInterface(IPAddress destAddr, const EroVector& ERO, IPAddress& OI);
 
@@ -252,6 +315,7 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
     virtual ResvStateBlock_t* findRsbById(int id);
 
     std::vector<traffic_session_t>::iterator findSession(const SessionObj_t& session);
+    void rebuildSessionIndex();
     std::vector<traffic_path_t>::iterator findPath(traffic_session_t *session, const SenderTemplateObj_t &sender);
 
     virtual HelloState_t* findHello(IPAddress peer);
@@ -284,6 +348,7 @@ class INET_API RSVP : public cSimpleModule, public IScriptable
     virtual int numInitStages() const  {return 5;}
     virtual void initialize(int stage);
     virtual void handleMessage(cMessage *msg);
+    virtual void finish();
 
     // IScriptable implementation
     virtual void processCommand(const cXMLElement& node);
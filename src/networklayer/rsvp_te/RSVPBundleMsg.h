@@ -0,0 +1,90 @@
+//
+// This library is free software, you can redistribute it
+// and/or modify
+// it under  the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation;
+// either version 2 of the License, or any later version.
+// The library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+// See the GNU Lesser General Public License for more details.
+//
+
+#ifndef __INET_RSVPBUNDLEMSG_H
+#define __INET_RSVPBUNDLEMSG_H
+
+#include <vector>
+
+#include "RSVPBundle_m.h"
+
+
+/**
+ * RSVP BUNDLE message
+ *
+ * Owns the bundled messages; its length is the sum of theirs.
+ */
+class RSVPBundleMsg : public RSVPBundleMsg_Base
+{
+  protected:
+    std::vector<RSVPMessage*> messages;
+
+  private:
+    void copy(const RSVPBundleMsg& other) {
+        for (unsigned int i = 0; i < other.messages.size(); i++)
+        {
+            RSVPMessage *msg = other.messages[i]->dup();
+            take(msg);
+            messages.push_back(msg);
+        }
+    }
+    void clean() {
+        for (unsigned int i = 0; i < messages.size(); i++)
+            dropAndDelete(messages[i]);
+        messages.clear();
+    }
+
+  public:
+    RSVPBundleMsg(const char *name=NULL, int kind=RSVP_TRAFFIC) : RSVPBundleMsg_Base(name,kind) {}
+    RSVPBundleMsg(const RSVPBundleMsg& other) : RSVPBundleMsg_Base(other.getName()) {operator=(other);}
+    virtual ~RSVPBundleMsg() {clean();}
+    RSVPBundleMsg& operator=(const RSVPBundleMsg& other) {
+        if (this == &other) return *this;
+        RSVPBundleMsg_Base::operator=(other);
+        clean();
+        copy(other);
+        return *this;
+    }
+    virtual RSVPBundleMsg *dup() const {return new RSVPBundleMsg(*this);}
+
+    virtual void forEachChild(cVisitor *v) {
+        RSVPBundleMsg_Base::forEachChild(v);
+        for (unsigned int i = 0; i < messages.size(); i++)
+            v->visit(messages[i]);
+    }
+
+    /**
+     * Appends a message to the bundle, which takes its ownership.
+     */
+    void addMessage(RSVPMessage *msg) {
+        take(msg);
+        messages.push_back(msg);
+        addByteLength(msg->getByteLength());
+    }
+
+    unsigned int getNumMessages() const {return messages.size();}
+
+    /**
+     * Empties the bundle and returns its messages; the caller becomes
+     * their owner.
+     */
+    std::vector<RSVPMessage*> removeMessages() {
+        std::vector<RSVPMessage*> ret;
+        ret.swap(messages);
+        for (unsigned int i = 0; i < ret.size(); i++)
+            drop(ret[i]);
+        setByteLength(0);
+        return ret;
+    }
+};
+
+#endif
@@ -166,6 +166,9 @@ void LinkStateRouting::processLINK_STATE_MESSAGE(LinkStateMsg* msg, IPAddress se
         }
     }
 
+    if(forward.size() > 0)
+        tedmod->tedChanged();
+
     if(change)
         tedmod->rebuildRoutingTable();
 
@@ -14,6 +14,8 @@
 
 #include <omnetpp.h>
 #include <algorithm>
+#include <functional>
+#include <queue>
 
 #include "TED.h"
 #include "IPControlInfo.h"
@@ -126,6 +128,9 @@ void TED::initialize(int stage)
             interfaceAddrs.push_back(ie->ipv4Data()->getIPAddress());
     }
 
+    // cached shortest paths must be dropped when RSVP/LDP change the TED
+    nb->subscribe(this, NF_TED_CHANGED);
+
     rebuildRoutingTable();
 
     WATCH_VECTOR(ted);
@@ -136,6 +141,18 @@ void TED::handleMessage(cMessage * msg)
     ASSERT(false);
 }
 
+void TED::receiveChangeNotification(int category, const cPolymorphic *details)
+{
+    Enter_Method_Silent();
+    ASSERT(category == NF_TED_CHANGED);
+    tedChanged();
+}
+
+void TED::tedChanged()
+{
+    spfCache.clear();
+}
+
 std::ostream & operator<<(std::ostream & os, const TELinkStateInfo& info)
 {
     os << "advrouter:" << info.advrouter;
@@ -210,6 +227,9 @@ void TED::rebuildRoutingTable()
 {
     EV << "rebuilding routing table at " << routerId << endl;
 
+    // callers modify link states directly before calling us
+    tedChanged();
+
     std::vector<vertex_t> V = calculateShortestPaths(ted, 0.0, 7);
 
     // remove all routing entries, except multicast ones (we don't care about them)
@@ -335,63 +355,106 @@ bool TED::isLocalPeer(IPAddress inetAddr)
 std::vector<TED::vertex_t> TED::calculateShortestPaths(const TELinkStateInfoVector& topology,
             double req_bandwidth, int priority)
 {
-    std::vector<vertex_t> vertices;
-    std::vector<edge_t> edges;
-
-    // select edges that have enough bandwidth left, and store them into edges[].
-    // meanwhile, collect vertices in vectices[].
-    for (unsigned int i = 0; i < topology.size(); i++)
+    if (&topology != &ted)
     {
-        if (!topology[i].state)
-            continue;
+        // some other link state vector: no caching
+        Graph graph;
+        graph.update(topology);
+        graph.findOrAddVertex(routerId);
+        return dijkstra(graph, topology, req_bandwidth, priority);
+    }
 
-        if (topology[i].UnResvBandwidth[priority] < req_bandwidth)
-            continue;
+    // bring the graph up to date with new links, and reuse the result if
+    // nothing changed since the same query
+    tedGraph.update(ted);
+    tedGraph.findOrAddVertex(routerId);
 
-        edge_t edge;
-        edge.src = assignIndex(vertices, topology[i].advrouter);
-        edge.dest = assignIndex(vertices, topology[i].linkid);
-        edge.metric = topology[i].metric;
-        edges.push_back(edge);
-    }
+    std::pair<double,int> key(req_bandwidth, priority);
+    ShortestPathCache::iterator it = spfCache.find(key);
+    if (it == spfCache.end())
+        it = spfCache.insert(std::make_pair(key, dijkstra(tedGraph, ted, req_bandwidth, priority))).first;
+    return it->second;
+}
 
-    IPAddress srcAddr = routerId;
+std::vector<TED::vertex_t> TED::dijkstra(const Graph& graph, const TELinkStateInfoVector& topology,
+            double req_bandwidth, int priority)
+{
+    std::vector<vertex_t> vertices = graph.vertices;
 
-    int srcIndex = assignIndex(vertices, srcAddr);
+    typedef std::pair<double,int> QueueEntry; // (dist, vertex)
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue;
+
+    int srcIndex = graph.vertexIndex.find(routerId)->second;
     vertices[srcIndex].dist = 0.0;
+    queue.push(QueueEntry(0.0, srcIndex));
 
-    // FIXME comment: Dijkstra? just guessing...
-    for (unsigned int i = 1; i < vertices.size(); i++)
+    while (!queue.empty())
     {
-        bool mod = false;
+        QueueEntry top = queue.top();
+        queue.pop();
+
+        int src = top.second;
+        if (top.first > vertices[src].dist)
+            continue; // already settled via a shorter path
 
+        const std::vector<edge_t>& edges = graph.outEdges[src];
         for (unsigned int j = 0; j < edges.size(); j++)
         {
-            int src = edges[j].src;
-            int dest = edges[j].dest;
+            // only use links that are up and have enough bandwidth left
+            const TELinkStateInfo& link = topology[edges[j].link];
+            if (!link.state)
+                continue;
+
+            if (link.UnResvBandwidth[priority] < req_bandwidth)
+                continue;
 
-            ASSERT(src >= 0);
-            ASSERT(dest >= 0);
-            ASSERT(src < (int)vertices.size());
-            ASSERT(dest < (int)vertices.size());
+            int dest = edges[j].dest;
             ASSERT(src != dest);
 
-            if (vertices[src].dist + edges[j].metric >= vertices[dest].dist)
+            // the metric may have changed since the edge was added, use the current one
+            double dist = vertices[src].dist + link.metric;
+            if (dist >= vertices[dest].dist)
                 continue;
 
-            vertices[dest].dist = vertices[src].dist + edges[j].metric;
+            vertices[dest].dist = dist;
             vertices[dest].parent = src;
-
-            mod = true;
+            queue.push(QueueEntry(dist, dest));
         }
-
-        if (!mod)
-            break;
     }
 
     return vertices;
 }
 
+int TED::Graph::findOrAddVertex(IPAddress nodeAddr)
+{
+    std::tr1::unordered_map<IPAddress, int, IPAddressHash>::iterator it = vertexIndex.find(nodeAddr);
+    if (it != vertexIndex.end())
+        return it->second;
+
+    vertex_t newVertex;
+    newVertex.node = nodeAddr;
+    newVertex.dist = LS_INFINITY;
+    newVertex.parent = -1;
+
+    vertices.push_back(newVertex);
+    outEdges.push_back(std::vector<edge_t>());
+    vertexIndex[nodeAddr] = vertices.size() - 1;
+    return vertices.size() - 1;
+}
+
+void TED::Graph::update(const TELinkStateInfoVector& topology)
+{
+    for (; numLinks < topology.size(); numLinks++)
+    {
+        edge_t edge;
+        edge.src = findOrAddVertex(topology[numLinks].advrouter);
+        edge.dest = findOrAddVertex(topology[numLinks].linkid);
+        edge.metric = topology[numLinks].metric;
+        edge.link = numLinks;
+        outEdges[edge.src].push_back(edge);
+    }
+}
+
 bool TED::checkLinkValidity(TELinkStateInfo link, TELinkStateInfo *&match)
 {
     std::vector<TELinkStateInfo>::iterator it;
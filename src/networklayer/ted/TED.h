@@ -16,8 +16,11 @@
 #define __INET_TED_H
 
 #include <omnetpp.h>
+#include <map>
 #include "TED_m.h"
 #include "IntServ.h"
+#include "INETHashMap.h"
+#include "NotificationBoard.h"
 
 class IRoutingTable;
 class IInterfaceTable;
@@ -31,7 +34,7 @@ class NotificationBoard;
  *
  * See NED file for more info.
  */
-class TED : public cSimpleModule
+class TED : public cSimpleModule, public INotifiable
 {
   public:
     /**
@@ -54,6 +57,25 @@ class TED : public cSimpleModule
         int src;       // index into the vertex_t[] vector
         int dest;      // index into the vertex_t[] vector
         double metric; // link cost
+        int link;      // index into the link state vector (for state/bandwidth checks)
+    };
+
+    /**
+     * Only used internally, during shortest path calculation: the graph
+     * built from a TELinkStateInfoVector. Links are only ever added to
+     * the link state database, and their endpoints never change, so the
+     * graph can be extended incrementally by update().
+     */
+    struct Graph
+    {
+        std::tr1::unordered_map<IPAddress, int, IPAddressHash> vertexIndex;
+        std::vector<vertex_t> vertices;     // dist/parent unused here
+        std::vector<std::vector<edge_t> > outEdges; // by source vertex
+        unsigned int numLinks;  // links of the topology already added
+
+        Graph() {numLinks = 0;}
+        int findOrAddVertex(IPAddress nodeAddr);
+        void update(const TELinkStateInfoVector& topology);
     };
 
     /**
@@ -69,6 +91,7 @@ class TED : public cSimpleModule
     virtual void initialize(int stage);
     virtual int numInitStages() const  {return 5;}
     virtual void handleMessage(cMessage *msg);
+    virtual void receiveChangeNotification(int category, const cPolymorphic *details);
 
     virtual IPAddressVector calculateShortestPath(IPAddressVector dest,
         const TELinkStateInfoVector& topology, double req_bandwidth, int priority);
@@ -87,6 +110,14 @@ class TED : public cSimpleModule
     virtual IPAddressVector getLocalAddress();
 
     virtual void rebuildRoutingTable();
+
+    /**
+     * Must be called after the link state, metric or bandwidth of links in
+     * the database changed; drops cached shortest path trees. (Changes
+     * announced via NF_TED_CHANGED and rebuildRoutingTable() call it
+     * automatically.)
+     */
+    virtual void tedChanged();
     //@}
 
   protected:
@@ -100,11 +131,22 @@ class TED : public cSimpleModule
   protected:
     int maxMessageId;
 
+    // graph of the ted vector, and shortest path trees computed on it,
+    // by (required bandwidth, priority); the latter are valid until tedChanged()
+    Graph tedGraph;
+    typedef std::map<std::pair<double,int>, std::vector<vertex_t> > ShortestPathCache;
+    ShortestPathCache spfCache;
+
     virtual int assignIndex(std::vector<vertex_t>& vertices, IPAddress nodeAddr);
 
     std::vector<vertex_t> calculateShortestPaths(const TELinkStateInfoVector& topology,
         double req_bandwidth, int priority);
 
+    // Dijkstra from routerId over links that are up and have req_bandwidth
+    // unreserved at the given priority
+    std::vector<vertex_t> dijkstra(const Graph& graph, const TELinkStateInfoVector& topology,
+        double req_bandwidth, int priority);
+
   public: //FIXME
     virtual bool checkLinkValidity(TELinkStateInfo link, TELinkStateInfo *&match);
     virtual void updateTimestamp(TELinkStateInfo *link);
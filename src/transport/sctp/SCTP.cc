@@ -32,6 +32,17 @@ bool SCTP::testing;
 bool SCTP::logverbose;
 
 int32 SCTP::nextConnId = 0;
+int32 SCTP::numInstances = 0;
+
+
+bool SCTPFreeList::recycling = true;
+
+SCTP::SCTP()
+{
+    numInstances++;
+    numPacketHeapAllocations = 0;
+    numPacketRecycledAllocations = 0;
+}
 
 
 void SCTP::printInfoConnMap()
@@ -106,6 +117,7 @@ void SCTP::initialize()
     numPacketsReceived = 0;
     numPacketsDropped    = 0;
     sizeConnMap          = 0;
+    SCTPFreeList::recycling = par("recycleMemory");
     if ((bool)par("udpEncapsEnabled"))
         bindPortForUDP();
 }
@@ -129,6 +141,8 @@ SCTP::~SCTP()
         sctpVTagMap.clear();
     }
     sctpEV3<<"after clearing maps\n";
+    if (--numInstances == 0)
+        SCTPMessage::releaseFreeLists();
 }
 
 
@@ -752,6 +766,8 @@ void SCTP::removeAssociation(SCTPAssociation *conn)
             assocStatMapIterator->second.stop        = simulation.getSimTime();
             assocStatMapIterator->second.lifeTime    = assocStatMapIterator->second.stop - assocStatMapIterator->second.start;
             assocStatMapIterator->second.throughput = assocStatMapIterator->second.ackedBytes*8 / assocStatMapIterator->second.lifeTime.dbl();
+            assocStatMapIterator->second.numDataVarHeapAllocations     = conn->dataVarPool->numHeapAllocations;
+            assocStatMapIterator->second.numDataVarRecycledAllocations = conn->dataVarPool->numRecycledAllocations;
         }
         while (!ok) {
             if (sizeConnMap == 0) {
@@ -828,7 +844,7 @@ void SCTP::removeAssociation(SCTPAssociation *conn)
           i != conn->getRetransmissionQueue()->payloadQueue.end(); i++) {
         SCTPQueue::PayloadQueue::iterator j = conn->getTransmissionQueue()->payloadQueue.find(i->second->tsn);
         if(j != conn->getTransmissionQueue()->payloadQueue.end()) {
-            conn->getTransmissionQueue()->payloadQueue.erase(j);
+            conn->getTransmissionQueue()->removeMsg(j->first);
         }
     }
      // TD 20.11.09: Now, both queues can be safely deleted.
@@ -862,6 +878,8 @@ void SCTP::finish()
     }
     ev << getFullPath() << ": finishing SCTP with "
         << sctpConnMap.size() << " connections open." << endl;
+    recordScalar("Packet Heap Allocations",     numPacketHeapAllocations);
+    recordScalar("Packet Recycled Allocations", numPacketRecycledAllocations);
 
     for (AssocStatMap::const_iterator iterator = assocStatMap.begin();
           iterator != assocStatMap.end(); iterator++) {
@@ -887,6 +905,8 @@ void SCTP::finish()
         recordScalar("Duplicate Acks",       assoc.numDups);
         recordScalar("Packets Received",         numPacketsReceived);
         recordScalar("Packets Dropped",      numPacketsDropped);
+        recordScalar("DataVariables Heap Allocations",     assoc.numDataVarHeapAllocations);
+        recordScalar("DataVariables Recycled Allocations", assoc.numDataVarRecycledAllocations);
 
     }
 }
@@ -150,6 +150,8 @@ class INET_API SCTP : public cSimpleModule
             uint32 numForwardTsn;
             double throughput;
             simtime_t lifeTime;
+            uint64 numDataVarHeapAllocations;
+            uint64 numDataVarRecycledAllocations;
         }AssocStat;
 
         typedef std::map<int32,AssocStat> AssocStatMap;
@@ -168,6 +170,7 @@ class INET_API SCTP : public cSimpleModule
     protected:
         int32 sizeConnMap;
         static int32 nextConnId;
+        static int32 numInstances; // the last one releases the packet free lists
 
         uint16 nextEphemeralPort;
 
@@ -188,9 +191,13 @@ class INET_API SCTP : public cSimpleModule
         uint32 numGapReports;
         uint32 numPacketsReceived;
         uint32 numPacketsDropped;
+        // SCTPMessage and SCTPDataChunk objects created by this module
+        uint64 numPacketHeapAllocations;
+        uint64 numPacketRecycledAllocations;
         //double failover();
     public:
         //Module_Class_Members(SCTP, cSimpleModule, 0);
+        SCTP();
         virtual ~SCTP();
         virtual void initialize();
         virtual void handleMessage(cMessage *msg);
@@ -31,8 +31,10 @@
 #include "SCTPSendStream.h"
 #include "SCTPReceiveStream.h"
 #include "SCTPMessage.h"
+#include "SCTPFreeList.h"
 #include "IPControlInfo.h"
 #include <list>
+#include <vector>
 #include <iostream>
 #include <errno.h>
 #include <math.h>
@@ -289,6 +291,13 @@ class INET_API SCTPDataVariables : public cPolymorphic
         SCTPDataVariables();
         ~SCTPDataVariables();
 
+        // One of these is created for every DATA chunk sent or received;
+        // the memory comes from the free list of the association, and goes
+        // back to it on delete, wherever that happens.
+        static void* operator new(size_t size, SCTPFreeList* pool);
+        static void operator delete(void* p, SCTPFreeList* pool);
+        static void operator delete(void* p);
+
         inline void setInitialDestination(SCTPPathVariables* path) {
             initialDestination = path;
         }
@@ -566,6 +575,7 @@ class INET_API SCTPAssociation : public cObject
         QueueCounter            qCounter;
         SCTPQueue*              transmissionQ;
         SCTPQueue*              retransmissionQ;
+        SCTPFreeList*           dataVarPool;                // memory of SCTPDataVariables
         SCTPSendStreamMap       sendStreams;
         SCTPReceiveStreamMap    receiveStreams;
         SCTPAlgorithm*          sctpAlgorithm;
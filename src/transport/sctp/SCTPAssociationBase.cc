@@ -184,6 +184,34 @@ SCTPDataVariables::~SCTPDataVariables()
 {
 }
 
+// stored in front of each SCTPDataVariables: the free list its memory belongs to
+union SCTPDataVariablesHeader
+{
+    SCTPFreeList* pool;
+    double        align;
+};
+
+void* SCTPDataVariables::operator new(size_t size, SCTPFreeList* pool)
+{
+    SCTPDataVariablesHeader* header =
+        (SCTPDataVariablesHeader*)pool->allocate(sizeof(SCTPDataVariablesHeader) + size);
+    header->pool = pool;
+    return header + 1;
+}
+
+void SCTPDataVariables::operator delete(void* p, SCTPFreeList* pool)
+{
+    operator delete(p);
+}
+
+void SCTPDataVariables::operator delete(void* p)
+{
+    if (p == NULL)
+        return;
+    SCTPDataVariablesHeader* header = (SCTPDataVariablesHeader*)p - 1;
+    header->pool->release(header);
+}
+
 SCTPStateVariables::SCTPStateVariables()
 {
     active                    = false;
@@ -289,6 +317,7 @@ SCTPAssociation::SCTPAssociation(SCTP* _module, int32 _appGateIndex, int32 _asso
     // queues and algorithm will be created on active or passive open
     transmissionQ                       = NULL;
     retransmissionQ                     = NULL;
+    dataVarPool                         = new SCTPFreeList();
     sctpAlgorithm                       = NULL;
     state                               = NULL;
     sackPeriod                          = SACK_DELAY;
@@ -385,6 +414,9 @@ SCTPAssociation::~SCTPAssociation()
     delete fsm;
     delete state;
     delete sctpAlgorithm;
+
+    // chunks still referenced elsewhere keep the free list until they are deleted
+    dataVarPool->detach();
 }
 
 bool SCTPAssociation::processTimer(cMessage *msg)
@@ -704,6 +736,8 @@ void SCTPAssociation::stateEntered(int32 status)
             stat.numForwardTsn                   = 0;
             stat.lifeTime                        = 0;
             stat.throughput                      = 0;
+            stat.numDataVarHeapAllocations       = 0;
+            stat.numDataVarRecycledAllocations   = 0;
             sctpMain->assocStatMap[stat.assocId] = stat;
             ccModule = sctpMain->par("ccModule");
             switch (ccModule)
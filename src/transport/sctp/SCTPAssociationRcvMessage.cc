@@ -678,7 +678,7 @@ void SCTPAssociation::tsnWasReneged(SCTPDataVariables*       chunk,
                 }
                 else {
                     chunk->enqueuedInTransmissionQ = true;
-                    chunk->setNextDestination(chunk->getLastDestinationPath());
+                    transmissionQ->setNextDestination(chunk, chunk->getLastDestinationPath());
                     CounterMap::iterator q = qCounter.roomTransQ.find(chunk->getNextDestination());
                     q->second+=ADD_PADDING(chunk->len/8+SCTP_DATA_CHUNK_LENGTH);
                     CounterMap::iterator qb=qCounter.bookedTransQ.find(chunk->getNextDestination());
@@ -715,7 +715,6 @@ SCTPEventCode SCTPAssociation::processSackArrived(SCTPSackChunk* sackChunk)
     const uint32         tsna                         = sackChunk->getCumTsnAck();
     uint32               highestNewAck            = tsna;   // Highest newly acked TSN
     const uint16         numGaps                      = sackChunk->getNumGaps();
-    bool                     getChunkFastFirstTime = true;
 
     // ====== Print some information =========================================
     sctpEV3 << "##### SACK Processing: TSNa=" << tsna << " #####" << endl;
@@ -786,16 +785,15 @@ SCTPEventCode SCTPAssociation::processSackArrived(SCTPSackChunk* sackChunk)
         //      => new highestTsnAcked = CumAck
         sctpEV3 << "numGaps=0 && tsna " << tsna
                   << " < highestTsnAcked " << state->highestTsnAcked << endl;
-        uint32 i = state->highestTsnAcked;
-        while (i >= tsna + 1) {
-            SCTPDataVariables* myChunk = retransmissionQ->getChunk(i);
-            if(myChunk) {
-                if(chunkHasBeenAcked(myChunk)) {
-                    tsnWasReneged(myChunk,
-                                      0);
-                }
+        // Only visit the TSNs actually present in the retransmissionQ
+        SCTPQueue::PayloadQueue::iterator it = retransmissionQ->payloadQueue.upper_bound(tsna);
+        SCTPQueue::PayloadQueue::iterator end = retransmissionQ->payloadQueue.upper_bound(state->highestTsnAcked);
+        for (; tsna < state->highestTsnAcked && it != end; it++) {
+            SCTPDataVariables* myChunk = it->second;
+            if(chunkHasBeenAcked(myChunk)) {
+                tsnWasReneged(myChunk,
+                                  0);
             }
-            i--;
         }
         state->highestTsnAcked = tsna;
     }
@@ -823,22 +821,16 @@ SCTPEventCode SCTPAssociation::processSackArrived(SCTPSackChunk* sackChunk)
             // This SACK contains a last gap ack < highestTsnAcked
             //      => rereg TSNs from last gap ack to highestTsnAcked
             //      => new highestTsnAcked = last gap ack
-            uint32 i = state->highestTsnAcked;
-            while (i >= sackChunk->getGapStop(numGaps - 1) + 1) {
-                // ====== Looking up TSN in retransmission queue ================
-                SCTPDataVariables* myChunk = retransmissionQ->getChunk(i);
-                if(myChunk) {
-                    if (chunkHasBeenAcked(myChunk)) {
-                        sctpEV3 << "TSN " << i << " was found. It has been un-acked." << endl;
-                        tsnWasReneged(myChunk,
-                                          2);
-                        sctpEV3 << "highestTsnAcked now " << state->highestTsnAcked << endl;
-                    }
-                }
-                else {
-                    sctpEV3 << "TSN " << i << " not found in retransmissionQ" << endl;
+            SCTPQueue::PayloadQueue::iterator it = retransmissionQ->payloadQueue.upper_bound(sackChunk->getGapStop(numGaps - 1));
+            SCTPQueue::PayloadQueue::iterator end = retransmissionQ->payloadQueue.upper_bound(state->highestTsnAcked);
+            for (; sackChunk->getGapStop(numGaps - 1) < state->highestTsnAcked && it != end; it++) {
+                SCTPDataVariables* myChunk = it->second;
+                if (chunkHasBeenAcked(myChunk)) {
+                    sctpEV3 << "TSN " << it->first << " was found. It has been un-acked." << endl;
+                    tsnWasReneged(myChunk,
+                                      2);
+                    sctpEV3 << "highestTsnAcked now " << state->highestTsnAcked << endl;
                 }
-                i--;
             }
             state->highestTsnAcked = sackChunk->getGapStop(numGaps - 1);
         }
@@ -851,18 +843,21 @@ SCTPEventCode SCTPAssociation::processSackArrived(SCTPSackChunk* sackChunk)
 
 
             // ====== Iterate over TSNs in gap reports =========================
+            // (only those present in the retransmissionQ; one lookup per gap block)
             sctpEV3 << "Examine TSNs between " << lo << " and " << hi << endl;
-            for (uint32 pos = lo; pos <= hi; pos++) {
-                SCTPDataVariables* myChunk = retransmissionQ->getChunkFast(pos, getChunkFastFirstTime);
-                if (myChunk) {
-                    if(chunkHasBeenAcked(myChunk) == false) {
-                        SCTPPathVariables* myChunkLastPath = myChunk->getLastDestinationPath();
-                        assert(myChunkLastPath != NULL);
-                        // T.D. 02.02.2010: This chunk has been acked newly.
-                        //                        Let's process this new acknowledgement!
-                        handleChunkReportedAsAcked(highestNewAck, rttEstimation, myChunk,
-                                                            path /* i.e. the SACK path for RTT measurement! */);
-                    }
+            if (lo > hi)
+                continue;
+            SCTPQueue::PayloadQueue::iterator it = retransmissionQ->payloadQueue.lower_bound(lo);
+            SCTPQueue::PayloadQueue::iterator end = retransmissionQ->payloadQueue.upper_bound(hi);
+            for (; it != end; it++) {
+                SCTPDataVariables* myChunk = it->second;
+                if(chunkHasBeenAcked(myChunk) == false) {
+                    SCTPPathVariables* myChunkLastPath = myChunk->getLastDestinationPath();
+                    assert(myChunkLastPath != NULL);
+                    // T.D. 02.02.2010: This chunk has been acked newly.
+                    //                        Let's process this new acknowledgement!
+                    handleChunkReportedAsAcked(highestNewAck, rttEstimation, myChunk,
+                                                        path /* i.e. the SACK path for RTT measurement! */);
                 }
             }
         }
@@ -873,15 +868,13 @@ SCTPEventCode SCTPAssociation::processSackArrived(SCTPSackChunk* sackChunk)
         uint32 lo = tsna;
         for (int32 key = 0; key < numGaps; key++) {
             const uint32 hi = sackChunk->getGapStart(key);
-            for (uint32 pos = lo+1; pos <= hi - 1; pos++) {
-                SCTPDataVariables* myChunk = retransmissionQ->getChunkFast(pos, getChunkFastFirstTime);
-                if(myChunk) {
-                    handleChunkReportedAsMissing(sackChunk, highestNewAck, myChunk,
+            if (lo < hi) {
+                SCTPQueue::PayloadQueue::iterator it = retransmissionQ->payloadQueue.upper_bound(lo);
+                SCTPQueue::PayloadQueue::iterator end = retransmissionQ->payloadQueue.lower_bound(hi);
+                for (; it != end; it++) {
+                    handleChunkReportedAsMissing(sackChunk, highestNewAck, it->second,
                                                           path /* i.e. the SACK path for RTT measurement! */);
                 }
-                else {
-                    sctpEV3 << "TSN " << pos << " not found in retransmissionQ" << endl;
-                }
             }
             lo = sackChunk->getGapStop(key);
         }
@@ -1174,7 +1167,7 @@ uint32 SCTPAssociation::dequeueAckedChunks(const uint32       tsna,
                 qb->second -= chunk->booksize;
             }
 
-            chunk = retransmissionQ->getAndExtractChunk(chunk->tsn);
+            chunk = retransmissionQ->extractMessage();  // it is the first one
             state->sendBuffer -= chunk->len/8;
 
             SCTPPathVariables* lastPath = chunk->getLastDestinationPath();
@@ -1691,7 +1684,7 @@ void SCTPAssociation::moveChunkToOtherPath(SCTPDataVariables* chunk,
     SCTPPathVariables* lastPath = chunk->getLastDestinationPath();
     chunk->hasBeenFastRetransmitted = false;
     chunk->gapReports                     = 0;
-    chunk->setNextDestination(newPath);
+    transmissionQ->setNextDestination(chunk, newPath);  // keeps its per-path index up to date
     sctpEV3 << simTime() << ": Timer-Based RTX for TSN " << chunk->tsn
               << ": lastDestination=" << chunk->getLastDestination()
               << " nextDestination="  << chunk->getNextDestination() << endl;
@@ -106,7 +106,7 @@ void SCTPAssociation::loadPacket(SCTPPathVariables* pathVar,
 SCTPDataVariables* SCTPAssociation::makeDataVarFromDataMsg(SCTPDataMsg*         datMsg,
                                                                               SCTPPathVariables* path)
 {
-    SCTPDataVariables* datVar = new SCTPDataVariables();
+    SCTPDataVariables* datVar = new (dataVarPool) SCTPDataVariables();
 
     datMsg->setInitialDestination(path->remoteAddress);
     datVar->setInitialDestination(path);
@@ -168,6 +168,7 @@ SCTPAssociation* SCTPAssociation::cloneAssociation()
     SCTPAssociation* assoc = new SCTPAssociation(sctpMain,appGateIndex,assocId);
     const char* queueClass = transmissionQ->getClassName();
     assoc->transmissionQ = check_and_cast<SCTPQueue *>(createOne(queueClass));
+    assoc->transmissionQ->setIndexByPath(true);
     assoc->retransmissionQ = check_and_cast<SCTPQueue *>(createOne(queueClass));
 
     const char* sctpAlgorithmClass = sctpAlgorithm->getClassName();
@@ -321,6 +322,7 @@ void SCTPAssociation::initAssociation(SCTPOpenCommand *openCmd)
     // create send/receive queues
     const char *queueClass = openCmd->getQueueClass();
     transmissionQ = check_and_cast<SCTPQueue *>(createOne(queueClass));
+    transmissionQ->setIndexByPath(true);  // for getOutboundDataChunk()
 
     retransmissionQ = check_and_cast<SCTPQueue *>(createOne(queueClass));
     outboundStreams = openCmd->getOutboundStreams();
@@ -1523,7 +1525,7 @@ bool SCTPAssociation::advanceCtsna()
 
 SCTPDataVariables* SCTPAssociation::makeVarFromMsg(SCTPDataChunk* dataChunk)
 {
-    SCTPDataVariables* chunk = new SCTPDataVariables();
+    SCTPDataVariables* chunk = new (dataVarPool) SCTPDataVariables();
 
     chunk->bbit = dataChunk->getBBit();
     chunk->ebit = dataChunk->getEBit();
@@ -1558,9 +1560,11 @@ SCTPDataVariables* SCTPAssociation::getOutboundDataChunk(const SCTPPathVariables
               << " availableSpace=" << availableSpace
               << " availableCwnd="  << availableCwnd
               << endl;
-    if (!transmissionQ->payloadQueue.empty()) {
-        for(SCTPQueue::PayloadQueue::iterator it = transmissionQ->payloadQueue.begin();
-             it != transmissionQ->payloadQueue.end(); it++) {
+    // only look at the chunks destined to this path (in TSN order)
+    const SCTPQueue::PayloadQueue* pathQueue = transmissionQ->getPathQueue(path);
+    if (pathQueue != NULL) {
+        for(SCTPQueue::PayloadQueue::const_iterator it = pathQueue->begin();
+             it != pathQueue->end(); it++) {
             SCTPDataVariables* chunk = it->second;
             if( (chunkHasBeenAcked(chunk) == false) &&
                  (chunk->getNextDestinationPath() == path) ) {
@@ -1573,7 +1577,7 @@ SCTPDataVariables* SCTPAssociation::getOutboundDataChunk(const SCTPPathVariables
                     //                        this chunk is actually dequeued. Therefore, the check
                     //                        for "chunkHasBeenAcked==false" has been moved into the
                     //                        "if" statement above!
-                    transmissionQ->payloadQueue.erase(it);
+                    transmissionQ->removeMsg(chunk->tsn);  // invalidates it
                     chunk->enqueuedInTransmissionQ = false;
                     CounterMap::iterator i = qCounter.roomTransQ.find(path->remoteAddress);
                     i->second -= ADD_PADDING(chunk->len/8+SCTP_DATA_CHUNK_LENGTH);
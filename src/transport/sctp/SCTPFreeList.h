@@ -0,0 +1,96 @@
+//
+// Copyright (C) 2005-2010 Irene Ruengeler
+// Copyright (C) 2009-2010 Thomas Dreibholz
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __SCTPFREELIST_H
+#define __SCTPFREELIST_H
+
+#include <vector>
+#include "INETDefs.h"
+
+/**
+ * Memory blocks of one size, kept for reuse after the objects in them
+ * were deleted. The objects created for every DATA chunk
+ * (SCTPDataVariables, SCTPMessage, SCTPDataChunk) take their memory from
+ * such lists through class-level operator new/delete, so in steady state
+ * they need no heap allocation.
+ *
+ * A list owned by an association is detached when the association is
+ * deleted, and deletes itself when the last block it handed out comes
+ * back.
+ */
+class INET_API SCTPFreeList
+{
+    protected:
+        std::vector<void*> blocks;
+        uint32 maxBlocks;
+        uint64 numOutstanding;
+        bool detached;
+
+    public:
+        // off: every block comes from and goes back to the heap (for comparisons)
+        static bool recycling;
+
+        uint64 numHeapAllocations;
+        uint64 numRecycledAllocations;
+
+        SCTPFreeList(uint32 maxBlocks = 65536) : maxBlocks(maxBlocks), numOutstanding(0),
+            detached(false), numHeapAllocations(0), numRecycledAllocations(0) {}
+        ~SCTPFreeList() {clear();}
+
+        bool isEmpty() const {return blocks.empty();}
+
+        /** All blocks requested from one list must have the same size */
+        void* allocate(size_t size) {
+            numOutstanding++;
+            if (!blocks.empty()) {
+                void* p = blocks.back();
+                blocks.pop_back();
+                numRecycledAllocations++;
+                return p;
+            }
+            numHeapAllocations++;
+            return ::operator new(size);
+        }
+
+        void release(void* p) {
+            numOutstanding--;
+            if (recycling && !detached && blocks.size() < maxBlocks)
+                blocks.push_back(p);
+            else
+                ::operator delete(p);
+            if (detached && numOutstanding == 0)
+                delete this;
+        }
+
+        /** Returns the kept blocks to the heap */
+        void clear() {
+            for (std::vector<void*>::iterator iterator = blocks.begin(); iterator != blocks.end(); iterator++)
+                ::operator delete(*iterator);
+            std::vector<void*>().swap(blocks);
+        }
+
+        /** Called by the owner instead of delete; blocks still in use keep the list alive */
+        void detach() {
+            clear();
+            detached = true;
+            if (numOutstanding == 0)
+                delete this;
+        }
+};
+
+#endif
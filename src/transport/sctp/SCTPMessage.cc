@@ -23,6 +23,66 @@
 
 Register_Class(SCTPMessage);
 
+// never deleted: packets may outlive all SCTP modules
+static SCTPFreeList* messageFreeList = new SCTPFreeList();
+static SCTPFreeList* dataChunkFreeList = new SCTPFreeList();
+
+// the statistics go to the SCTP module that creates the packet
+static void countPacketAllocation(bool recycled)
+{
+    SCTP* sctpMain = dynamic_cast<SCTP*>(simulation.getContextModule());
+    if (sctpMain != NULL) {
+        if (recycled)
+            sctpMain->numPacketRecycledAllocations++;
+        else
+            sctpMain->numPacketHeapAllocations++;
+    }
+}
+
+void* SCTPMessage::operator new(size_t size)
+{
+    if (size != sizeof(SCTPMessage))
+        return ::operator new(size);  // subclass
+    countPacketAllocation(!messageFreeList->isEmpty());
+    return messageFreeList->allocate(size);
+}
+
+void SCTPMessage::operator delete(void* p, size_t size)
+{
+    if (p == NULL)
+        return;
+    if (size != sizeof(SCTPMessage))
+        ::operator delete(p);
+    else
+        messageFreeList->release(p);
+}
+
+void SCTPMessage::releaseFreeLists()
+{
+    messageFreeList->clear();
+    dataChunkFreeList->clear();
+}
+
+void* SCTPDataChunk::operator new(size_t size)
+{
+    if (size != sizeof(SCTPDataChunk))
+        return ::operator new(size);
+    countPacketAllocation(!dataChunkFreeList->isEmpty());
+    return dataChunkFreeList->allocate(size);
+}
+
+void SCTPDataChunk::operator delete(void* p, size_t size)
+{
+    if (p == NULL)
+        return;
+    if (size != sizeof(SCTPDataChunk))
+        ::operator delete(p);
+    else
+        dataChunkFreeList->release(p);
+}
+
+Register_Class(SCTPDataChunk);
+
 SCTPMessage& SCTPMessage::operator=(const SCTPMessage& other)
 {
      SCTPMessage_Base::operator=(other);
@@ -22,6 +22,7 @@
 #include <list>
 #include "INETDefs.h"
 #include "SCTPMessage_m.h"
+#include "SCTPFreeList.h"
 
 /**
  * Represents a SCTP Message. More info in the SCTPMessage.msg file
@@ -38,6 +39,13 @@ class INET_API SCTPMessage : public SCTPMessage_Base
         ~SCTPMessage();
         SCTPMessage& operator=(const SCTPMessage& other);
         virtual SCTPMessage *dup() const {return new SCTPMessage(*this);}
+
+        // One of these is created for every packet sent; the memory of
+        // deleted ones is recycled (see SCTPFreeList)
+        static void* operator new(size_t size);
+        static void operator delete(void* p, size_t size);
+        /** Returns the recycled memory of SCTPMessage and SCTPDataChunk to the heap */
+        static void releaseFreeLists();
         /** Generated but unused method, should not be called. */
         virtual void setChunksArraySize(uint32 size);
         /** Generated but unused method, should not be called. */
@@ -72,6 +80,23 @@ class INET_API SCTPMessage : public SCTPMessage_Base
 
 };
 
+/**
+ * A DATA chunk. Only the memory management differs from the generated class.
+ */
+class INET_API SCTPDataChunk : public SCTPDataChunk_Base
+{
+    public:
+        SCTPDataChunk(const char *name=NULL, int32 kind=0) : SCTPDataChunk_Base(name, kind) {}
+        SCTPDataChunk(const SCTPDataChunk& other) : SCTPDataChunk_Base(other) {}
+        SCTPDataChunk& operator=(const SCTPDataChunk& other) {SCTPDataChunk_Base::operator=(other); return *this;}
+        virtual SCTPDataChunk *dup() const {return new SCTPDataChunk(*this);}
+
+        // One of these is created for every DATA chunk sent or received;
+        // the memory of deleted ones is recycled (see SCTPFreeList)
+        static void* operator new(size_t size);
+        static void operator delete(void* p, size_t size);
+};
+
 /*class SCTPErrorChunk : public SCTPErrorChunk_Base
 {
     protected:
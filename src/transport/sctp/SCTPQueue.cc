@@ -26,6 +26,7 @@ Register_Class(SCTPQueue);
 SCTPQueue::SCTPQueue()
 {
     assoc = NULL;
+    indexByPath = false;
 }
 
 SCTPQueue::~SCTPQueue()
@@ -38,6 +39,62 @@ SCTPQueue::~SCTPQueue()
     if (!payloadQueue.empty()) {
         payloadQueue.clear();
     }
+    pathQueues.clear();
+}
+
+void SCTPQueue::setIndexByPath(bool enabled)
+{
+    ASSERT(payloadQueue.empty());
+    indexByPath = enabled;
+}
+
+void SCTPQueue::indexChunk(const uint32 key, SCTPDataVariables* chunk)
+{
+    if (indexByPath)
+        pathQueues[chunk->getNextDestinationPath()][key] = chunk;
+}
+
+void SCTPQueue::unindexChunk(const uint32 key, SCTPDataVariables* chunk)
+{
+    if (!indexByPath)
+        return;
+    PathQueueMap::iterator i = pathQueues.find(chunk->getNextDestinationPath());
+    if (i != pathQueues.end() && i->second.erase(key) > 0) {
+        if (i->second.empty())
+            pathQueues.erase(i);
+        return;
+    }
+    // the next destination was changed behind our back; search all paths
+    for (i = pathQueues.begin(); i != pathQueues.end(); i++) {
+        if (i->second.erase(key) > 0) {
+            if (i->second.empty())
+                pathQueues.erase(i);
+            return;
+        }
+    }
+}
+
+void SCTPQueue::eraseChunk(PayloadQueue::iterator iterator)
+{
+    unindexChunk(iterator->first, iterator->second);
+    payloadQueue.erase(iterator);
+}
+
+void SCTPQueue::setNextDestination(SCTPDataVariables* chunk, SCTPPathVariables* path)
+{
+    PayloadQueue::iterator iterator = payloadQueue.find(chunk->tsn);
+    const bool reindex = indexByPath && iterator != payloadQueue.end() && iterator->second == chunk;
+    if (reindex)
+        unindexChunk(iterator->first, chunk);
+    chunk->setNextDestination(path);
+    if (reindex)
+        indexChunk(iterator->first, chunk);
+}
+
+const SCTPQueue::PayloadQueue* SCTPQueue::getPathQueue(const SCTPPathVariables* path) const
+{
+    PathQueueMap::const_iterator i = pathQueues.find(path);
+    return (i == pathQueues.end()) ? NULL : &i->second;
 }
 
 bool SCTPQueue::checkAndInsertChunk(const uint32 key, SCTPDataVariables* chunk)
@@ -47,6 +104,7 @@ bool SCTPQueue::checkAndInsertChunk(const uint32 key, SCTPDataVariables* chunk)
         return false;
     }
     payloadQueue[key] = chunk;
+    indexChunk(key, chunk);
     return true;
 }
 
@@ -60,7 +118,7 @@ SCTPDataVariables* SCTPQueue::extractMessage()
     if (!payloadQueue.empty()) {
         PayloadQueue::iterator iterator = payloadQueue.begin();
         SCTPDataVariables*    chunk   = iterator->second;
-        payloadQueue.erase(iterator);
+        eraseChunk(iterator);
         return chunk;
     }
     return NULL;
@@ -71,7 +129,7 @@ SCTPDataVariables* SCTPQueue::getAndExtractChunk(const uint32 tsn)
     if (!payloadQueue.empty()) {
         PayloadQueue::iterator iterator = payloadQueue.find(tsn);
         SCTPDataVariables*    chunk   = iterator->second;
-        payloadQueue.erase(iterator);
+        eraseChunk(iterator);
         return chunk;
     }
     return NULL;
@@ -151,7 +209,7 @@ SCTPDataVariables* SCTPQueue::getChunkFast(const uint32 tsn, bool& firstTime)
 void SCTPQueue::removeMsg(const uint32 tsn)
 {
     PayloadQueue::iterator iterator = payloadQueue.find(tsn);
-    payloadQueue.erase(iterator);
+    eraseChunk(iterator);
 }
 
 bool SCTPQueue::deleteMsg(const uint32 tsn)
@@ -162,7 +220,7 @@ bool SCTPQueue::deleteMsg(const uint32 tsn)
         SCTPDataVariables* chunk = iterator->second;
         cMessage* msg = check_and_cast<cMessage*>(chunk->userData);
         delete msg;
-        payloadQueue.erase(iterator);
+        eraseChunk(iterator);
         return true;
     }
     return false;
@@ -186,7 +244,7 @@ SCTPDataVariables* SCTPQueue::dequeueChunkBySSN(const uint16 ssn)
         if ((iterator->second->ssn == ssn) &&
              (iterator->second->bbit) &&
              (iterator->second->ebit) ) {
-            payloadQueue.erase(iterator);
+            eraseChunk(iterator);
             return chunk;
         }
     }
@@ -27,6 +27,7 @@
 
 class SCTPDataVariables;
 class SCTPAssociation;
+class SCTPPathVariables;
 
 
 /**
@@ -85,13 +86,40 @@ class INET_API SCTPQueue : public cPolymorphic
 
     SCTPDataVariables* dequeueChunkBySSN(const uint16 ssn);
 
+    /**
+     * Enables the per-path index (see pathQueues). Only useful for the
+     * transmission queue, where chunks are looked up by their next
+     * destination; must be called while the queue is empty.
+     */
+    void setIndexByPath(bool enabled);
+
+    /**
+     * Changes the chunk's next destination, and moves it to the right
+     * per-path queue if it is in this queue. Use this instead of
+     * SCTPDataVariables::setNextDestination() for chunks in an indexed queue.
+     */
+    void setNextDestination(SCTPDataVariables* chunk, SCTPPathVariables* path);
+
+    /** Returns the chunks whose next destination is the given path, or NULL if there are none */
+    const std::map<uint32, SCTPDataVariables*>* getPathQueue(const SCTPPathVariables* path) const;
+
 
   public:
      typedef std::map<uint32, SCTPDataVariables*> PayloadQueue;
      PayloadQueue payloadQueue;
 
+     // Subsets of payloadQueue by next destination, if indexByPath is set.
+     // Do not insert into/erase from payloadQueue directly when it is.
+     typedef std::map<const SCTPPathVariables*, PayloadQueue> PathQueueMap;
+
   protected:
      SCTPAssociation* assoc;    // SCTP connection object
+     bool indexByPath;
+     PathQueueMap pathQueues;
+
+     void indexChunk(const uint32 key, SCTPDataVariables* chunk);
+     void unindexChunk(const uint32 key, SCTPDataVariables* chunk);
+     void eraseChunk(PayloadQueue::iterator iterator);
 
   private:
      PayloadQueue::iterator GetChunkFastIterator;
@@ -24,6 +24,7 @@
 
 #include <omnetpp.h>
 #include <string.h>
+#include <algorithm>
 #include "UDPPacket.h"
 #include "UDP.h"
 #include "IPControlInfo.h"
@@ -91,6 +92,9 @@ void UDP::initialize()
     numPassedUp = 0;
     numDroppedWrongPort = 0;
     numDroppedBadChecksum = 0;
+    for (int i=0; i<NUM_PATTERNS; i++)
+        numSocketsWithPattern[i] = 0;
+    lastBindSeq = 0;
     WATCH(numSent);
     WATCH(numPassedUp);
     WATCH(numDroppedWrongPort);
@@ -111,6 +115,7 @@ void UDP::bind(int gateIndex, UDPControlInfo *ctrl)
     sd->localPort = ctrl->getSrcPort();
     sd->remotePort = ctrl->getDestPort();
     sd->interfaceId = ctrl->getInterfaceId();
+    sd->bindSeq = lastBindSeq++;
 
     if (sd->sockId==-1)
         error("sockId in BIND message not filled in");
@@ -131,6 +136,8 @@ void UDP::bind(int gateIndex, UDPControlInfo *ctrl)
     // add to socketsByPortMap
     SockDescList& list = socketsByPortMap[sd->localPort]; // create if doesn't exist
     list.push_back(sd);
+
+    addToDemuxIndex(sd);
 }
 
 void UDP::connect(int sockId, IPvXAddress addr, int port)
@@ -144,8 +151,10 @@ void UDP::connect(int sockId, IPvXAddress addr, int port)
         opp_error("connect: invalid remote port number %d", port);
 
     SockDesc *sd = it->second;
+    removeFromDemuxIndex(sd);
     sd->remoteAddr = addr;
     sd->remotePort = port;
+    addToDemuxIndex(sd);
 
     sd->onlyLocalPortIsSet = false;
 
@@ -163,6 +172,8 @@ void UDP::unbind(int sockId)
 
     EV << "Unbinding socket: " << *sd << "\n";
 
+    removeFromDemuxIndex(sd);
+
     // remove from socketsByPortMap
     SockDescList& list = socketsByPortMap[sd->localPort];
     for (SockDescList::iterator it=list.begin(); it!=list.end(); ++it)
@@ -193,6 +204,101 @@ ushort UDP::getEphemeralPort()
     return lastEphemeralPort;
 }
 
+UDP::SockKey UDP::getSockKey(const SockDesc *sd)
+{
+    SockKey key;
+    key.localAddr = sd->localAddr;
+    key.remoteAddr = sd->remoteAddr;
+    key.localPort = sd->localPort;
+    key.remotePort = sd->remotePort;
+    key.interfaceId = sd->interfaceId;
+    return key;
+}
+
+int UDP::getSockKeyPattern(const SockDesc *sd)
+{
+    return (sd->localAddr.isUnspecified() ? 0 : SPEC_LOCALADDR) |
+           (sd->remoteAddr.isUnspecified() ? 0 : SPEC_REMOTEADDR) |
+           (sd->remotePort==0 ? 0 : SPEC_REMOTEPORT) |
+           (sd->interfaceId==-1 ? 0 : SPEC_INTERFACE);
+}
+
+void UDP::addToDemuxIndex(SockDesc *sd)
+{
+    // keep the list in bind order (a connect() may bring an old socket here)
+    SockDescList& list = socketsByKeyMap[getSockKey(sd)];
+    SockDescList::iterator pos = list.end();
+    while (pos!=list.begin() && (*--pos)->bindSeq > sd->bindSeq)
+        ;
+    if (pos!=list.end() && (*pos)->bindSeq < sd->bindSeq)
+        ++pos;
+    list.insert(pos, sd);
+
+    int pattern = getSockKeyPattern(sd);
+    if (numSocketsWithPattern[pattern]++ == 0)
+        usedPatterns.push_back(pattern);
+}
+
+void UDP::removeFromDemuxIndex(SockDesc *sd)
+{
+    SocketsByKeyMap::iterator it = socketsByKeyMap.find(getSockKey(sd));
+    ASSERT(it!=socketsByKeyMap.end());
+    it->second.remove(sd);
+    if (it->second.empty())
+        socketsByKeyMap.erase(it);
+
+    int pattern = getSockKeyPattern(sd);
+    if (--numSocketsWithPattern[pattern] == 0)
+        usedPatterns.erase(std::find(usedPatterns.begin(), usedPatterns.end(), pattern));
+}
+
+static bool compareBindSeq(const UDP::SockDesc *a, const UDP::SockDesc *b)
+{
+    return a->bindSeq < b->bindSeq;
+}
+
+void UDP::findMatchingSockets(ushort localPort, const IPvXAddress& localAddr,
+        const IPvXAddress& remoteAddr, ushort remotePort, int interfaceId)
+{
+    matchingSockets.clear();
+
+    SockKey key;
+    key.localPort = localPort;
+    int numLists = 0;
+    for (unsigned int i=0; i<usedPatterns.size(); i++)
+    {
+        int pattern = usedPatterns[i];
+
+        // a socket never filters on the "any" value, so a packet field
+        // holding it cannot match that pattern (and would probe the key
+        // of a less specific one again)
+        if ((pattern & SPEC_LOCALADDR) && localAddr.isUnspecified())
+            continue;
+        if ((pattern & SPEC_REMOTEADDR) && remoteAddr.isUnspecified())
+            continue;
+        if ((pattern & SPEC_REMOTEPORT) && remotePort==0)
+            continue;
+        if ((pattern & SPEC_INTERFACE) && interfaceId==-1)
+            continue;
+
+        key.localAddr = (pattern & SPEC_LOCALADDR) ? localAddr : IPvXAddress();
+        key.remoteAddr = (pattern & SPEC_REMOTEADDR) ? remoteAddr : IPvXAddress();
+        key.remotePort = (pattern & SPEC_REMOTEPORT) ? remotePort : 0;
+        key.interfaceId = (pattern & SPEC_INTERFACE) ? interfaceId : -1;
+
+        SocketsByKeyMap::iterator it = socketsByKeyMap.find(key);
+        if (it!=socketsByKeyMap.end())
+        {
+            matchingSockets.insert(matchingSockets.end(), it->second.begin(), it->second.end());
+            numLists++;
+        }
+    }
+
+    // each list is in bind order already; only a mix of them needs sorting
+    if (numLists > 1)
+        std::sort(matchingSockets.begin(), matchingSockets.end(), compareBindSeq);
+}
+
 void UDP::handleMessage(cMessage *msg)
 {
     // received from IP layer
@@ -309,7 +415,7 @@ void UDP::processUndeliverablePacket(UDPPacket *udpPacket, cPolymorphic *ctrl)
         if (!ctrl4->getDestAddr().isMulticast())
             icmp->sendErrorMessage(udpPacket, ctrl4, ICMP_DESTINATION_UNREACHABLE, ICMP_DU_PORT_UNREACHABLE);
     }
-    else if (dynamic_cast<IPv6ControlInfo *>(udpPacket->getControlInfo())!=NULL)
+    else if (dynamic_cast<IPv6ControlInfo *>(ctrl)!=NULL)
     {
         if (!icmpv6)
             icmpv6 = ICMPv6Access().get();
@@ -431,14 +537,12 @@ void UDP::processUDPPacket(UDPPacket *udpPacket)
     cPolymorphic *ctrl = udpPacket->removeControlInfo();
 
     // send back ICMP error if no socket is bound to that port
-    SocketsByPortMap::iterator it = socketsByPortMap.find(destPort);
-    if (it==socketsByPortMap.end())
+    if (socketsByPortMap.find(destPort)==socketsByPortMap.end())
     {
         EV << "No socket registered on port " << destPort << "\n";
         processUndeliverablePacket(udpPacket, ctrl);
         return;
     }
-    SockDescList& list = it->second;
 
     int matches = 0;
 
@@ -451,29 +555,27 @@ void UDP::processUDPPacket(UDPPacket *udpPacket)
     if (dynamic_cast<IPControlInfo *>(ctrl)!=NULL)
     {
         IPControlInfo *ctrl4 = (IPControlInfo *)ctrl;
-        for (SockDescList::iterator it=list.begin(); it!=list.end(); ++it)
+        findMatchingSockets(destPort, ctrl4->getDestAddr(), ctrl4->getSrcAddr(),
+                            udpPacket->getSourcePort(), ctrl4->getInterfaceId());
+        for (unsigned int i=0; i<matchingSockets.size(); i++)
         {
-            SockDesc *sd = *it;
-            if (sd->onlyLocalPortIsSet || matchesSocket(sd, udpPacket, ctrl4))
-            {
-                EV << "Socket sockId=" << sd->sockId << " matches, sending up a copy.\n";
-                sendUp((cPacket*)payload->dup(), udpPacket, ctrl4, sd);
-                matches++;
-            }
+            SockDesc *sd = matchingSockets[i];
+            EV << "Socket sockId=" << sd->sockId << " matches, sending up a copy.\n";
+            sendUp((cPacket*)payload->dup(), udpPacket, ctrl4, sd);
+            matches++;
         }
     }
-    else if (dynamic_cast<IPv6ControlInfo *>(udpPacket->getControlInfo())!=NULL)
+    else if (dynamic_cast<IPv6ControlInfo *>(ctrl)!=NULL)
     {
         IPv6ControlInfo *ctrl6 = (IPv6ControlInfo *)ctrl;
-        for (SockDescList::iterator it=list.begin(); it!=list.end(); ++it)
+        findMatchingSockets(destPort, ctrl6->getDestAddr(), ctrl6->getSrcAddr(),
+                            udpPacket->getSourcePort(), ctrl6->getInterfaceId());
+        for (unsigned int i=0; i<matchingSockets.size(); i++)
         {
-            SockDesc *sd = *it;
-            if (sd->onlyLocalPortIsSet || matchesSocket(sd, udpPacket, ctrl6))
-            {
-                EV << "Socket sockId=" << sd->sockId << " matches, sending up a copy.\n";
-                sendUp((cPacket*)payload->dup(), udpPacket, ctrl6, sd);
-                matches++;
-            }
+            SockDesc *sd = matchingSockets[i];
+            EV << "Socket sockId=" << sd->sockId << " matches, sending up a copy.\n";
+            sendUp((cPacket*)payload->dup(), udpPacket, ctrl6, sd);
+            matches++;
         }
     }
     else
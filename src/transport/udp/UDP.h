@@ -27,6 +27,8 @@
 
 #include <map>
 #include <list>
+#include <vector>
+#include "INETHashMap.h"
 #include "UDPControlInfo_m.h"
 
 class IPControlInfo;
@@ -57,17 +59,74 @@ class INET_API UDP : public cSimpleModule
         ushort localPort;
         ushort remotePort;
         int interfaceId; // FIXME do real sockets allow filtering by input interface??
+        long bindSeq; // sockets matching the same packet get it in bind order
     };
 
     typedef std::list<SockDesc *> SockDescList;
     typedef std::map<int,SockDesc *> SocketsByIdMap;
     typedef std::map<int,SockDescList> SocketsByPortMap;
 
+    /**
+     * Demultiplexing key of a socket: the fields it filters on, with
+     * unspecified address, port 0 and interface -1 standing for "any".
+     * A packet is looked up with every combination of its own fields and
+     * "any" that some bound socket uses (see SockKeyPattern).
+     */
+    struct SockKey
+    {
+        IPvXAddress localAddr;
+        IPvXAddress remoteAddr;
+        ushort localPort;
+        ushort remotePort;
+        int interfaceId;
+
+        bool operator==(const SockKey& other) const {
+            return localPort==other.localPort && remotePort==other.remotePort &&
+                   interfaceId==other.interfaceId &&
+                   localAddr==other.localAddr && remoteAddr==other.remoteAddr;
+        }
+    };
+
+    struct SockKeyHash
+    {
+        static size_t hash(const IPvXAddress& addr) {
+            const uint32 *w = addr.words();
+            size_t h = inet_hashmix(w[0]);
+            for (int i=1; i<addr.wordCount(); i++)
+                h = inet_hashmix(h ^ w[i]);
+            return h;
+        }
+        size_t operator()(const SockKey& k) const {
+            return hash(k.localAddr) ^ inet_hashmix(hash(k.remoteAddr) + k.localPort) ^
+                   inet_hashmix(((uint32)k.remotePort << 16) ^ (uint32)k.interfaceId);
+        }
+    };
+
+    // which of the fields a socket filters on, one bit each
+    enum SockKeyPattern
+    {
+        SPEC_LOCALADDR = 1,
+        SPEC_REMOTEADDR = 2,
+        SPEC_REMOTEPORT = 4,
+        SPEC_INTERFACE = 8,
+        NUM_PATTERNS = 16
+    };
+
+    typedef std::tr1::unordered_map<SockKey, SockDescList, SockKeyHash> SocketsByKeyMap;
+
   protected:
     // sockets
     SocketsByIdMap socketsByIdMap;
     SocketsByPortMap socketsByPortMap;
 
+    // demultiplexing index: sockets by their exact key, and the number of
+    // bound sockets using each pattern, so that unused ones are not probed
+    SocketsByKeyMap socketsByKeyMap;
+    int numSocketsWithPattern[NUM_PATTERNS];
+    std::vector<int> usedPatterns;
+    long lastBindSeq;
+    std::vector<SockDesc *> matchingSockets; // scratch space of findMatchingSockets()
+
     // other state vars
     ushort lastEphemeralPort;
     ICMP *icmp;
@@ -95,6 +154,16 @@ class INET_API UDP : public cSimpleModule
     // ephemeral port
     virtual ushort getEphemeralPort();
 
+    // maintain the demultiplexing index
+    virtual void addToDemuxIndex(SockDesc *sd);
+    virtual void removeFromDemuxIndex(SockDesc *sd);
+    static SockKey getSockKey(const SockDesc *sd);
+    static int getSockKeyPattern(const SockDesc *sd);
+
+    // collects the sockets a packet should be delivered to, in bind order
+    virtual void findMatchingSockets(ushort localPort, const IPvXAddress& localAddr,
+            const IPvXAddress& remoteAddr, ushort remotePort, int interfaceId);
+
     virtual bool matchesSocket(SockDesc *sd, UDPPacket *udp, IPControlInfo *ctrl);
     virtual bool matchesSocket(SockDesc *sd, UDPPacket *udp, IPv6ControlInfo *ctrl);
     virtual bool matchesSocket(SockDesc *sd, const IPvXAddress& localAddr, const IPvXAddress& remoteAddr, ushort remotePort);
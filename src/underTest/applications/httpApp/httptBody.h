@@ -0,0 +1,99 @@
+
+// ***************************************************************************
+// 
+// HttpTools Project
+//
+// This file is a part of the HttpTools project. The project was created at
+// Reykjavik University, the Laboratory for Dependable Secure Systems (LDSS).
+// Its purpose is to create a set of OMNeT++ components to simulate browsing
+// behaviour in a high-fidelity manner along with a highly configurable 
+// Web server component.
+//
+// Maintainer: Kristjan V. Jonsson (LDSS) kristjanvj@gmail.com
+// Project home page: code.google.com/p/omnet-httptools
+//
+// ***************************************************************************
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License version 3
+// as published by the Free Software Foundation.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+//
+
+#ifndef __httptBody_H_
+#define __httptBody_H_
+
+#include <string>
+#include <iostream>
+#include <omnetpp.h>
+
+/**
+ * @brief Immutable, reference counted message body.
+ *
+ * Reply messages refer to their page body instead of holding a copy of it, so
+ * duplicating a message (e.g. in the TCP model) or serving the same page again
+ * does not copy the text. Generated pages with the same content share one
+ * interned body, see httptServerBase::generateBody().
+ *
+ * @version 1.0
+ */
+class httptBody
+{
+	private:
+		struct Rep
+		{
+			std::string text;
+			int refs;
+			Rep(const std::string &text) : text(text), refs(1) {}
+		};
+		Rep *rep;
+
+		void release() { if ( rep!=NULL && --rep->refs==0 ) delete rep; rep=NULL; }
+
+	public:
+		httptBody() : rep(NULL) {}
+		explicit httptBody( const std::string &text ) : rep(new Rep(text)) {}
+		httptBody( const httptBody &other ) : rep(other.rep) { if ( rep!=NULL ) rep->refs++; }
+		~httptBody() { release(); }
+
+		httptBody& operator=( const httptBody &other )
+		{
+			if ( other.rep!=NULL ) other.rep->refs++;
+			release();
+			rep = other.rep;
+			return *this;
+		}
+
+		/** The body text; empty if no body is set */
+		const char* c_str() const { return rep!=NULL ? rep->text.c_str() : ""; }
+		size_t size() const { return rep!=NULL ? rep->text.size() : 0; }
+		bool empty() const { return size()==0; }
+};
+
+inline std::ostream& operator<<( std::ostream &os, const httptBody &body )
+{
+	return os << body.c_str();
+}
+
+inline void doPacking( cCommBuffer *buffer, httptBody &body )
+{
+	buffer->pack(body.c_str());
+}
+
+inline void doUnpacking( cCommBuffer *buffer, httptBody &body )
+{
+	char *text;
+	buffer->unpack(text);
+	body = httptBody(std::string(text!=NULL ? text : ""));
+	delete [] text;
+}
+
+#endif
@@ -296,9 +296,9 @@ void httptBrowserBase::handleDataMessage( cMessage *msg )
 		{
 			case rt_html_page:
 				EV_INFO << "HTML Document received: " << appmsg->getName() << "'. Size is " << appmsg->getByteLength() << " bytes and serial " << serial << endl;
-				if ( strlen(appmsg->payload()) != 0 )
-					EV_DEBUG << "Payload of " << appmsg->getName() << " is: " << endl << appmsg->payload()
-							 << ", " << strlen(appmsg->payload()) << " bytes" << endl;
+				if ( !appmsg->payload().empty() )
+					EV_DEBUG << "Payload of " << appmsg->getName() << " is: " << endl << appmsg->payload().c_str()
+							 << ", " << appmsg->payload().size() << " bytes" << endl;
 				else
 					EV_DEBUG << appmsg->getName() << " has no referenced resources. No GETs will be issued in parsing" << endl;
 				htmlReceived++;
@@ -321,10 +321,10 @@ void httptBrowserBase::handleDataMessage( cMessage *msg )
 		}
 
 		// Parse the html page body
-		if ( (CONTENT_TYPE_ENUM)appmsg->contentType() == rt_html_page && strlen(appmsg->payload()) != 0 )
+		if ( (CONTENT_TYPE_ENUM)appmsg->contentType() == rt_html_page && !appmsg->payload().empty() )
 		{
 			EV_DEBUG << "Processing HTML document body:\n";
-			cStringTokenizer lineTokenizer( (const char*)appmsg->payload(), "\n" );
+			cStringTokenizer lineTokenizer( appmsg->payload().c_str(), "\n" );
 			std::vector<string> lines = lineTokenizer.asVector();
 			int serial=0;
 			string providerName = "";
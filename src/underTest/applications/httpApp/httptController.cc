@@ -57,6 +57,7 @@ void httptController::initialize(int stage)
 
 		pspecial = 0.0;	// No special events by defaault
 		totalLookups = 0;
+		activeSitesValid = false;
 	}
 	else if ( stage==1 )
 	{
@@ -141,6 +142,7 @@ void httptController::registerWWWserver( const char* objectName, const char* www
 		error("Server %s does not have a WWW module", wwwName);
 
 	webSiteList[en->name] = en;
+	activeSitesValid = false;
 
 	int pos;
 	vector<WEB_SERVER_ENTRY*>::iterator begin = pickList.begin();
@@ -152,8 +154,11 @@ void httptController::registerWWWserver( const char* objectName, const char* www
 		}
 		else
 		{
+			// Take over a random position and move its entry to the end instead of shifting
+			// the rest of the list. Repeated, this still yields a random order.
 			pos = (int)uniform(0,pickList.size()-1);
-			pickList.insert(begin+pos,en);
+			pickList.push_back(pickList[pos]);
+			pickList[pos] = en;
 		}
 	}
 	else if ( rank==INSERT_MIDDLE )
@@ -497,10 +502,61 @@ void httptController::parseOptionsFile(string file, string section)
 	tracefilestream.close();
 }
 
+bool httptController::__rebuildActiveSites()
+{
+	DISTR_TYPE type = rdServerSelection->getType();
+	if ( type!=dt_uniform && type!=dt_zipf )
+		return false;
+
+	activeSites.clear();
+	vector<double> weights;
+	nextActivationTime = MAXTIME;
+	for ( unsigned int i=0; i<pickList.size(); i++ )
+	{
+		WEB_SERVER_ENTRY *en = pickList[i];
+		if ( en->activationTime>simTime() )
+		{
+			if ( en->activationTime<nextActivationTime )
+				nextActivationTime = en->activationTime;
+			continue;
+		}
+		double p = type==dt_uniform ? ((rdUniform*)rdServerSelection)->getProbability(i)
+									: ((rdZipf*)rdServerSelection)->getProbability(i);
+		if ( p<=0.0 ) continue;
+		activeSites.push_back(en);
+		weights.push_back(p);
+	}
+	activeSiteTable.build(weights);
+	activeSitesValid = true;
+
+	EV_DEBUG << "Rebuilt the site selection table: " << activeSites.size() << " of " << pickList.size()
+			 << " sites active, next activation at " << nextActivationTime << endl;
+	return true;
+}
+
 WEB_SERVER_ENTRY* httptController::__getRandomServerInfo()
 {
 	WEB_SERVER_ENTRY* en;
 	int selected = 0;
+
+	// Uniform and zipf popularity: sample the active sites directly. The table is only
+	// rebuilt when sites are registered or activated.
+	if ( (activeSitesValid && simTime()<nextActivationTime) || __rebuildActiveSites() )
+	{
+		if (pspecial>0.0 && bernoulli(pspecial))
+		{
+			en = selectFromSpecialList();
+			EV_DEBUG << "Selecting from special list. Got node " << en->name << endl;
+			if ( en->activationTime<=simTime() )
+				return en;
+		}
+		if ( activeSites.size()==0 )
+			error("No active servers to select from");
+		en = activeSites[activeSiteTable.get()];
+		EV_DEBUG << "Selecting from normal list. Got node " << en->name << endl;
+		return en;
+	}
+
 	// @todo Reimplement! This is a ugly hack to enable easy activation of servers - can lead to problems if no servers active!!!
 	do
 	{
@@ -95,6 +95,11 @@ class httptController : public cSimpleModule
 
 		unsigned long totalLookups;		//> A counter for the total number of lookups
 
+		vector<WEB_SERVER_ENTRY*> activeSites;	//> The sites of the picklist which have been activated.
+		rdAliasTable activeSiteTable;			//> Samples activeSites according to the popularity distribution.
+		simtime_t nextActivationTime;			//> When the next site is activated and the table has to be rebuilt.
+		bool activeSitesValid;					//> False if the picklist has changed since the table was built.
+
 		rdObject *rdServerSelection;	//> The random object for the server selection.
 
 	/** @name cSimpleModule redefinitions */
@@ -194,6 +199,12 @@ class httptController : public cSimpleModule
 	private:
 		/** @brief Get a random server from the special list with p=pspecial or from the general population with p=1-pspecial. */
 		WEB_SERVER_ENTRY* __getRandomServerInfo();
+
+		/**
+		 * @brief Rebuild the alias table over the active sites of the picklist.
+		 * Returns false if the popularity distribution does not map to picklist positions (only uniform and zipf do).
+		 */
+		bool __rebuildActiveSites();
 };
 
 #endif /* httptController */
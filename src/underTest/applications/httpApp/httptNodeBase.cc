@@ -199,7 +199,7 @@ string httptNodeBase::formatHttpResponseLong( const httptReplyMessage* httpRespo
 	if ( m_bDisplayResponseContent )
 	{
 		str << "CONTENT:" << endl;
-		str << httpResponse->payload() << endl;
+		str << httpResponse->payload().c_str() << endl;
 	}
 
 	return str.str();
@@ -28,6 +28,7 @@
 //
 // ***************************************************************************
 
+#include <algorithm>
 #include "httptRandom.h"
 
 string rdObject::typeStr()
@@ -108,6 +109,13 @@ double rdUniform::get()
 	return uniform(m_beginning,m_end);
 }
 
+double rdUniform::getProbability(int value)
+{
+	if ( m_end<=m_beginning ) return 0.0;
+	double overlap = min((double)value+1,m_end)-max((double)value,m_beginning);
+	return overlap>0.0 ? overlap/(m_end-m_beginning) : 0.0;
+}
+
 rdExponential::rdExponential( double mean )
 {
 	m_type=dt_exponential;
@@ -307,6 +315,13 @@ double rdZipf::get()
 	else return i;
 }
 
+double rdZipf::getProbability(int value)
+{
+	int rank = m_baseZero ? value+1 : value;
+	if ( rank<1 || rank>m_number ) return 0.0;
+	return m_c / pow((double) rank, m_alpha);
+}
+
 string rdZipf::toString()
 {
 	ostringstream str;
@@ -333,6 +348,52 @@ void rdZipf::__setup_c()
 	m_c = 1.0 / m_c;
 }
 
+void rdAliasTable::build(const vector<double> &weights)
+{
+	int n = weights.size();
+	m_prob.assign(n,0.0);
+	m_alias.assign(n,0);
+	if ( n==0 ) return;
+
+	double sum = 0.0;
+	for ( int i=0; i<n; i++ )
+		sum += weights[i];
+
+	// Scale to an average of 1 and pair up the columns below and above the average
+	vector<double> scaled(n);
+	vector<int> small, large;
+	for ( int i=0; i<n; i++ )
+	{
+		scaled[i] = sum>0.0 ? weights[i]*n/sum : 1.0;
+		if ( scaled[i]<1.0 ) small.push_back(i);
+		else large.push_back(i);
+	}
+	while ( !small.empty() && !large.empty() )
+	{
+		int s = small.back(); small.pop_back();
+		int l = large.back();
+		m_prob[s] = scaled[s];
+		m_alias[s] = l;
+		scaled[l] -= 1.0-scaled[s];
+		if ( scaled[l]<1.0 )
+		{
+			large.pop_back();
+			small.push_back(l);
+		}
+	}
+	// Whatever is left is at the average, up to rounding
+	for ( unsigned int i=0; i<large.size(); i++ )
+		m_prob[large[i]] = 1.0;
+	for ( unsigned int i=0; i<small.size(); i++ )
+		m_prob[small[i]] = 1.0;
+}
+
+int rdAliasTable::get()
+{
+	int column = intuniform(0,m_prob.size()-1);
+	return uniform(0,1)<m_prob[column] ? column : m_alias[column];
+}
+
 rdObject* rdObjectFactory::create( cXMLAttributeMap attributes )
 {
 	string typeName = attributes["type"];
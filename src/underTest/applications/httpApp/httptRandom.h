@@ -108,6 +108,8 @@ class rdUniform : public rdObject
 		rdUniform(cXMLAttributeMap attributes);
 		/** Get a random value */
 		virtual double get();
+		/** Probability that the integer part of a random value is the given value */
+		double getProbability(int value);
 		// Getters and setters
 		double getBeginning() {return m_beginning;}
 		void setBeginning(double beginning) {m_beginning=beginning;}
@@ -208,6 +210,8 @@ class rdZipf : public rdObject
 	public:
 		/** Get a random value -- a element in the pick order (popularity order) */
 		virtual double get();
+		/** Probability of getting the given value */
+		double getProbability(int value);
 		/** Return the object definition as a string */
 		virtual string toString();
 		// Getters and setters
@@ -221,6 +225,25 @@ class rdZipf : public rdObject
 		void __setup_c();
 };
 
+/**
+ * @brief Alias table for sampling a discrete distribution.
+ * Walker's alias method: returns index i with probability proportional to the i-th weight
+ * in constant time, after a setup linear in the number of weights.
+ */
+class rdAliasTable
+{
+	protected:
+		vector<double> m_prob;	//> Probability of keeping the column drawn
+		vector<int> m_alias;	//> The alternative of each column
+	public:
+		/** Set up the table for the given weights, which need not be normalized */
+		void build(const vector<double> &weights);
+		/** Get a random index. The table must not be empty. */
+		int get();
+		/** The number of weights the table was built for */
+		int size() {return m_prob.size();}
+};
+
 /**
  * @brief A factory class used to construct random distribution objects based on XML elements.
  * The type name is used to instantiate the appropriate rdObject-derived class.
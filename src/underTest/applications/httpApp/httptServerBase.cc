@@ -294,12 +294,12 @@ httptReplyMessage* httptServerBase::generateDocument( httptRequestMessage *reque
 
 	if ( scriptedMode )
 	{
-		replymsg->setPayload(htmlPages[resource].body.c_str());
+		replymsg->setPayload(htmlPages[resource].body);
 		size = htmlPages[resource].size;
 	}
 	else
 	{
-		replymsg->setPayload(generateBody().c_str());
+		replymsg->setPayload(generateBody());
 	}
 
 	if ( size==0 )
@@ -360,12 +360,21 @@ httptReplyMessage* httptServerBase::generateErrorReply( httptRequestMessage *req
 	return replymsg;
 }
 
-string httptServerBase::generateBody()
+map<pair<int,int>,httptBody> httptServerBase::generatedBodies;
+
+httptBody httptServerBase::generateBody()
 {
 	int numResources = (int)rdNumResources->get();
 	int numImages = (int)(numResources*rdTextImageResourceRatio->get());
 	int numText = numResources - numImages;
 
+	// The body only depends on the resource counts -- build each variant once
+	// and share it between all servers and reply messages
+	pair<int,int> key(numImages,numText);
+	map<pair<int,int>,httptBody>::iterator it = generatedBodies.find(key);
+	if ( it!=generatedBodies.end() )
+		return it->second;
+
 	string result;
 
 	char tempBuf[128];
@@ -380,7 +389,7 @@ string httptServerBase::generateBody()
 		result.append(tempBuf);
 	}
 
-	return result;
+	return generatedBodies[key] = httptBody(result);
 }
 
 void httptServerBase::registerWithController()
@@ -463,7 +472,7 @@ void httptServerBase::readSiteDefinition(string file)
 				}
 				EV_DEBUG << "Adding html page definition " << key << ". The page size is " << size << endl;
 				htmlPages[key].size=size;
-				htmlPages[key].body=body;
+				htmlPages[key].body=httptBody(body);
 			}
 			else if ( resourceSection )
 			{
@@ -34,6 +34,7 @@
 #include <string>
 #include <vector>
 #include "httptNodeBase.h"
+#include "httptBody.h"
 
 // Event message kinds
 #define MSGKIND_START_SESSION 0
@@ -53,7 +54,7 @@ using namespace std;
 struct SITE_DEF_STRUCT
 {
 	long size;
-	string body;
+	httptBody body;
 };
 
 /**
@@ -104,6 +105,9 @@ class INET_API httptServerBase : public httptNodeBase
 		/** The activation time of the server -- initial startup delay. */
 		simtime_t activationTime;
 
+		/** Interned bodies of generated pages, keyed by the number of images and text resources. */
+		static map<pair<int,int>,httptBody> generatedBodies;
+
 	/** @name cSimpleModule redefinitions */
 	//@{
 	protected:
@@ -130,7 +134,7 @@ class INET_API httptServerBase : public httptNodeBase
 		/** Generate a error reply in case of invalid resource requests. */
 		httptReplyMessage* generateErrorReply( httptRequestMessage *request, int code );
 		/** Create a random body according to the site content random distributions. */
-		virtual string generateBody();
+		virtual httptBody generateBody();
 
 	protected:
 		/** Handle a received data message, e.g. check if the content requested exists. */
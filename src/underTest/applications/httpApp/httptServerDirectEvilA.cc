@@ -43,7 +43,7 @@ void httptServerDirectEvilA::initialize()
 	EV_INFO << "Minimum " << badLow << " and maximum " << badHigh << " bad requests for each hit." << endl;
 }
 
-std::string httptServerDirectEvilA::generateBody()
+httptBody httptServerDirectEvilA::generateBody()
 {
 	int numImages = badLow+(int)uniform(0,badHigh-badLow);
 	double rndDelay;
@@ -57,7 +57,7 @@ std::string httptServerDirectEvilA::generateBody()
 		result.append(tempBuf);
 	}
 
-	return result;
+	return httptBody(result);
 }
 
 
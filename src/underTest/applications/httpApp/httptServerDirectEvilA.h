@@ -57,7 +57,7 @@ class INET_API httptServerDirectEvilA : public httptServerDirect
 		int badHigh;
 	protected:
 		virtual void initialize();
-		virtual string generateBody();
+		virtual httptBody generateBody();
 };
 
 #endif /* httptServerDirectEvilA */
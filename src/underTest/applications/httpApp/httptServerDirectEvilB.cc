@@ -44,7 +44,7 @@ void httptServerDirectEvilB::initialize()
 	EV_INFO << "Minimum " << badLow << " and maximum " << badHigh << " bad requests for each hit." << endl;
 }
 
-std::string httptServerDirectEvilB::generateBody()
+httptBody httptServerDirectEvilB::generateBody()
 {
 	int numResources = badLow+(int)uniform(0,badHigh-badLow);
 	double rndDelay;
@@ -60,7 +60,7 @@ std::string httptServerDirectEvilB::generateBody()
 		result.append(tempBuf);
 	}
 
-	return result;
+	return httptBody(result);
 }
 
 
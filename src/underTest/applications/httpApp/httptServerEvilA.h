@@ -59,7 +59,7 @@ class INET_API httptServerEvilA : public httptServer
 		int badHigh;
 	protected:
 		virtual void initialize();
-		virtual string generateBody();
+		virtual httptBody generateBody();
 };
 
 #endif /* httptServerEvilA */
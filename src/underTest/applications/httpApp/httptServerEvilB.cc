@@ -44,7 +44,7 @@ void httptServerEvilB::initialize()
 	EV_INFO << "Minimum " << badLow << " and maximum " << badHigh << " bad requests for each hit." << endl;
 }
 
-std::string httptServerEvilB::generateBody()
+httptBody httptServerEvilB::generateBody()
 {
 	int numResources = badLow+(int)uniform(0,badHigh-badLow);
 	double rndDelay;
@@ -60,7 +60,7 @@ std::string httptServerEvilB::generateBody()
 		result.append(tempBuf);
 	}
 
-	return result;
+	return httptBody(result);
 }
 
 
@@ -2205,6 +2205,8 @@ void ControlPlaneMobilestation::handleCorrectDLMAP(cMessage *msg)
     Ieee80216DL_MAP *frame = check_and_cast<Ieee80216DL_MAP *>(msg);
     //if(frame->getBS_ID() == localMobilestationInfo.activeBasestation)
     getCalculateSNR(msg);
+    // the uplink to the serving BS is assumed to be as good as its downlink
+    cps_scheduling->setModulation(modulationForSNR(frame->getSNR()));
     EV << "Basisstation MAC:" << frame->getBS_ID() << ".\n";
     recordData(msg);
 
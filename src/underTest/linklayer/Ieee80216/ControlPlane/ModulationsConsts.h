@@ -18,4 +18,36 @@ const double QAM162_SNR = 18.2; // 16-QAM 3/4
 const double QAM641_SNR = 22.7; // 64-QAM 1/2
 const double QAM642_SNR = 24.4; // 64-QAM 3/4
 
+/** Modulations in order of increasing datarate */
+enum modulations
+{
+    MOD_QPSK1,
+    MOD_QPSK2,
+    MOD_QAM161,
+    MOD_QAM162,
+    MOD_QAM641,
+    MOD_QAM642,
+    NUM_MODULATIONS
+};
+
+const int MODULATION_DATENRATE[NUM_MODULATIONS] =
+{
+    QPSK1_DATENRATE, QPSK2_DATENRATE, QAM161_DATENRATE,
+    QAM162_DATENRATE, QAM641_DATENRATE, QAM642_DATENRATE
+};
+
+const double MODULATION_SNR[NUM_MODULATIONS] =
+{
+    QPSK1_SNR, QPSK2_SNR, QAM161_SNR, QAM162_SNR, QAM641_SNR, QAM642_SNR
+};
+
+/** Fastest modulation usable at the given SNR (in dB); QPSK 1/2 below all thresholds */
+inline modulations modulationForSNR(double snr)
+{
+    int m = NUM_MODULATIONS - 1;
+    while (m > MOD_QPSK1 && snr < MODULATION_SNR[m])
+        m--;
+    return (modulations) m;
+}
+
 #endif
@@ -5,10 +5,18 @@ Define_Module(CommonPartSublayerScheduling);
 
 CommonPartSublayerScheduling::CommonPartSublayerScheduling()
 {
+    flowScheduler = NULL;
 }
 
 CommonPartSublayerScheduling::~CommonPartSublayerScheduling()
 {
+    for (ServiceFlowMap::iterator it = flows.begin(); it != flows.end(); ++it)
+    {
+        for (unsigned int i = 0; i < it->second->packets.size(); i++)
+            delete it->second->packets[i];
+        delete it->second;
+    }
+    delete flowScheduler;
 }
 
 void CommonPartSublayerScheduling::initialize()
@@ -28,6 +36,20 @@ void CommonPartSublayerScheduling::initialize()
 
     max_data_to_send = 128;
 
+    double weights[5];
+    weights[pUGS] = weight_ugs_par;
+    weights[pRTPS] = weight_rtps_par;
+    weights[pERTPS] = weight_ertps_par;
+    weights[pNRTPS] = weight_nrtps_par;
+    weights[pBE] = weight_be_par;
+
+    flowQueueLimit = par("flow_queue_limit");
+    linkModulation = MOD_QPSK1;
+    if (scheduler == "DRR")
+        flowScheduler = new DeficitRoundRobinScheduler(par("drr_quantum"), weights);
+    else if (scheduler == "PF")
+        flowScheduler = new ProportionalFairScheduler(par("pf_time_constant"));
+
     cvec_fifo.setName("Scheduled FIFO Traffic"); // Output-Vektoren zum Aufzeichnen der TG-Daten
     cvec_ugs.setName("Scheduled UGS Traffic");
     cvec_rtps.setName("Scheduled rtPS Traffic");
@@ -45,6 +67,15 @@ void CommonPartSublayerScheduling::initialize()
 // per_second_timer = new cMessage("per_second_timer");
 // scheduleAt(simTime(), per_second_timer);
 
+    numSchedulerRuns = 0;
+    numScheduledPackets = 0;
+    numDroppedPackets = 0;
+    for (int i = pUGS; i <= pBE; i++)
+        scheduledBytes[i] = 0;
+    WATCH(numSchedulerRuns);
+    WATCH(numScheduledPackets);
+    WATCH(numDroppedPackets);
+
     updateDisplay();            // GUI wird aktualisiert: Füllstand der Queues, Formatierung...
 }
 
@@ -60,6 +91,21 @@ void CommonPartSublayerScheduling::finish()
     recordScalar("WRR weight ERTPS", weight_ertps_par);
     recordScalar("WRR weight NRTPS", weight_nrtps_par);
     recordScalar("WRR weight BE", weight_be_par); //schreiben auf HDD
+
+    double totalBytes = 0;
+    for (int i = pUGS; i <= pBE; i++)
+        totalBytes += scheduledBytes[i];
+
+    recordScalar("scheduler runs", numSchedulerRuns);
+    recordScalar("scheduled packets", numScheduledPackets);
+    recordScalar("dropped packets", numDroppedPackets);
+    recordScalar("scheduled bytes UGS", scheduledBytes[pUGS]);
+    recordScalar("scheduled bytes RTPS", scheduledBytes[pRTPS]);
+    recordScalar("scheduled bytes ERTPS", scheduledBytes[pERTPS]);
+    recordScalar("scheduled bytes NRTPS", scheduledBytes[pNRTPS]);
+    recordScalar("scheduled bytes BE", scheduledBytes[pBE]);
+    if (simTime() > 0)
+        recordScalar("throughput (bit/s)", totalBytes * 8 / simTime().dbl());
 }                               //ggf. können die records gelöscht werden....werden nicht weiter verwendet.
 
 void CommonPartSublayerScheduling::handleMessage(cMessage *msg)
@@ -90,10 +136,19 @@ void CommonPartSublayerScheduling::handleMessage(cMessage *msg)
         Ieee80216TGControlInformation* ipd_control =
             check_and_cast<Ieee80216TGControlInformation*>(upper_ipd->getControlInfo());
 
-        if (scheduler == "FIFO")
+        if (flowScheduler)
+        {
+            // the packet itself is queued, not a copy
+            enqueueOnFlow(upper_msg, ipd_control->getTraffic_type());
+            updateDisplay();
+            return;
+        }
+        else if (scheduler == "FIFO")
         {
             if (queue_fifo.size() < 3000)
                 queue_fifo.push_back(*upper_msg);
+            else
+                numDroppedPackets++;
         }
         else if (scheduler == "WRR" || scheduler == "APQ")
         {
@@ -102,26 +157,36 @@ void CommonPartSublayerScheduling::handleMessage(cMessage *msg)
             case UGS:
                 if (queue_ugs.size() < 500) // Queue  Size hardcoded here. Maybe .ini is a better place for this
                     queue_ugs.push_back(*upper_msg);
+                else
+                    numDroppedPackets++;
                 break;
 
             case RTPS:
                 if (queue_rtps.size() < 500)
                     queue_rtps.push_back(*upper_msg);
+                else
+                    numDroppedPackets++;
                 break;
 
             case ERTPS:
                 if (queue_ertps.size() < 500)
                     queue_ertps.push_back(*upper_msg);
+                else
+                    numDroppedPackets++;
                 break;
 
             case NRTPS:
                 if (queue_nrtps.size() < 500)
                     queue_nrtps.push_back(*upper_msg);
+                else
+                    numDroppedPackets++;
                 break;
 
             case BE:
                 if (queue_be.size() < 500)
                     queue_be.push_back(*upper_msg);
+                else
+                    numDroppedPackets++;
                 break;
             }
         }
@@ -157,7 +222,11 @@ void CommonPartSublayerScheduling::sendPacketsDown(int burst_capacity)
     //sum_fifo = 0;
     sums[pUGS] = sums[pRTPS] = sums[pERTPS] = sums[pNRTPS] = sums[pBE] = 0;
 
-    if (scheduler == "FIFO")
+    if (flowScheduler)
+    {
+        doFlowScheduling(burst_capacity);
+    }
+    else if (scheduler == "FIFO")
     {
         doFIFOQueuing(burst_capacity);
     }
@@ -189,6 +258,10 @@ void CommonPartSublayerScheduling::sendPacketsDown(int burst_capacity)
     cvec_nrtps.record(sums[pNRTPS]);
     cvec_sum_be.record(sums[pBE]);
 
+    numSchedulerRuns++;
+    for (int i = pUGS; i <= pBE; i++)
+        scheduledBytes[i] += sums[i];
+
     updateDisplay();
 }
 
@@ -459,8 +532,86 @@ void CommonPartSublayerScheduling::doAbsolutePriorityQueuing(int max_burst_size,
     */
 }
 
+void CommonPartSublayerScheduling::enqueueOnFlow(Ieee80216GenericMacHeader *msg, int traffic_type)
+{
+    priorities priority;
+    switch (traffic_type)
+    {
+    case UGS:
+        priority = pUGS;
+        break;
+    case RTPS:
+        priority = pRTPS;
+        break;
+    case ERTPS:
+        priority = pERTPS;
+        break;
+    case NRTPS:
+        priority = pNRTPS;
+        break;
+    default:
+        priority = pBE;
+        break;
+    }
+
+    ServiceFlowMap::iterator it = flows.find(msg->getCID());
+    if (it == flows.end())
+    {
+        it = flows.insert(std::make_pair(msg->getCID(), new ServiceFlowQueue(msg->getCID(), priority))).first;
+        flowScheduler->setModulation(it->second, linkModulation);
+    }
+    ServiceFlowQueue *flow = it->second;
+
+    if ((int) flow->packets.size() >= flowQueueLimit)
+    {
+        numDroppedPackets++;
+        delete msg;
+        return;
+    }
+
+    flow->packets.push_back(msg);
+    if (flow->packets.size() == 1)
+        flowScheduler->flowBacklogged(flow);
+}
+
+void CommonPartSublayerScheduling::doFlowScheduling(int max_burst_size)
+{
+    burst.clear();
+    flowScheduler->fillBurst(max_burst_size, burst);
+
+    for (unsigned int i = 0; i < burst.size(); i++)
+    {
+        Ieee80216GenericMacHeader *msg = burst[i];
+        priorities priority = flows[msg->getCID()]->priority;
+
+        sums[priority] += msg->getByteLength();
+
+        cMsgPar* prio = new cMsgPar();
+        prio->setName("priority");
+        prio->setDoubleValue(priority);
+        msg->addPar(prio);
+
+        sendDown(msg);
+    }
+}
+
+void CommonPartSublayerScheduling::setModulation(modulations modulation)
+{
+    Enter_Method_Silent();
+
+    if (modulation == linkModulation)
+        return;
+
+    EV << "Link modulation changed from " << linkModulation << " to " << modulation << "\n";
+    linkModulation = modulation;
+    if (flowScheduler)
+        for (ServiceFlowMap::iterator it = flows.begin(); it != flows.end(); ++it)
+            flowScheduler->setModulation(it->second, modulation);
+}
+
 void CommonPartSublayerScheduling::sendDown(Ieee80216GenericMacHeader* msg)
 {
+    numScheduledPackets++;
     send(msg, commonPartGateOut);
 }
 
@@ -468,7 +619,12 @@ void CommonPartSublayerScheduling::updateDisplay()
 {
     char buf[90];
 
-    if (scheduler == "FIFO")
+    if (flowScheduler)
+    {
+        sprintf(buf, "%s\nService flows: %d\nBacklogged: %d", scheduler.c_str(),
+                (int) (flows.size()), flowScheduler->getNumBacklogged());
+    }
+    else if (scheduler == "FIFO")
     {
         sprintf(buf, "FIFO Queue: %d", (int) (queue_fifo.size()));
     }
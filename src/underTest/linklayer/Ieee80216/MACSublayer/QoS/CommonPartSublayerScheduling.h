@@ -10,6 +10,8 @@
 #include "Ieee80216ManagementMessages_m.h"
 #include "Ieee80216Primitives_m.h"
 #include "global_enums.h"
+#include "INETHashMap.h"
+#include "WorkConservingScheduler.h"
 
 #include <list>
 using namespace std;
@@ -30,6 +32,14 @@ class CommonPartSublayerScheduling : public cSimpleModule
     list<Ieee80216GenericMacHeader> queue_ugs, queue_rtps, queue_ertps, queue_nrtps, queue_be;
     list<Ieee80216GenericMacHeader> queue_fifo;
 
+    // Per service flow queues for the DRR and PF schedulers
+    typedef std::tr1::unordered_map<int, ServiceFlowQueue *> ServiceFlowMap;
+    ServiceFlowMap flows;
+    WorkConservingScheduler *flowScheduler;
+    int flowQueueLimit;
+    modulations linkModulation;
+    std::vector<Ieee80216GenericMacHeader *> burst;
+
     double weight_ugs_par, weight_rtps_par, weight_ertps_par, weight_nrtps_par, weight_be_par;
 
     int max_data_to_send;
@@ -48,6 +58,12 @@ class CommonPartSublayerScheduling : public cSimpleModule
     cOutVector cvec_fifo_perSecond, cvec_ugs_perSecond, cvec_rtps_perSecond, cvec_ertps_perSecond,
         cvec_nrtps_perSecond, cvec_sum_be_perSecond;
 
+    // statistics
+    long numSchedulerRuns;
+    long numScheduledPackets;
+    long numDroppedPackets;
+    double scheduledBytes[5];
+
     bool equal_weights_for_wrr;
 
     /**
@@ -64,6 +80,8 @@ class CommonPartSublayerScheduling : public cSimpleModule
     void doFIFOQueuing(int max_burst_size);
     void doWeightedRoundRobin(int max_burst_size, int *scheduled_packets_size, bool equal_weights);
     void doAbsolutePriorityQueuing(int max_burst_size, int *scheduled_packets_size);
+    void doFlowScheduling(int max_burst_size);
+    void enqueueOnFlow(Ieee80216GenericMacHeader *msg, int traffic_type);
 
     void updateDisplay();
 
@@ -75,6 +93,13 @@ class CommonPartSublayerScheduling : public cSimpleModule
 //    void setNumberOfConnectedStations( int stations );
     void sendPacketsDown(int burst_capacity);
 
+    /**
+     * Sets the modulation of the link the connections of this station are
+     * sent on; the DRR and PF schedulers account for its burst capacity
+     * accordingly.
+     */
+    void setModulation(modulations modulation);
+
   protected:
     void initialize();
     void finish();
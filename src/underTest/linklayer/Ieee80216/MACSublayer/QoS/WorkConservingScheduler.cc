@@ -0,0 +1,125 @@
+#include "WorkConservingScheduler.h"
+
+WorkConservingScheduler::WorkConservingScheduler()
+{
+    // a byte sent on a faster modulation takes proportionally less of the burst
+    for (int m = 0; m < NUM_MODULATIONS; m++)
+        costPerKByte[m] = (int) ((1024.0 * MODULATION_DATENRATE[MOD_QPSK1] + MODULATION_DATENRATE[m] - 1) / MODULATION_DATENRATE[m]);
+}
+
+DeficitRoundRobinScheduler::DeficitRoundRobinScheduler(int baseQuantum, const double weights[5])
+{
+    if (baseQuantum <= 0)
+        opp_error("DRR quantum must be positive");
+    for (int priority = pUGS; priority <= pBE; priority++)
+        quantum[priority] = baseQuantum * (weights[priority] >= 1 ? (int) weights[priority] : 1);
+}
+
+void DeficitRoundRobinScheduler::flowBacklogged(ServiceFlowQueue *flow)
+{
+    flow->deficit = 0;
+    flow->credited = false;
+    activeFlows.push_back(flow);
+}
+
+void DeficitRoundRobinScheduler::fillBurst(int capacity, std::vector<Ieee80216GenericMacHeader *>& burst)
+{
+    while (!activeFlows.empty())
+    {
+        ServiceFlowQueue *flow = activeFlows.front();
+        if (!flow->credited)
+        {
+            flow->deficit += quantum[flow->priority];
+            flow->credited = true;
+        }
+
+        while (!flow->packets.empty())
+        {
+            int cost = burstCost(flow, flow->packets.front()->getByteLength());
+            if (cost > capacity)
+                return; // burst is full; the flow keeps its turn and deficit
+            if (cost > flow->deficit)
+                break;
+            flow->deficit -= cost;
+            capacity -= cost;
+            burst.push_back(flow->packets.front());
+            flow->packets.pop_front();
+        }
+
+        activeFlows.pop_front();
+        flow->credited = false;
+        if (flow->packets.empty())
+            flow->deficit = 0;
+        else
+            activeFlows.push_back(flow);
+    }
+}
+
+ProportionalFairScheduler::ProportionalFairScheduler(double timeConstant)
+{
+    if (timeConstant < 1)
+        opp_error("PF time constant must be at least one burst");
+    beta = 1.0 / timeConstant;
+    scale = 1;
+}
+
+void ProportionalFairScheduler::rank(ServiceFlowQueue *flow)
+{
+    // the flow with the lowest average throughput per datarate goes first
+    flow->rank = flow->served / MODULATION_DATENRATE[flow->modulation];
+    ranking.insert(std::make_pair(flow->rank, flow));
+}
+
+void ProportionalFairScheduler::flowBacklogged(ServiceFlowQueue *flow)
+{
+    knownFlows.insert(flow);
+    rank(flow);
+}
+
+void ProportionalFairScheduler::setModulation(ServiceFlowQueue *flow, modulations modulation)
+{
+    // the rank depends on the datarate, so a backlogged flow has to be re-ranked
+    bool backlogged = ranking.erase(std::make_pair(flow->rank, flow)) > 0;
+    flow->modulation = modulation;
+    if (backlogged)
+        rank(flow);
+}
+
+void ProportionalFairScheduler::rescale()
+{
+    for (std::set<ServiceFlowQueue *>::iterator it = knownFlows.begin(); it != knownFlows.end(); ++it)
+        (*it)->served *= scale;
+    scale = 1;
+
+    std::vector<ServiceFlowQueue *> backlogged;
+    for (Ranking::iterator it = ranking.begin(); it != ranking.end(); ++it)
+        backlogged.push_back(it->second);
+    ranking.clear();
+    for (unsigned int i = 0; i < backlogged.size(); i++)
+        rank(backlogged[i]);
+}
+
+void ProportionalFairScheduler::fillBurst(int capacity, std::vector<Ieee80216GenericMacHeader *>& burst)
+{
+    scale *= 1 - beta;
+    if (scale < 1e-100)
+        rescale();
+
+    while (!ranking.empty())
+    {
+        ServiceFlowQueue *flow = ranking.begin()->second;
+        int bytes = flow->packets.front()->getByteLength();
+        int cost = burstCost(flow, bytes);
+        if (cost > capacity)
+            return;
+
+        capacity -= cost;
+        burst.push_back(flow->packets.front());
+        flow->packets.pop_front();
+
+        ranking.erase(ranking.begin());
+        flow->served += beta * bytes / scale;
+        if (!flow->packets.empty())
+            rank(flow);
+    }
+}
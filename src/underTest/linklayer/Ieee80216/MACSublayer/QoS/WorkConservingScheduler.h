@@ -0,0 +1,130 @@
+#ifndef WorkConservingScheduler_H
+#define WorkConservingScheduler_H
+
+#include <omnetpp.h>
+#include <deque>
+#include <list>
+#include <set>
+#include <vector>
+
+#include "Ieee80216MacHeader_m.h"
+#include "ModulationsConsts.h"
+#include "global_enums.h"
+
+/**
+ * Packets of one service flow (connection), waiting to be scheduled.
+ * The scheduler fields are owned by the WorkConservingScheduler the flow
+ * is registered with.
+ */
+struct ServiceFlowQueue
+{
+    int cid;
+    priorities priority;
+    modulations modulation;
+    std::deque<Ieee80216GenericMacHeader *> packets;
+
+    // deficit round robin
+    int deficit;
+    bool credited;              // quantum of the current round already added
+
+    // proportional fair: average throughput, in units of the scheduler's scale
+    double served;
+    double rank;
+
+    ServiceFlowQueue(int cid, priorities priority)
+        : cid(cid), priority(priority), modulation(MOD_QPSK1),
+          deficit(0), credited(false), served(0), rank(0) {}
+};
+
+/**
+ * Interface of the per-service-flow schedulers of CommonPartSublayerScheduling.
+ *
+ * Schedulers only know the backlogged flows: the module reports a flow
+ * when its first packet is queued, and the scheduler forgets it when it
+ * has sent the last one. Selecting the next packet does not depend on
+ * the number of flows (DRR) or is logarithmic in it (PF).
+ */
+class WorkConservingScheduler
+{
+  public:
+    WorkConservingScheduler();
+    virtual ~WorkConservingScheduler() {}
+
+    /** Called when a packet was queued on a flow that was empty before */
+    virtual void flowBacklogged(ServiceFlowQueue *flow) = 0;
+
+    /**
+     * Takes packets off the backlogged flows until the next one does not
+     * fit into capacity (in bytes at the base modulation) or all flows are
+     * empty, and appends them to burst.
+     */
+    virtual void fillBurst(int capacity, std::vector<Ieee80216GenericMacHeader *>& burst) = 0;
+
+    /** Number of flows with packets */
+    virtual int getNumBacklogged() const = 0;
+
+    /** Changes the modulation a flow is sent with */
+    virtual void setModulation(ServiceFlowQueue *flow, modulations modulation) { flow->modulation = modulation; }
+
+    /** Capacity taken by a packet of the given length on the flow's modulation */
+    int burstCost(const ServiceFlowQueue *flow, int bytes) const
+    {
+        return (bytes * costPerKByte[flow->modulation] + 1023) >> 10;
+    }
+
+  protected:
+    // burst bytes at the base modulation per 1024 bytes sent, per modulation
+    int costPerKByte[NUM_MODULATIONS];
+};
+
+/**
+ * Deficit round robin over the backlogged flows; each flow's quantum is
+ * the weight of its QoS class times the base quantum.
+ */
+class DeficitRoundRobinScheduler : public WorkConservingScheduler
+{
+  public:
+    DeficitRoundRobinScheduler(int quantum, const double weights[5]);
+
+    virtual void flowBacklogged(ServiceFlowQueue *flow);
+    virtual void fillBurst(int capacity, std::vector<Ieee80216GenericMacHeader *>& burst);
+    virtual int getNumBacklogged() const { return activeFlows.size(); }
+
+  protected:
+    int quantum[5];
+    std::list<ServiceFlowQueue *> activeFlows;
+};
+
+/**
+ * Proportional fair: serves the flow with the highest ratio of its
+ * modulation's datarate to its exponentially averaged throughput.
+ *
+ * The averages of all flows decay by the same factor every burst, which
+ * does not change their order; the decay is therefore kept in one scale
+ * factor and only served flows are re-ranked.
+ */
+class ProportionalFairScheduler : public WorkConservingScheduler
+{
+  public:
+    /** timeConstant: averaging window of the throughput, in bursts */
+    ProportionalFairScheduler(double timeConstant);
+
+    virtual void flowBacklogged(ServiceFlowQueue *flow);
+    virtual void fillBurst(int capacity, std::vector<Ieee80216GenericMacHeader *>& burst);
+    virtual int getNumBacklogged() const { return ranking.size(); }
+    virtual void setModulation(ServiceFlowQueue *flow, modulations modulation);
+
+  protected:
+    typedef std::set<std::pair<double, ServiceFlowQueue *> > Ranking;
+    Ranking ranking;
+    double beta;                // weight of the current burst in the average
+    double scale;               // average throughput = served * scale
+
+    // flows not backlogged keep their average, so rescaling needs all of them
+    std::set<ServiceFlowQueue *> knownFlows;
+
+    void rank(ServiceFlowQueue *flow);
+    void rescale();
+};
+
+#endif
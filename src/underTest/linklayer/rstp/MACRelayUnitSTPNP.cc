@@ -407,7 +407,7 @@ void MACRelayUnitSTPNP::flushMACAddressesOnPort(int port_idx)
         {
             EV << "Removing entry from Address Table: " <<
             cur->first << " --> port" << cur->second.portno << "\n";
-            addresstable.erase(cur);
+            removeTableEntry(cur);
         }
     }
 }
@@ -1335,10 +1335,21 @@ bool MACRelayUnitSTPNP::isBPDUAged(BPDU* bpdu)
 
 void MACRelayUnitSTPNP::broadcastFrame(EtherFrame *frame, int inputport)
 {
+    // the last forwarding port gets the original frame, see MACRelayUnitBase
+    int lastPort = -1;
     for (int i=0; i<numPorts; ++i)
+    {
         if (i!=inputport && this->port_status[i].state==FORWARDING)
-            send((EtherFrame*)frame->dup(), "lowerLayerOut", i);
-    delete frame;
+        {
+            if (lastPort>=0)
+                send((EtherFrame*)frame->dup(), "lowerLayerOut", lastPort);
+            lastPort = i;
+        }
+    }
+    if (lastPort>=0)
+        send(frame, "lowerLayerOut", lastPort);
+    else
+        delete frame;
 }
 
 void MACRelayUnitSTPNP::showPriorityVectorInfo()
@@ -0,0 +1,160 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <errno.h>
+#include <string.h>
+#include "PcapWriter.h"
+
+
+PcapWriter::PcapWriter()
+{
+    dumpfile = NULL;
+#ifdef WITH_ZLIB
+    gzdumpfile = NULL;
+#endif
+    buffer = NULL;
+    bufferSize = used = 0;
+    snaplen = 0;
+    network = 0;
+    numRecords = 0;
+}
+
+PcapWriter::~PcapWriter()
+{
+    close();
+}
+
+void PcapWriter::open(const char *filename, unsigned int snaplen, uint32 network,
+                      unsigned int bufferSize, bool compress)
+{
+    close();
+
+    if (compress)
+    {
+#ifdef WITH_ZLIB
+        gzdumpfile = gzopen(filename, "wb");
+        if (!gzdumpfile)
+            opp_error("Cannot open file `%s' for writing", filename);
+#else
+        opp_error("Cannot write compressed pcap file `%s': INET was built without WITH_ZLIB", filename);
+#endif
+    }
+    else
+    {
+        dumpfile = fopen(filename, "wb");
+        if (!dumpfile)
+            opp_error("Cannot open file `%s' for writing: %s", filename, strerror(errno));
+    }
+
+    this->snaplen = snaplen;
+    this->network = network;
+    this->bufferSize = bufferSize;
+    buffer = new unsigned char[bufferSize];
+    used = 0;
+    numRecords = 0;
+
+    struct pcap_hdr fh;
+    fh.magic = PCAP_MAGIC;
+    fh.version_major = 2;
+    fh.version_minor = 4;
+    fh.thiszone = 0;
+    fh.sigfigs = 0;
+    fh.snaplen = snaplen;
+    fh.network = network;
+    writeOut(&fh, sizeof(fh));
+}
+
+void PcapWriter::writeOut(const void *data, unsigned int length)
+{
+#ifdef WITH_ZLIB
+    if (gzdumpfile)
+    {
+        if (gzwrite(gzdumpfile, data, length) != (int)length)
+            opp_error("Error writing compressed pcap file");
+        return;
+    }
+#endif
+    if (fwrite(data, 1, length, dumpfile) != length)
+        opp_error("Error writing pcap file: %s", strerror(errno));
+}
+
+void PcapWriter::writeRecord(simtime_t stime, const void *linkHeader, unsigned int linkHeaderLength,
+                             const unsigned char *packet, unsigned int packetLength)
+{
+    ASSERT(isOpen());
+
+    struct pcaprec_hdr ph;
+    ph.ts_sec = (int32)stime.dbl();
+    ph.ts_usec = (uint32)((stime.dbl() - ph.ts_sec)*1000000);
+    ph.orig_len = linkHeaderLength + packetLength;
+    ph.incl_len = ph.orig_len < snaplen ? ph.orig_len : snaplen;
+
+    unsigned int recordLength = sizeof(ph) + ph.incl_len;
+    if (used + recordLength > bufferSize)
+        flush();
+
+    if (recordLength > bufferSize)
+    {
+        // does not fit even into the empty buffer: write it directly
+        writeOut(&ph, sizeof(ph));
+        unsigned int headerBytes = linkHeaderLength < ph.incl_len ? linkHeaderLength : ph.incl_len;
+        writeOut(linkHeader, headerBytes);
+        writeOut(packet, ph.incl_len - headerBytes);
+    }
+    else
+    {
+        unsigned char *p = buffer + used;
+        memcpy(p, &ph, sizeof(ph));
+        p += sizeof(ph);
+        unsigned int headerBytes = linkHeaderLength < ph.incl_len ? linkHeaderLength : ph.incl_len;
+        memcpy(p, linkHeader, headerBytes);
+        memcpy(p + headerBytes, packet, ph.incl_len - headerBytes);
+        used += recordLength;
+    }
+    numRecords++;
+}
+
+void PcapWriter::flush()
+{
+    if (used > 0)
+    {
+        writeOut(buffer, used);
+        used = 0;
+    }
+}
+
+void PcapWriter::close()
+{
+    if (!isOpen())
+        return;
+
+    flush();
+#ifdef WITH_ZLIB
+    if (gzdumpfile)
+    {
+        gzclose(gzdumpfile);
+        gzdumpfile = NULL;
+    }
+#endif
+    if (dumpfile)
+    {
+        fclose(dumpfile);
+        dumpfile = NULL;
+    }
+    delete [] buffer;
+    buffer = NULL;
+    bufferSize = used = 0;
+}
+
@@ -0,0 +1,110 @@
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program; if not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef __INET_PCAPWRITER_H
+#define __INET_PCAPWRITER_H
+
+#include <stdio.h>
+#include <omnetpp.h>
+#include "INETDefs.h"
+
+#ifdef WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#define PCAP_MAGIC           0xa1b2c3d4
+
+/* "libpcap" file header (minus magic number). */
+struct pcap_hdr {
+     uint32 magic;      /* magic */
+     uint16 version_major;   /* major version number */
+     uint16 version_minor;   /* minor version number */
+     uint32 thiszone;   /* GMT to local correction */
+     uint32 sigfigs;        /* accuracy of timestamps */
+     uint32 snaplen;        /* max length of captured packets, in octets */
+     uint32 network;        /* data link type */
+};
+
+/* "libpcap" record header. */
+struct pcaprec_hdr {
+     int32  ts_sec;     /* timestamp seconds */
+     uint32 ts_usec;        /* timestamp microseconds */
+     uint32 incl_len;   /* number of octets of packet saved in file */
+     uint32 orig_len;   /* actual length of packet */
+};
+
+/**
+ * Writes a libpcap capture file. Records are collected in a large buffer
+ * that is written out in one piece when it is full, instead of issuing
+ * several small writes per packet. Packets longer than the snap length
+ * are truncated in the file, with their original length kept in the
+ * record header.
+ *
+ * If INET was built with WITH_ZLIB, the file can be written gzip
+ * compressed; tcpdump and wireshark read such files directly.
+ */
+class INET_API PcapWriter
+{
+  protected:
+    FILE *dumpfile;
+#ifdef WITH_ZLIB
+    gzFile gzdumpfile;
+#endif
+    unsigned char *buffer;
+    unsigned int bufferSize;
+    unsigned int used;
+    unsigned int snaplen;
+    uint32 network;
+    unsigned long numRecords;
+
+    void writeOut(const void *data, unsigned int length);
+
+  public:
+    PcapWriter();
+    ~PcapWriter();
+
+    /**
+     * Creates the file and writes the pcap file header. bufferSize is the
+     * number of bytes collected before writing; compress needs WITH_ZLIB.
+     */
+    void open(const char *filename, unsigned int snaplen, uint32 network,
+              unsigned int bufferSize, bool compress);
+
+    bool isOpen() const {
+#ifdef WITH_ZLIB
+        if (gzdumpfile)
+            return true;
+#endif
+        return dumpfile != NULL;
+    }
+
+    /**
+     * Appends a record with the given link layer header and packet bytes,
+     * timestamped with stime.
+     */
+    void writeRecord(simtime_t stime, const void *linkHeader, unsigned int linkHeaderLength,
+                     const unsigned char *packet, unsigned int packetLength);
+
+    /** Writes the buffered records to the file */
+    void flush();
+
+    /** Flushes and closes the file; does nothing if it is not open */
+    void close();
+
+    unsigned long getNumRecords() const {return numRecords;}
+};
+
+#endif
+
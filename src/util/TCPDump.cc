@@ -57,7 +57,10 @@ void TCPDumper::ipDump(const char *label, IPDatagram *dgram, const char *comment
           sctpDump(label, sctpmsg, dgram->getSrcAddress().str(), dgram->getDestAddress().str(), comment);
      }
      else
-          delete dgram;
+     {
+          // e.g. a non-first fragment; the datagram is still forwarded by the caller
+          tcpDump(true, label, dgram, comment);
+     }
 }
 
 void TCPDumper::sctpDump(const char *label, SCTPMessage *sctpmsg, const std::string& srcAddr, const std::string& destAddr, const char *comment)
@@ -322,6 +325,7 @@ void TCPDumper::sctpDump(const char *label, SCTPMessage *sctpmsg, const std::str
 
 TCPDump::~TCPDump()
 {
+    delete [] serializeBuffer;
 }
 
 const char *TCPDumper::intToChunk(int32 type)
@@ -363,8 +367,8 @@ Define_Module(TCPDump);
 
 TCPDump::TCPDump() : cSimpleModule(), tcpdump(ev.getOStream())
 {
-
-
+    serializeBuffer = NULL;
+    dirtyLength = 0;
 }
 
 void TCPDumper::udpDump(bool l2r, const char *label, IPDatagram *dgram, const char *comment)
@@ -434,8 +438,17 @@ void TCPDumper::tcpDump(bool l2r, const char *label, IPDatagram *dgram, const ch
           sprintf(buf,"[%.3f%s] ", SIMTIME_DBL(simTime()), label);
           out << buf;
 
-          // packet class and name
-          out << "? " << encapmsg->getClassName() << " \"" << encapmsg->getName() << "\"\n";
+          if (encapmsg)
+          {
+               // packet class and name
+               out << "? " << encapmsg->getClassName() << " \"" << encapmsg->getName() << "\"\n";
+          }
+          else
+          {
+               // non-first fragment: no transport header to show
+               out << dgram->getSrcAddress().str() << " > " << dgram->getDestAddress().str() << ": ";
+               out << "IP fragment offset=" << dgram->getFragmentOffset() << " length=" << dgram->getByteLength() << "\n";
+          }
      }
 }
 
@@ -542,38 +555,33 @@ void TCPDumper::tcpDump(bool l2r, const char *label, TCPSegment *tcpseg, const s
 
 void TCPDump::initialize()
 {
-    struct pcap_hdr fh;
     const char* file = this->par("dumpFile");
     snaplen = this->par("snaplen");
+    textDump = par("textDump");
     tcpdump.setVerbosity(par("verbosity"));
 
 
     if (strcmp(file,"")!=0)
     {
-        tcpdump.dumpfile = fopen(file, "wb");
-        if (!tcpdump.dumpfile)
-        {
-            fprintf(stderr, "Cannot open file [%s] for writing: %s\n", file, strerror(errno));
-            exit(-1);
-        }
-
-        fh.magic = PCAP_MAGIC;
-        fh.version_major = 2;
-        fh.version_minor = 4;
-        fh.thiszone = 0;
-        fh.sigfigs = 0;
-        fh.snaplen = snaplen;
-        fh.network = 0;
-        fwrite(&fh, sizeof(fh), 1, tcpdump.dumpfile);
+        int bufferSize = par("bufferSize");
+        if (bufferSize <= 0)
+            error("bufferSize must be positive");
+        // link type 0: BSD loopback, i.e. a 4-byte address family before the IP header
+        pcapWriter.open(file, snaplen, 0, bufferSize, par("compress").boolValue());
+
+        // zeroed once; afterwards only the bytes used by the previous packet
+        serializeBuffer = new unsigned char[MAXBUFLENGTH];
+        memset(serializeBuffer, 0, MAXBUFLENGTH);
+        dirtyLength = 0;
     }
-    else
-        tcpdump.dumpfile = NULL;
 }
 
 void TCPDump::handleMessage(cMessage *msg)
 {
 
-    if (!ev.disable_tracing)
+    // the text format goes through std::ostream for every field, which
+    // costs far more than the pcap output; skip it when nobody reads it
+    if (textDump && !ev.disable_tracing)
     {
         bool l2r;
 
@@ -655,31 +663,18 @@ void TCPDump::handleMessage(cMessage *msg)
     }
 
 
-    if (tcpdump.dumpfile!=NULL && dynamic_cast<IPDatagram *>(msg))
+    if (pcapWriter.isOpen() && dynamic_cast<IPDatagram *>(msg))
     {
-        uint8 buf[MAXBUFLENGTH];
-        memset((void*)&buf, 0, sizeof(buf));
+        // serializers leave payload bytes untouched, so clear what the
+        // previous packet wrote to keep the dump reproducible
+        memset(serializeBuffer, 0, dirtyLength);
 
-        const simtime_t stime = simulation.getSimTime();
-        // Write PCap header
-
-        struct pcaprec_hdr ph;
-        ph.ts_sec = (int32)stime.dbl();
-        ph.ts_usec = (uint32)((stime.dbl() - ph.ts_sec)*1000000);
-         // Write Ethernet header
         uint32 hdr = 2; //AF_INET
-                     //We do not want this to end in an error if EtherAutoconf messages
         IPDatagram *ipPacket = check_and_cast<IPDatagram *>(msg);
-        // IP header:
-        //struct sockaddr_in *to = (struct sockaddr_in*) malloc(sizeof(struct sockaddr_in));
-        //int32 tosize = sizeof(struct sockaddr_in);
-        int32 serialized_ip = IPSerializer().serialize(ipPacket, buf, sizeof(buf));
-        ph.incl_len = serialized_ip + sizeof(uint32);
-
-        ph.orig_len = ph.incl_len;
-        fwrite(&ph, sizeof(ph), 1, tcpdump.dumpfile);
-        fwrite(&hdr, sizeof(uint32), 1, tcpdump.dumpfile);
-        fwrite(buf, serialized_ip, 1, tcpdump.dumpfile);
+        int32 serialized_ip = IPSerializer().serialize(ipPacket, serializeBuffer, MAXBUFLENGTH);
+        dirtyLength = serialized_ip;
+
+        pcapWriter.writeRecord(simulation.getSimTime(), &hdr, sizeof(uint32), serializeBuffer, serialized_ip);
     }
 
 
@@ -696,8 +691,8 @@ void TCPDump::handleMessage(cMessage *msg)
 
 void TCPDump::finish()
 {
-     tcpdump.dump("", "tcpdump finished");
-     if (strcmp(this->par("dumpFile"),"")!=0)
-          fclose(tcpdump.dumpfile);
+     if (textDump)
+         tcpdump.dump("", "tcpdump finished");
+     pcapWriter.close();
 }
 
@@ -79,7 +79,15 @@ int IPSerializer::serialize(const IPDatagram *dgram, unsigned char *buf, unsigne
 #else
     cMessage *encapPacket = dgram->getEncapsulatedMsg();
 #endif
-    switch (dgram->getTransportProtocol())
+    if (!encapPacket)
+    {
+        // fragment other than the first one: it carries no transport packet
+        // (see IP::fragmentAndSend()), so its payload bytes are left as they are
+        packetLength = dgram->getByteLength();
+        if ((unsigned int)packetLength > bufsize)
+            packetLength = bufsize;
+    }
+    else switch (dgram->getTransportProtocol())
     {
       case IP_PROT_ICMP:
         packetLength += ICMPSerializer().serialize(check_and_cast<ICMPMessage *>(encapPacket),
@@ -41,10 +41,16 @@ std::ostream& operator<<(std::ostream& os, const ChannelControl::TransmissionLis
 
 ChannelControl::ChannelControl()
 {
+    rangeCrossingTimer = NULL;
+    rangeCrossingTolerance = 0;
+    verificationTimer = NULL;
 }
 
 ChannelControl::~ChannelControl()
 {
+    cancelAndDelete(rangeCrossingTimer);
+    cancelAndDelete(verificationTimer);
+
     for (unsigned int i = 0; i < transmissions.size(); i++)
         for (TransmissionList::iterator it = transmissions[i].begin(); it != transmissions[i].end(); it++)
             delete *it;
@@ -80,6 +86,21 @@ void ChannelControl::initialize()
 
     lastOngoingTransmissionsUpdate = 0;
 
+    // converted to simtime_t first, so values below the time resolution are rejected too
+    rangeCrossingTolerance = par("rangeCrossingTolerance").doubleValue();
+    if (rangeCrossingTolerance <= 0)
+        error("rangeCrossingTolerance must be positive and not below the simulation time resolution");
+
+    verificationInterval = par("verificationInterval").doubleValue();
+    verificationTolerance = par("verificationTolerance");
+    if (verificationInterval < 0)
+        error("verificationInterval must not be negative");
+    if (verificationInterval > 0)
+    {
+        verificationTimer = new cMessage("verification");
+        scheduleAt(simTime() + verificationInterval, verificationTimer);
+    }
+
     maxInterferenceDistance = calcInterfDist();
 
     WATCH(maxInterferenceDistance);
@@ -89,6 +110,19 @@ void ChannelControl::initialize()
     updateDisplayString(getParentModule());
 }
 
+void ChannelControl::handleMessage(cMessage *msg)
+{
+    if (msg == rangeCrossingTimer)
+        processRangeCrossings();
+    else if (msg == verificationTimer)
+    {
+        verifyConnections();
+        scheduleAt(simTime() + verificationInterval, verificationTimer);
+    }
+    else
+        error("unexpected message %s", msg->getName());
+}
+
 /**
  * Sets up background size by adding the following tags:
  * "p=0,0;b=$playgroundSizeX,$playgroundSizeY"
@@ -170,6 +204,13 @@ void ChannelControl::unregisterHost(cModule *host)
                 h->isNeighborListValid = false;
             }
 
+            // drop predicted range crossings that refer to this host
+            for (std::map<HostRef, RangeCrossingQueue::iterator>::iterator i = h->crossings.begin(); i != h->crossings.end(); ++i)
+            {
+                rangeCrossings.erase(i->second);
+                i->first->crossings.erase(h);
+            }
+
             // erase host from registered hosts
             hosts.erase(it);
             return;
@@ -202,7 +243,7 @@ const ChannelControl::HostRefVector& ChannelControl::getNeighbors(HostRef h)
 
 void ChannelControl::updateConnections(HostRef h)
 {
-    Coord& hpos = h->pos;
+    const Coord& hpos = getHostPosition(h);
     double maxDistSquared = maxInterferenceDistance * maxInterferenceDistance;
     for (HostList::iterator it = hosts.begin(); it != hosts.end(); ++it)
     {
@@ -212,27 +253,174 @@ void ChannelControl::updateConnections(HostRef h)
 
         // get the distance between the two hosts.
         // (omitting the square root (calling sqrdist() instead of distance()) saves about 5% CPU)
-        bool inRange = hpos.sqrdist(hi->pos) < maxDistSquared;
+        bool inRange = hpos.sqrdist(getHostPosition(hi)) < maxDistSquared;
+        setInRange(h, hi, inRange);
+
+        // earlier predictions for the pair are void; if either of them
+        // moves analytically, predict when this changes
+        cancelRangeCrossing(h, hi);
+        if (h->isMoving || hi->isMoving)
+            predictRangeCrossing(h, hi, inRange);
+    }
+}
 
-        if (inRange)
+void ChannelControl::setInRange(HostRef h1, HostRef h2, bool inRange)
+{
+    if (inRange)
+    {
+        // nodes within communication range: connect
+        if (h1->neighbors.insert(h2).second == true)
         {
-            // nodes within communication range: connect
-            if (h->neighbors.insert(hi).second == true)
-            {
-                hi->neighbors.insert(h);
-                h->isNeighborListValid = hi->isNeighborListValid = false;
-            }
+            h2->neighbors.insert(h1);
+            h1->isNeighborListValid = h2->isNeighborListValid = false;
+        }
+    }
+    else
+    {
+        // out of range: disconnect
+        if (h1->neighbors.erase(h2))
+        {
+            h2->neighbors.erase(h1);
+            h1->isNeighborListValid = h2->isNeighborListValid = false;
         }
+    }
+}
+
+void ChannelControl::predictRangeCrossing(HostRef h1, HostRef h2, bool inRange)
+{
+    // Relative motion of h2 as seen from h1 is linear until either of them
+    // changes motion, so the squared distance is a quadratic function of
+    // time: |p + v*t|^2 = R^2 gives the times t1 <= t2 (relative to now)
+    // between which they are in range.
+    simtime_t now = simTime();
+    simtime_t until = MAXTIME;
+    Coord v(0, 0);
+    if (h1->isMoving && h1->motionEnd > now)
+    {
+        v -= h1->speed;
+        until = h1->motionEnd;
+    }
+    if (h2->isMoving && h2->motionEnd > now)
+    {
+        v += h2->speed;
+        until = std::min(until, h2->motionEnd);
+    }
+    double a = v.x*v.x + v.y*v.y;
+    if (a == 0)
+        return; // distance does not change
+
+    Coord p = getHostPosition(h2) - getHostPosition(h1);
+    double b = 2 * (p.x*v.x + p.y*v.y);
+    double c = p.x*p.x + p.y*p.y - maxInterferenceDistance*maxInterferenceDistance;
+    double disc = b*b - 4*a*c;
+
+    // Crossings are predicted at least rangeCrossingTolerance ahead. Right
+    // at the range boundary rounding may put a pair that has just left
+    // the range back inside it (or vice versa); a crossing predicted at
+    // the current time would then be followed by the opposite one at the
+    // current time again, and simulation time would never advance.
+    double tmin = SIMTIME_DBL(rangeCrossingTolerance);
+    double t;
+    if (inRange)
+    {
+        // next event is leaving the range; as soon as possible if the
+        // numbers say they are (just) outside
+        if (disc <= 0)
+            t = tmin;
         else
+            t = std::max(tmin, (-b + sqrt(disc)) / (2*a));
+    }
+    else
+    {
+        if (disc <= 0)
+            return; // they never get close enough
+        double t2 = (-b + sqrt(disc)) / (2*a);
+        if (t2 <= tmin)
+            return; // moving away from each other, or only grazing the range
+        t = std::max(tmin, (-b - sqrt(disc)) / (2*a));
+    }
+
+    // clamp again after the conversion to simtime_t, which may round down
+    simtime_t when = std::max(now + t, now + rangeCrossingTolerance);
+    if (when >= until)
+        return; // motion changes first; we'll predict again then
+
+    RangeCrossing crossing;
+    crossing.host1 = h1;
+    crossing.host2 = h2;
+    crossing.inRange = !inRange;
+    RangeCrossingQueue::iterator it = rangeCrossings.insert(std::make_pair(when, crossing));
+    h1->crossings[h2] = it;
+    h2->crossings[h1] = it;
+}
+
+void ChannelControl::cancelRangeCrossing(HostRef h1, HostRef h2)
+{
+    std::map<HostRef, RangeCrossingQueue::iterator>::iterator it = h1->crossings.find(h2);
+    if (it == h1->crossings.end())
+        return;
+    rangeCrossings.erase(it->second);
+    h1->crossings.erase(it);
+    h2->crossings.erase(h1);
+}
+
+void ChannelControl::processRangeCrossings()
+{
+    simtime_t now = simTime();
+    while (!rangeCrossings.empty() && rangeCrossings.begin()->first <= now)
+    {
+        RangeCrossing crossing = rangeCrossings.begin()->second;
+        rangeCrossings.erase(rangeCrossings.begin());
+        crossing.host1->crossings.erase(crossing.host2);
+        crossing.host2->crossings.erase(crossing.host1);
+
+        coreEV << crossing.host1->host->getFullPath() << " and " << crossing.host2->host->getFullPath()
+               << (crossing.inRange ? " enter" : " leave") << " each other's range\n";
+        setInRange(crossing.host1, crossing.host2, crossing.inRange);
+        predictRangeCrossing(crossing.host1, crossing.host2, crossing.inRange);
+    }
+    scheduleRangeCrossingTimer();
+}
+
+void ChannelControl::scheduleRangeCrossingTimer()
+{
+    if (rangeCrossings.empty())
+        return;
+    if (!rangeCrossingTimer)
+        rangeCrossingTimer = new cMessage("rangeCrossing");
+
+    simtime_t t = rangeCrossings.begin()->first;
+    if (rangeCrossingTimer->isScheduled())
+    {
+        if (rangeCrossingTimer->getArrivalTime() <= t)
+            return;
+        cancelEvent(rangeCrossingTimer);
+    }
+    scheduleAt(t, rangeCrossingTimer);
+}
+
+void ChannelControl::verifyConnections()
+{
+    // Crossings are applied up to rangeCrossingTolerance late, and ones
+    // due right now may still be waiting in the event queue, so pairs
+    // near the range boundary may legitimately disagree.
+    for (HostList::iterator i1 = hosts.begin(); i1 != hosts.end(); ++i1)
+    {
+        HostRef h1 = &*i1;
+        HostList::iterator i2 = i1;
+        for (++i2; i2 != hosts.end(); ++i2)
         {
-            // out of range: disconnect
-            if (h->neighbors.erase(hi))
-            {
-                hi->neighbors.erase(h);
-                h->isNeighborListValid = hi->isNeighborListValid = false;
-            }
+            HostRef h2 = &*i2;
+            double distance = getHostPosition(h1).distance(getHostPosition(h2));
+            bool inRange = distance < maxInterferenceDistance;
+            if (inRange != (h1->neighbors.count(h2) != 0)
+                && fabs(distance - maxInterferenceDistance) > verificationTolerance)
+                error("verification failed: %s and %s are %g m apart (range: %g m) but are %s",
+                      h1->host->getFullPath().c_str(), h2->host->getFullPath().c_str(),
+                      distance, maxInterferenceDistance, inRange ? "not neighbors" : "neighbors");
         }
     }
+    coreEV << "verified connectivity of " << hosts.size() << " hosts\n";
 }
 
 void ChannelControl::checkChannel(const int channel)
@@ -245,7 +433,21 @@ void ChannelControl::updateHostPosition(HostRef h, const Coord& pos)
 {
     Enter_Method_Silent();
     h->pos = pos;
+    h->isMoving = false;
+    updateConnections(h);
+    scheduleRangeCrossingTimer();
+}
+
+void ChannelControl::updateHostMotion(HostRef h, const Coord& pos, const Coord& speed, simtime_t until)
+{
+    Enter_Method_Silent();
+    h->pos = h->startPos = pos;
+    h->speed = speed;
+    h->startTime = simTime();
+    h->motionEnd = until;
+    h->isMoving = (speed.x != 0 || speed.y != 0) && until > simTime();
     updateConnections(h);
+    scheduleRangeCrossingTimer();
 }
 
 void ChannelControl::updateHostChannel(HostRef h, const int channel)
@@ -326,7 +528,7 @@ void ChannelControl::sendToChannel(cSimpleModule *srcRadioMod, HostRef srcHost,
             coreEV << "sending message to host listening on the same channel\n";
             // account for propagation delay, based on distance in meters
             // Over 300m, dt=1us=10 bit times @ 10Mbps
-            simtime_t delay = srcHost->pos.distance(h->pos) / LIGHT_SPEED;
+            simtime_t delay = getHostPosition(srcHost).distance(getHostPosition(h)) / LIGHT_SPEED;
             srcRadioMod->sendDirect(airFrame->dup(), delay, airFrame->getDuration(), h->radioInGate);
         }
         else
@@ -18,8 +18,10 @@
 #define CHANNELCONTROL_H
 
 #include <vector>
+#include <algorithm>
 #include <list>
 #include <deque>
+#include <map>
 #include <set>
 #include <omnetpp.h>
 #include "AirFrame_m.h"
@@ -47,6 +49,26 @@ class INET_API ChannelControl : public cSimpleModule
     typedef std::list<AirFrame*> TransmissionList;
 
   protected:
+    /**
+     * Predicted time when two hosts, at least one of them moving, enter
+     * or leave each other's interference range. There is at most one
+     * pending crossing per pair; it is dropped whenever either host's
+     * position or motion is updated.
+     */
+    struct RangeCrossing {
+        HostRef host1, host2;
+        bool inRange; // whether they are in range after the crossing
+    };
+    typedef std::multimap<simtime_t, RangeCrossing> RangeCrossingQueue;
+    RangeCrossingQueue rangeCrossings;
+    cMessage *rangeCrossingTimer;
+    simtime_t rangeCrossingTolerance; // crossings are predicted at least this far ahead
+
+    // periodic check of the predicted connectivity against the host distances
+    cMessage *verificationTimer;
+    simtime_t verificationInterval;
+    double verificationTolerance; // m; mismatches this close to the range boundary are accepted
+
     /**
      * Keeps track of hosts/NICs, their positions and channels;
      * also caches neighbor info (which other hosts are within
@@ -56,13 +78,23 @@ class INET_API ChannelControl : public cSimpleModule
         cModule *host;
         cGate *radioInGate;
         int channel;
-        Coord pos; // cached
+        Coord pos; // cached; for moving hosts, refreshed by getHostPosition()
         std::set<HostRef> neighbors; // cached neighbour list
 
         // we cache neighbors set in an std::vector, because std::set iteration is slow;
         // std::vector is created and updated on demand
         bool isNeighborListValid;
         HostRefVector neighborList;
+
+        // linear motion announced via updateHostMotion(): the host is at
+        // startPos at startTime, and moves with the given speed until motionEnd
+        bool isMoving;
+        Coord startPos;
+        Coord speed;
+        simtime_t startTime;
+        simtime_t motionEnd;
+        std::map<HostRef, RangeCrossingQueue::iterator> crossings; // pending crossing with each host
+        HostEntry() {isMoving = false;}
         virtual bool getIsModuleListValid(){return isNeighborListValid;}
     };
     HostList hosts;
@@ -95,6 +127,27 @@ class INET_API ChannelControl : public cSimpleModule
   protected:
     virtual void updateConnections(HostRef h);
 
+    /** @brief Connects or disconnects the two hosts */
+    virtual void setInRange(HostRef h1, HostRef h2, bool inRange);
+
+    /** @brief Predicts when h1 and h2 next enter/leave each other's range, and queues it */
+    virtual void predictRangeCrossing(HostRef h1, HostRef h2, bool inRange);
+
+    /** @brief Drops the pending range crossing of h1 and h2, if any */
+    virtual void cancelRangeCrossing(HostRef h1, HostRef h2);
+
+    /** @brief Applies the range crossings that are due, and reschedules rangeCrossingTimer */
+    virtual void processRangeCrossings();
+    virtual void scheduleRangeCrossingTimer();
+
+    /**
+     * @brief Checks every pair of hosts the way position polling would, i.e.
+     * by their current distance, against the cached neighbor sets, and
+     * throws an error if they disagree farther than verificationTolerance
+     * from the range boundary
+     */
+    virtual void verifyConnections();
+
     /** @brief Calculate interference distance*/
     virtual double calcInterfDist();
 
@@ -104,6 +157,9 @@ class INET_API ChannelControl : public cSimpleModule
     /** @brief Reads init parameters and calculates a maximal interference distance*/
     virtual void initialize();
 
+    /** @brief Handles the range crossing and verification timers */
+    virtual void handleMessage(cMessage *msg);
+
     /** @brief Throws away expired transmissions. */
     virtual void purgeOngoingTransmissions();
 
@@ -138,6 +194,15 @@ class INET_API ChannelControl : public cSimpleModule
     /** @brief To be called when the host moved; updates proximity info */
     virtual void updateHostPosition(HostRef h, const Coord& pos);
 
+    /**
+     * @brief Analytic alternative to periodic updateHostPosition() calls:
+     * the host is at pos now, and moves with constant speed (m/s) until the
+     * given time. Until then, its position is computed on demand, and
+     * connectivity only changes at the predicted times when it enters or
+     * leaves the range of another host.
+     */
+    virtual void updateHostMotion(HostRef h, const Coord& pos, const Coord& speed, simtime_t until);
+
     /** @brief Called when host switches channel */
     virtual void updateHostChannel(HostRef h, const int channel);
 
@@ -148,7 +213,11 @@ class INET_API ChannelControl : public cSimpleModule
     virtual void addOngoingTransmission(HostRef h, AirFrame *frame);
 
     /** @brief Returns the host's position */
-    const Coord& getHostPosition(HostRef h)  {return h->pos;}
+    const Coord& getHostPosition(HostRef h)  {
+        if (h->isMoving)
+            h->pos = h->startPos + h->speed * SIMTIME_DBL(std::min(simTime(), h->motionEnd) - h->startTime);
+        return h->pos;
+    }
 
     /** @brief Get the list of modules in range of the given host */
     const HostRefVector& getNeighbors(HostRef h);
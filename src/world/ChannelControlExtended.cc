@@ -494,6 +494,13 @@ void ChannelControlExtended::updateConnections(HostRef aux)
 }
 
 
+void ChannelControlExtended::updateHostMotion(HostRef h, const Coord& pos, const Coord& speed, simtime_t until)
+{
+    Enter_Method_Silent();
+    error("analytic mobility (updateInterval=0) is not supported with ChannelControlExtended, "
+          "host %s", h->host->getFullPath().c_str());
+}
+
 void ChannelControlExtended::updateHostChannel(HostRef h, const int channel)
 {
     Enter_Method_Silent();
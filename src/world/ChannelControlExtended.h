@@ -161,6 +161,9 @@ class INET_API ChannelControlExtended : public ChannelControl
     virtual void updateHostChannel(HostRef h, const int channel,cModule* ca,double);
     virtual void updateHostChannel(HostRef h, const int channel);
 
+    /** @brief Analytic motion is not supported with multiple radios; use a nonzero updateInterval */
+    virtual void updateHostMotion(HostRef h, const Coord& pos, const Coord& speed, simtime_t until);
+
     /** JcM Add: Get a host reference by its radio **/
     cModule* getHostByRadio(AbstractRadio* r);
 
@@ -62,6 +62,8 @@ void TraCIScenarioManager::initialize(int stage) {
 	port = par("port");
 	autoShutdown = par("autoShutdown");
 	margin = par("margin");
+	coalesceCommands = par("coalesceCommands");
+	std::string traceFile_s = par("traceFile").stdstringValue();
 	std::string roiRoads_s = par("roiRoads");
 	std::string roiRects_s = par("roiRects");
 
@@ -95,6 +97,18 @@ void TraCIScenarioManager::initialize(int stage) {
 	activeVehicleCount = 0;
 	autoShutdownTriggered = false;
 
+	pendingCommands.clear();
+	pendingCommandIds.clear();
+	receiveBuffer.resize(65536);
+	numRoundTrips = 0;
+	numCommands = 0;
+
+	if (!traceFile_s.empty()) {
+		traceFile.open(traceFile_s.c_str());
+		if (!traceFile) error("Could not open trace file \"%s\"", traceFile_s.c_str());
+		traceFile.precision(12);
+	}
+
 	executeOneTimestepTrigger = new cMessage("step");
 	scheduleAt(0, executeOneTimestepTrigger);
 
@@ -130,12 +144,13 @@ std::string TraCIScenarioManager::receiveTraCIMessage() {
 	}
 
 	uint32_t bufLength = msgLength - sizeof(msgLength);
-	char buf[bufLength];
+	if (receiveBuffer.size() < bufLength) receiveBuffer.resize(bufLength);
+	char* buf = &receiveBuffer[0];
 	{
 		MYDEBUG << "Reading TraCI message of " << bufLength << " bytes" << endl;
 		uint32_t bytesRead = 0;
 		while (bytesRead < bufLength) {
-			int receivedBytes = ::recv(MYSOCKET, reinterpret_cast<char*>(&buf) + bytesRead, bufLength - bytesRead, 0);
+			int receivedBytes = ::recv(MYSOCKET, buf + bytesRead, bufLength - bytesRead, 0);
 			if (receivedBytes > 0) {
 				bytesRead += receivedBytes;
 			} else {
@@ -151,19 +166,13 @@ std::string TraCIScenarioManager::receiveTraCIMessage() {
 void TraCIScenarioManager::sendTraCIMessage(std::string buf) {
 	if (!socketPtr) error("Connection to TraCI server lost");
 
-	{
-		uint32_t msgLength = sizeof(uint32_t) + buf.length();
-		TraCIBuffer buf2 = TraCIBuffer();
-		buf2 << msgLength;
-		size_t sentBytes = ::send(MYSOCKET, buf2.str().c_str(), sizeof(uint32_t), 0);
-		if (sentBytes != sizeof(uint32_t)) error("Could not write %d bytes to TraCI server, sent only %d: %s", sizeof(uint32_t), sentBytes, strerror(errno));
-	}
+	// send header and message in a single segment
+	uint32_t msgLength = sizeof(uint32_t) + buf.length();
+	std::string msg = (TraCIBuffer() << msgLength).str() + buf;
 
-	{
-		MYDEBUG << "Writing TraCI message of " << buf.length() << " bytes" << endl;
-		size_t sentBytes = ::send(MYSOCKET, buf.c_str(), buf.length(), 0);
-		if (sentBytes != buf.length()) error("Could not write %d bytes to TraCI server, sent only %d: %s", buf.length(), sentBytes, strerror(errno));
-	}
+	MYDEBUG << "Writing TraCI message of " << buf.length() << " bytes" << endl;
+	size_t sentBytes = ::send(MYSOCKET, msg.c_str(), msg.length(), 0);
+	if (sentBytes != msg.length()) error("Could not write %d bytes to TraCI server, sent only %d: %s", msg.length(), sentBytes, strerror(errno));
 }
 
 std::string TraCIScenarioManager::makeTraCICommand(uint8_t commandId, TraCIBuffer buf) {
@@ -175,10 +184,24 @@ std::string TraCIScenarioManager::makeTraCICommand(uint8_t commandId, TraCIBuffe
 	return (TraCIBuffer() << len << commandId).str() + buf.str();
 }
 
-TraCIScenarioManager::TraCIBuffer TraCIScenarioManager::queryTraCI(uint8_t commandId, const TraCIBuffer& buf) {
-	sendTraCIMessage(makeTraCICommand(commandId, buf));
+TraCIScenarioManager::TraCIBuffer TraCIScenarioManager::exchangeTraCIMessage(const std::string& commands) {
+	std::string msg;
+	msg.swap(pendingCommands);
+	msg += commands;
+	std::list<uint8_t> heldBackIds;
+	heldBackIds.swap(pendingCommandIds);
+
+	sendTraCIMessage(msg);
+	numRoundTrips++;
 
 	TraCIBuffer obuf(receiveTraCIMessage());
+	for (std::list<uint8_t>::const_iterator i = heldBackIds.begin(); i != heldBackIds.end(); ++i) {
+		checkTraCIStatus(obuf, *i);
+	}
+	return obuf;
+}
+
+void TraCIScenarioManager::checkTraCIStatus(TraCIBuffer& obuf, uint8_t commandId) {
 	uint8_t cmdLength; obuf >> cmdLength;
 	uint8_t commandResp; obuf >> commandResp;
 	ASSERT(commandResp == commandId);
@@ -187,13 +210,30 @@ TraCIScenarioManager::TraCIBuffer TraCIScenarioManager::queryTraCI(uint8_t comma
 	if (result == RTYPE_NOTIMPLEMENTED) error("TraCI server reported command 0x%2x not implemented (\"%s\"). Might need newer version.", commandId, description.c_str());
 	if (result == RTYPE_ERR) error("TraCI server reported error executing command 0x%2x (\"%s\").", commandId, description.c_str());
 	ASSERT(result == RTYPE_OK);
+}
+
+TraCIScenarioManager::TraCIBuffer TraCIScenarioManager::queryTraCI(uint8_t commandId, const TraCIBuffer& buf) {
+	numCommands++;
+	TraCIBuffer obuf = exchangeTraCIMessage(makeTraCICommand(commandId, buf));
+	checkTraCIStatus(obuf, commandId);
 	return obuf;
 }
 
-TraCIScenarioManager::TraCIBuffer TraCIScenarioManager::queryTraCIOptional(uint8_t commandId, const TraCIBuffer& buf, bool& success, std::string* errorMsg) {
-	sendTraCIMessage(makeTraCICommand(commandId, buf));
+void TraCIScenarioManager::commandTraCI(uint8_t commandId, const TraCIBuffer& buf) {
+	if (!coalesceCommands) {
+		TraCIBuffer obuf = queryTraCI(commandId, buf);
+		ASSERT(obuf.eof());
+		return;
+	}
 
-	TraCIBuffer obuf(receiveTraCIMessage());
+	numCommands++;
+	pendingCommands += makeTraCICommand(commandId, buf);
+	pendingCommandIds.push_back(commandId);
+}
+
+TraCIScenarioManager::TraCIBuffer TraCIScenarioManager::queryTraCIOptional(uint8_t commandId, const TraCIBuffer& buf, bool& success, std::string* errorMsg) {
+	numCommands++;
+	TraCIBuffer obuf = exchangeTraCIMessage(makeTraCICommand(commandId, buf));
 	uint8_t cmdLength; obuf >> cmdLength;
 	uint8_t commandResp; obuf >> commandResp;
 	ASSERT(commandResp == commandId);
@@ -270,6 +310,7 @@ void TraCIScenarioManager::init_traci() {
 
 		netbounds1 = TraCICoord(x1, y1);
 		netbounds2 = TraCICoord(x2, y2);
+		if (traceFile.is_open()) traceFile << "bounds " << x1 << " " << y1 << " " << x2 << " " << y2 << "\n";
 		MYDEBUG << "TraCI reports network boundaries (" << x1 << ", " << y1 << ")-("<< x2 << ", " << y2 << ")" << endl;
 		if ((traci2omnet(netbounds2).x > cc->getPgs()->x) || (traci2omnet(netbounds1).y > cc->getPgs()->y)) MYDEBUG << "WARNING: Playground size (" << cc->getPgs()->x << ", " << cc->getPgs()->y << ") might be too small for vehicle at network bounds (" << traci2omnet(netbounds2).x << ", " << traci2omnet(netbounds1).y << ")" << endl;
 	}
@@ -308,6 +349,15 @@ void TraCIScenarioManager::finish() {
 		delete executeOneTimestepTrigger;
 		executeOneTimestepTrigger = 0;
 	}
+	if (!pendingCommandIds.empty()) {
+		// the simulation is over, no use in sending them
+		MYDEBUG << "Dropping " << pendingCommandIds.size() << " TraCI commands not sent" << endl;
+		pendingCommands.clear();
+		pendingCommandIds.clear();
+	}
+	recordScalar("TraCI round trips", numRoundTrips);
+	recordScalar("TraCI commands", numCommands);
+	if (traceFile.is_open()) traceFile.close();
 	if (socketPtr) {
 		closesocket(MYSOCKET);
 		delete &MYSOCKET;
@@ -357,15 +407,13 @@ std::pair<uint32_t, std::string> TraCIScenarioManager::commandGetVersion() {
 void TraCIScenarioManager::commandSetSpeedMode(std::string nodeId, int32_t bitset) {
 	uint8_t variableId = VAR_SPEEDSETMODE;
 	uint8_t variableType = TYPE_INTEGER;
-	TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << bitset);
-	ASSERT(buf.eof());
+	commandTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << bitset);
 }
 
 void TraCIScenarioManager::commandSetSpeed(std::string nodeId, double speed) {
 	uint8_t variableId = VAR_SPEED;
 	uint8_t variableType = TYPE_DOUBLE;
-	TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << speed);
-	ASSERT(buf.eof());
+	commandTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << speed);
 }
 
 void TraCIScenarioManager::commandChangeRoute(std::string nodeId, std::string roadId, double travelTime) {
@@ -377,23 +425,20 @@ void TraCIScenarioManager::commandChangeRoute(std::string nodeId, std::string ro
 		std::string edgeId = roadId;
 		uint8_t newTimeT = TYPE_DOUBLE;
 		double newTime = travelTime;
-		TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId << newTimeT << newTime);
-		ASSERT(buf.eof());
+		commandTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId << newTimeT << newTime);
 	} else {
 		uint8_t variableId = VAR_EDGE_TRAVELTIME;
 		uint8_t variableType = TYPE_COMPOUND;
 		int32_t count = 1;
 		uint8_t edgeIdT = TYPE_STRING;
 		std::string edgeId = roadId;
-		TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId);
-		ASSERT(buf.eof());
+		commandTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId);
 	}
 	{
 		uint8_t variableId = CMD_REROUTE_TRAVELTIME;
 		uint8_t variableType = TYPE_COMPOUND;
 		int32_t count = 0;
-		TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count);
-		ASSERT(buf.eof());
+		commandTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count);
 	}
 }
 
@@ -429,18 +474,15 @@ void TraCIScenarioManager::commandStopNode(std::string nodeId, std::string roadI
 	uint8_t durationT = TYPE_INTEGER;
 	uint32_t duration = waittime * 1000;
 
-	TraCIBuffer buf = queryTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId << stopPosT << stopPos << stopLaneT << stopLane << durationT << duration);
-	ASSERT(buf.eof());
+	commandTraCI(CMD_SET_VEHICLE_VARIABLE, TraCIBuffer() << variableId << nodeId << variableType << count << edgeIdT << edgeId << stopPosT << stopPos << stopLaneT << stopLane << durationT << duration);
 }
 
 void TraCIScenarioManager::commandSetTrafficLightProgram(std::string trafficLightId, std::string program) {
-	TraCIBuffer buf = queryTraCI(CMD_SET_TL_VARIABLE, TraCIBuffer() << static_cast<uint8_t>(TL_PROGRAM) << trafficLightId << static_cast<uint8_t>(TYPE_STRING) << program);
-	ASSERT(buf.eof());
+	commandTraCI(CMD_SET_TL_VARIABLE, TraCIBuffer() << static_cast<uint8_t>(TL_PROGRAM) << trafficLightId << static_cast<uint8_t>(TYPE_STRING) << program);
 }
 
 void TraCIScenarioManager::commandSetTrafficLightPhaseIndex(std::string trafficLightId, int32_t index) {
-	TraCIBuffer buf = queryTraCI(CMD_SET_TL_VARIABLE, TraCIBuffer() << static_cast<uint8_t>(TL_PHASE_INDEX) << trafficLightId << static_cast<uint8_t>(TYPE_INTEGER) << index);
-	ASSERT(buf.eof());
+	commandTraCI(CMD_SET_TL_VARIABLE, TraCIBuffer() << static_cast<uint8_t>(TL_PHASE_INDEX) << trafficLightId << static_cast<uint8_t>(TYPE_INTEGER) << index);
 }
 
 std::list<std::string> TraCIScenarioManager::commandGetPolygonIds() {
@@ -539,8 +581,7 @@ void TraCIScenarioManager::commandSetPolygonShape(std::string polyId, std::list<
 		TraCICoord pos = omnet2traci(*i);
 		buf << static_cast<double>(pos.x) << static_cast<double>(pos.y);
 	}
-	TraCIBuffer obuf = queryTraCI(CMD_SET_POLYGON_VARIABLE, buf);
-	ASSERT(obuf.eof());
+	commandTraCI(CMD_SET_POLYGON_VARIABLE, buf);
 }
 
 bool TraCIScenarioManager::commandAddVehicle(std::string vehicleId, std::string vehicleTypeId, std::string routeId, std::string laneId, float emitPosition, float emitSpeed) {
@@ -675,19 +716,30 @@ double TraCIScenarioManager::omnet2traciAngle(double angle) const {
 	return angle;
 }
 
-void TraCIScenarioManager::subscribeToVehicleVariables(std::string vehicleId) {
-	// subscribe to some attributes of the vehicle
+void TraCIScenarioManager::subscribeToVehicleVariables(const std::set<std::string>& vehicleIds) {
+	if (vehicleIds.empty()) return;
+
+	// subscribe to some attributes of the vehicles, sending all subscriptions in one message
 	uint32_t beginTime = 0;
 	uint32_t endTime = 0x7FFFFFFF;
-	std::string objectId = vehicleId;
 	uint8_t variableNumber = 4;
 	uint8_t variable1 = VAR_POSITION;
 	uint8_t variable2 = VAR_ROAD_ID;
 	uint8_t variable3 = VAR_SPEED;
 	uint8_t variable4 = VAR_ANGLE;
 
-	TraCIBuffer buf = queryTraCI(CMD_SUBSCRIBE_VEHICLE_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber << variable1 << variable2 << variable3 << variable4);
-	processSubcriptionResult(buf);
+	std::string commands;
+	for (std::set<std::string>::const_iterator i = vehicleIds.begin(); i != vehicleIds.end(); ++i) {
+		std::string objectId = *i;
+		commands += makeTraCICommand(CMD_SUBSCRIBE_VEHICLE_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber << variable1 << variable2 << variable3 << variable4);
+	}
+	numCommands += vehicleIds.size();
+
+	TraCIBuffer buf = exchangeTraCIMessage(commands);
+	for (size_t i = 0; i < vehicleIds.size(); ++i) {
+		checkTraCIStatus(buf, CMD_SUBSCRIBE_VEHICLE_VARIABLE);
+		processSubcriptionResult(buf);
+	}
 	ASSERT(buf.eof());
 }
 
@@ -698,8 +750,7 @@ void TraCIScenarioManager::unsubscribeFromVehicleVariables(std::string vehicleId
 	std::string objectId = vehicleId;
 	uint8_t variableNumber = 0;
 
-	TraCIBuffer buf = queryTraCI(CMD_SUBSCRIBE_VEHICLE_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber);
-	ASSERT(buf.eof());
+	commandTraCI(CMD_SUBSCRIBE_VEHICLE_VARIABLE, TraCIBuffer() << beginTime << endTime << objectId << variableNumber);
 }
 
 void TraCIScenarioManager::processSimSubscription(std::string objectId, TraCIBuffer& buf) {
@@ -798,10 +849,8 @@ void TraCIScenarioManager::processVehicleSubscription(std::string objectId, TraC
 			// check for vehicles that need subscribing to
 			std::set<std::string> needSubscribe;
 			std::set_difference(drivingVehicles.begin(), drivingVehicles.end(), subscribedVehicles.begin(), subscribedVehicles.end(), std::inserter(needSubscribe, needSubscribe.begin()));
-			for (std::set<std::string>::const_iterator i = needSubscribe.begin(); i != needSubscribe.end(); ++i) {
-				subscribedVehicles.insert(*i);
-				subscribeToVehicleVariables(*i);
-			}
+			subscribedVehicles.insert(needSubscribe.begin(), needSubscribe.end());
+			subscribeToVehicleVariables(needSubscribe);
 
 			// check for vehicles that need unsubscribing from
 			std::set<std::string> needUnsubscribe;
@@ -843,6 +892,8 @@ void TraCIScenarioManager::processVehicleSubscription(std::string objectId, TraC
 	// make sure we got updates for all 4 attributes
 	if (numRead != 4) return;
 
+	if (traceFile.is_open()) recordVehicleUpdate(objectId, px, py, edge, speed, angle_traci);
+
 	Coord p = traci2omnet(TraCICoord(px, py));
 	if ((p.x < 0) || (p.y < 0)) error("received bad node position (%.2f, %.2f), translated to (%.2f, %.2f)", px, py, p.x, p.y);
 
@@ -877,6 +928,10 @@ void TraCIScenarioManager::processVehicleSubscription(std::string objectId, TraC
 
 }
 
+void TraCIScenarioManager::recordVehicleUpdate(std::string vehicleId, double px, double py, std::string edge, double speed, double angle_traci) {
+	traceFile << getCurrentTimeMs() << " " << vehicleId << " " << px << " " << py << " " << edge << " " << speed << " " << angle_traci << "\n";
+}
+
 void TraCIScenarioManager::processSubcriptionResult(TraCIBuffer& buf) {
 	uint8_t cmdLength_resp; buf >> cmdLength_resp;
 	uint32_t cmdLengthExt_resp; buf >> cmdLengthExt_resp;
@@ -893,17 +948,17 @@ void TraCIScenarioManager::processSubcriptionResult(TraCIBuffer& buf) {
 template<> void TraCIScenarioManager::TraCIBuffer::write(std::string inv) {
 	uint32_t length = inv.length();
 	write<uint32_t> (length);
-	for (size_t i = 0; i < length; ++i) write<char> (inv[i]);
+	buf.append(inv);
 }
 
 template<> std::string TraCIScenarioManager::TraCIBuffer::read() {
 	uint32_t length = read<uint32_t> ();
 	if (length == 0) return std::string();
-	char obuf[length + 1];
+	if (buf.length() - buf_index < length) throw cRuntimeError("Attempted to read past end of byte buffer");
 
-	for (size_t i = 0; i < length; ++i) read<char> (obuf[i]);
-	obuf[length] = 0;
+	std::string s = buf.substr(buf_index, length);
+	buf_index += length;
 
-	return std::string(obuf, length);
+	return s;
 }
 
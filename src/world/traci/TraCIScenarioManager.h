@@ -25,7 +25,10 @@
 #include <utility>
 #include <map>
 #include <list>
+#include <set>
+#include <vector>
 #include <sstream>
+#include <fstream>
 #include <iomanip>
 
 #include <omnetpp.h>
@@ -100,15 +103,17 @@ class INET_API TraCIScenarioManager : public cSimpleModule
 					T buf_to_return;
 					unsigned char *p_buf_to_return = reinterpret_cast<unsigned char*>(&buf_to_return);
 
+					if (buf.length() - buf_index < sizeof(buf_to_return)) throw cRuntimeError("Attempted to read past end of byte buffer");
+					const char* p_buf = buf.data() + buf_index;
+					buf_index += sizeof(buf_to_return);
+
 					if (isBigEndian()) {
 						for (size_t i=0; i<sizeof(buf_to_return); ++i) {
-							if (eof()) throw cRuntimeError("Attempted to read past end of byte buffer");
-							p_buf_to_return[i] = buf[buf_index++];
+							p_buf_to_return[i] = p_buf[i];
 						}
 					} else {
 						for (size_t i=0; i<sizeof(buf_to_return); ++i) {
-							if (eof()) throw cRuntimeError("Attempted to read past end of byte buffer");
-							p_buf_to_return[sizeof(buf_to_return)-1-i] = buf[buf_index++];
+							p_buf_to_return[sizeof(buf_to_return)-1-i] = p_buf[i];
 						}
 					}
 
@@ -117,16 +122,19 @@ class INET_API TraCIScenarioManager : public cSimpleModule
 
 				template<typename T> void write(T inv) {
 					unsigned char *p_buf_to_send = reinterpret_cast<unsigned char*>(&inv);
+					char p_buf[sizeof(inv)];
 
 					if (isBigEndian()) {
 						for (size_t i=0; i<sizeof(inv); ++i) {
-							buf += p_buf_to_send[i];
+							p_buf[i] = p_buf_to_send[i];
 						}
 					} else {
 						for (size_t i=0; i<sizeof(inv); ++i) {
-							buf += p_buf_to_send[sizeof(inv)-1-i];
+							p_buf[i] = p_buf_to_send[sizeof(inv)-1-i];
 						}
 					}
+
+					buf.append(p_buf, sizeof(inv));
 				}
 
 				template<typename T> T read(T& out) {
@@ -204,6 +212,14 @@ class INET_API TraCIScenarioManager : public cSimpleModule
 		bool autoShutdownTriggered;
 		cMessage* executeOneTimestepTrigger; /**< self-message scheduled for when to next call executeOneTimestep */
 
+		bool coalesceCommands; /**< whether to hold back commands that return no data until the next query */
+		std::string pendingCommands; /**< commands held back, to be sent along with the next query */
+		std::list<uint8_t> pendingCommandIds; /**< ids of the commands in pendingCommands, in order */
+		std::vector<char> receiveBuffer; /**< reused for all messages received from the TraCI server */
+		std::ofstream traceFile; /**< vehicle updates are recorded here, if open */
+		long numRoundTrips; /**< number of messages sent to the TraCI server */
+		long numCommands; /**< number of commands sent to the TraCI server */
+
 		ChannelControl* cc;
 
 		uint32_t getCurrentTimeMs(); /**< get current simulation time (in ms) */
@@ -228,6 +244,23 @@ class INET_API TraCIScenarioManager : public cSimpleModule
 		 */
 		TraCIBuffer queryTraCI(uint8_t commandId, const TraCIBuffer& buf = TraCIBuffer());
 
+		/**
+		 * sends a command that returns nothing but its status; with coalesceCommands, the command
+		 * is held back and sent in the same message as the next query
+		 */
+		void commandTraCI(uint8_t commandId, const TraCIBuffer& buf);
+
+		/**
+		 * sends the held back commands (if any) followed by the given ones in a single message,
+		 * returns the response with the status responses of the held back commands already consumed
+		 */
+		TraCIBuffer exchangeTraCIMessage(const std::string& commands);
+
+		/**
+		 * reads and checks the status response to a command
+		 */
+		void checkTraCIStatus(TraCIBuffer& obuf, uint8_t commandId);
+
 		/**
 		 * sends a single command via TraCI, expects no reply, returns true if successful
 		 */
@@ -268,8 +301,9 @@ class INET_API TraCIScenarioManager : public cSimpleModule
 		 */
 		double omnet2traciAngle(double angle) const;
 
-		void subscribeToVehicleVariables(std::string vehicleId);
+		void subscribeToVehicleVariables(const std::set<std::string>& vehicleIds);
 		void unsubscribeFromVehicleVariables(std::string vehicleId);
+		void recordVehicleUpdate(std::string vehicleId, double px, double py, std::string edge, double speed, double angle_traci);
 		void processSimSubscription(std::string objectId, TraCIBuffer& buf);
 		void processVehicleSubscription(std::string objectId, TraCIBuffer& buf);
 		void processSubcriptionResult(TraCIBuffer& buf);